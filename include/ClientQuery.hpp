@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "ClientSnapshot.hpp"
+
+/// @brief 地址段（IPv4 或 IPv6）
+struct AddressRange
+{
+  uint8_t family = 0; // 0 表示不限
+  uint8_t addr[16] = {};
+  int prefixLength = 0;
+
+  /// @brief 解析 "10.8.0.0/24"、"2001:db8::/32"，不带前缀时为单个地址
+  static bool parse(const std::string &text, AddressRange &range);
+  bool contains(uint8_t family, const uint8_t addr[16]) const;
+};
+
+enum class ClientSortKey
+{
+  ConnectedSince = 0,
+  Name = 1,
+  BytesReceived = 2,
+  BytesSent = 3,
+  BytesTotal = 4,
+};
+
+/// @brief 在线客户端查询
+/// @note  在快照上按条件筛选后排序，指定 limit 时用 partial_sort 只排出前 K 个（O(n log K)），
+///        结果为快照记录下标，不复制记录。
+struct ClientQuery
+{
+  std::string namePrefix;
+  AddressRange realRange;   // 真实地址段
+  AddressRange vpnRange;    // VPN 地址段
+  uint64_t minBytes = 0;    // 收发字节合计下限
+  int64_t connectedAfter = 0; // 连接时间不早于（epoch 秒）
+  ClientSortKey sortKey = ClientSortKey::ConnectedSince;
+  bool descending = false;
+  size_t limit = 0; // 0 表示不限
+
+  bool matches(const ClientSnapshot &snapshot, const OnlineClient &client) const;
+  std::vector<uint32_t> run(const ClientSnapshot &snapshot) const;
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <cstdint>
+#include <ctime>
+
+/// @brief 在线客户端的紧凑数值记录
+/// @note  地址以二进制保存，连接时间为 epoch 秒，名称与连接时间原文指向快照保留的状态文件内容。
+struct OnlineClient
+{
+  const char *name;      // 不以 '\0' 结尾，长度见 nameLength
+  uint32_t nameLength;
+  uint8_t realFamily;    // 4、6，无法解析时为 0
+  uint8_t hasVpnIpv6;
+  uint16_t realPort;
+  uint8_t realAddr[16];  // 网络字节序，IPv4 占前 4 字节
+  uint32_t vpnIpv4;      // 主机字节序，0 表示未分配
+  uint8_t vpnIpv6[16];   // 网络字节序
+  int64_t connectedSince;
+  const char *since;     // 连接时间原文，供沿用状态文件文本的旧接口；不来自状态文件时为 nullptr
+  uint32_t sinceLength;
+  uint64_t bytesReceived;
+  uint64_t bytesSent;
+};
+
+/// @brief 在线客户端快照
+/// @note  由一个或多个 status.log（分片服务各实例一份）单遍解析得到，同名客户端以后出现者为准，
+///        记录按连接时间升序排列。地址与时间在解析时转换为数值，便于排序、筛选和按列导出。
+///        状态文件内容、记录数组与名称索引都分配在快照自己的单调分配区中，按文件大小预估容量，
+///        名称直接引用文件内容，解析过程中不为单个客户端分配堆内存。
+///        名称索引为开放寻址哈希表（线性探测，装载率不超过 1/2），解析时用于合并同名客户端，
+///        finish() 排序后重建，find 为 O(1)。
+class ClientSnapshot
+{
+public:
+  /// @param arenaHint  分配区首块大小的预估（字节）
+  explicit ClientSnapshot(size_t arenaHint = 0);
+
+  ClientSnapshot(const ClientSnapshot &) = delete;
+  ClientSnapshot &operator=(const ClientSnapshot &) = delete;
+
+  /// @brief 读取并解析状态文件，无法读取的文件跳过
+  static std::shared_ptr<const ClientSnapshot> load(const std::vector<std::string> &statusFiles);
+  /// @brief 解析一个状态文件的内容并合并到快照（内容复制到分配区）
+  void parse(std::string_view text);
+  /// @brief 按连接时间排序并重建名称索引，parse 完成后调用
+  void finish();
+
+  /// @brief 按名称查找，不存在返回 nullptr
+  const OnlineClient *find(std::string_view name) const;
+
+  /// @brief 解析 status 中的连接时间（2.6 的 "YYYY-MM-DD HH:MM:SS" 或旧版 ctime 格式），本地时间
+  static bool parseTime(std::string_view text, int64_t &epoch);
+  /// @brief 解析 "a.b.c.d:port"、"[v6]:port" 或不带端口的地址
+  static bool parseEndpoint(std::string_view text, uint8_t &family, uint8_t addr[16], uint16_t &port);
+
+  size_t size() const { return clients.size(); }
+  const OnlineClient &operator[](size_t i) const { return clients[i]; }
+  const std::pmr::vector<OnlineClient> &records() const { return clients; }
+  static std::string_view name(const OnlineClient &client)
+  {
+    return std::string_view(client.name, client.nameLength);
+  }
+  static std::string_view since(const OnlineClient &client)
+  {
+    return client.since ? std::string_view(client.since, client.sinceLength) : std::string_view();
+  }
+
+  /// @brief 地址、端点与时间的文本形式，写入调用方缓冲区（总以 '\0' 结尾）
+  static void formatAddress(uint8_t family, const uint8_t addr[16], char *buf, size_t size);
+  static void formatEndpoint(const OnlineClient &client, char *buf, size_t size);
+  static void formatTime(int64_t epoch, char *buf, size_t size);
+  static std::string formatEndpoint(const OnlineClient &client);
+  static std::string formatTime(int64_t epoch);
+
+private:
+  void parseBuffer(const char *data, size_t size);
+  uint32_t *slotFor(std::string_view name);
+  void rebuildIndex(size_t capacity);
+
+  std::pmr::monotonic_buffer_resource arena;
+  std::pmr::vector<OnlineClient> clients;
+  std::pmr::vector<uint32_t> slots; // 记录下标 + 1，0 为空槽；容量为 2 的幂
+};
+
+/// @brief 同一服务两个版本快照之间的差异
+/// @note  added、updated 为 snapshot 中的下标，removed 为 base 中的下标；
+///        除名称外任一字段（字节计数、地址、连接时间）变化即视为 updated。
+///        full 为 true 时没有起始快照，added 为 snapshot 的全部记录。
+struct ClientDelta
+{
+  uint64_t version = 0; // snapshot 的版本
+  bool full = false;
+  std::shared_ptr<const ClientSnapshot> snapshot;
+  std::shared_ptr<const ClientSnapshot> base;
+  std::vector<uint32_t> added;
+  std::vector<uint32_t> updated;
+  std::vector<uint32_t> removed;
+
+  /// @brief 由 base 与 snapshot 计算差异，base 为空时为全量
+  void compute();
+};
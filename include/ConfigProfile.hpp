@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ostream>
+
+/// @brief 服务端/客户端配置的性能档案
+/// @note  创建服务时选择，决定协议、套接字缓冲区、队列长度、数据通道加密套件协商列表、
+///        fast-io、压缩策略、保活参数与 MTU。服务端配置首行记录档案名，createClient 据此生成对应的客户端配置。
+struct ConfigProfile
+{
+  std::string name;
+  std::string description;
+  std::string proto;       // udp / tcp
+  int sndbuf;              // 套接字发送缓冲区（字节，0 为系统默认）
+  int rcvbuf;              // 套接字接收缓冲区（字节，0 为系统默认）
+  int txqueuelen;          // TUN 设备发送队列长度（0 为系统默认）
+  bool fastIo;             // 仅 UDP 有效
+  std::string dataCiphers; // AEAD 协商列表，为空时沿用旧版 cipher
+  bool allowCompression;
+  int keepaliveInterval;
+  int keepaliveTimeout;
+  int tunMtu;              // 0 为默认
+  int mssfix;              // 0 为默认
+  bool dco = false;        // 面向 ovpn-dco 渲染：仅 AEAD 套件，无 CBC 回退、无压缩
+
+  static const std::string DEFAULT_NAME;
+  static const std::string MARKER; // 服务端配置中记录档案名的注释前缀，DCO 模式追加 " dco"
+
+  /// @brief 全部内置档案
+  static const std::vector<ConfigProfile> &all();
+  /// @brief 按名称查找，未找到返回 nullptr
+  static const ConfigProfile *find(const std::string &name);
+  /// @brief 从服务端配置内容中读取档案（含 DCO 标记），未记录时返回默认档案
+  static ConfigProfile fromServerConfig(const std::string &configContent);
+  /// @brief 写入服务端配置首行的档案标记
+  std::string marker() const;
+
+  /// @brief 返回适配数据通道卸载的副本
+  ConfigProfile forDco() const;
+
+  /// @brief 输出服务端调优指令（含保活与推送给客户端的缓冲区设置）
+  void renderServer(std::ostream &out) const;
+  /// @brief 输出客户端调优指令
+  void renderClient(std::ostream &out) const;
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief 配置模板
+/// @note  模板文本中的 {{名称}} 为占位符，解析后得到“字面量片段 + 占位符引用”列表。
+///        内置模板在编译期完成解析，运维可在 OVPN_DIR/templates 下放置同名模板覆盖。
+///        渲染时先计算总长度一次性分配输出缓冲区，不产生中间分配。
+namespace tmpl
+{
+  enum class Slot : uint8_t
+  {
+    Marker,     // 档案标记行
+    Port,
+    Proto,
+    Dev,
+    ServiceDir, // 证书与密钥所在目录
+    Network,
+    Netmask,
+    Pool,       // server 指令的地址池选项（" nopool" 或空）
+    RuntimeDir, // ccd、ipp、status 与管理套接字所在目录
+    Tuning,     // 档案生成的调优指令块
+    Remotes,    // 客户端 remote 指令块
+    Ca,
+    Cert,
+    Key,
+    TlsAuth,
+    Crl,        // 服务端 crl-verify 使用的 CRL 文件
+    KeyExchange, // 密钥交换指令块（dh 文件，或算法标记、dh none 与 ecdh-curve / tls-groups）
+    Count,
+    Literal = 0xFE,
+    Invalid = 0xFF,
+  };
+
+  constexpr std::string_view SLOT_NAMES[] = {"marker", "port", "proto", "dev", "service_dir", "network", "netmask",
+                                             "pool", "runtime_dir", "tuning", "remotes", "ca", "cert", "key",
+                                             "tls_auth", "crl", "key_exchange"};
+  static_assert(sizeof(SLOT_NAMES) / sizeof(SLOT_NAMES[0]) == static_cast<size_t>(Slot::Count),
+                "slot names out of sync");
+
+  using SlotValues = std::array<std::string_view, static_cast<size_t>(Slot::Count)>;
+
+  struct Segment
+  {
+    uint32_t offset; // 字面量在模板文本中的偏移
+    uint32_t length;
+    Slot slot;
+  };
+
+  constexpr Slot slotFromName(std::string_view name)
+  {
+    for (size_t i = 0; i < static_cast<size_t>(Slot::Count); ++i)
+    {
+      if (SLOT_NAMES[i] == name)
+        return static_cast<Slot>(i);
+    }
+    return Slot::Invalid;
+  }
+
+  /// @brief 扫描模板，每个片段回调一次；返回片段数，格式错误返回 0
+  template <typename Visitor>
+  constexpr size_t scan(std::string_view text, Visitor &&visit)
+  {
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+      size_t open = text.find("{{", pos);
+      if (open == std::string_view::npos)
+        open = text.size();
+      if (open > pos)
+        visit(Segment{static_cast<uint32_t>(pos), static_cast<uint32_t>(open - pos), Slot::Literal}), ++count;
+      if (open == text.size())
+        break;
+      size_t close = text.find("}}", open + 2);
+      if (close == std::string_view::npos)
+        return 0;
+      Slot slot = slotFromName(text.substr(open + 2, close - open - 2));
+      if (slot == Slot::Invalid)
+        return 0;
+      visit(Segment{0, 0, slot}), ++count;
+      pos = close + 2;
+    }
+    return count;
+  }
+
+  constexpr size_t countSegments(std::string_view text)
+  {
+    return scan(text, [](const Segment &) {});
+  }
+
+  /// @brief 编译期解析内置模板
+  template <size_t N>
+  constexpr std::array<Segment, N> compile(std::string_view text)
+  {
+    std::array<Segment, N> segments{};
+    size_t index = 0;
+    scan(text, [&](const Segment &segment) { segments[index++] = segment; });
+    return segments;
+  }
+}
+
+class ConfigTemplate
+{
+public:
+  /// @brief 引用编译期解析好的内置模板
+  ConfigTemplate(std::string_view source, const tmpl::Segment *segments, size_t count);
+
+  ConfigTemplate(const ConfigTemplate &) = delete;
+  ConfigTemplate &operator=(const ConfigTemplate &) = delete;
+
+  /// @brief 运行期解析模板文本（用于覆盖文件），失败返回 nullptr
+  static std::shared_ptr<const ConfigTemplate> parse(const std::string &text, std::string &error);
+
+  /// @brief 按占位符取值渲染到 out（覆盖原内容）
+  void render(const tmpl::SlotValues &values, std::string &out) const;
+
+  /// @brief 服务端配置模板（OVPN_DIR/templates/server.conf.tmpl 存在时优先）
+  static std::shared_ptr<const ConfigTemplate> server();
+  /// @brief 客户端配置模板（OVPN_DIR/templates/client.ovpn.tmpl 存在时优先）
+  static std::shared_ptr<const ConfigTemplate> client();
+
+private:
+  explicit ConfigTemplate(const std::string &text);
+  void measure();
+
+  std::string storage; // 运行期模板持有的文本
+  std::string_view source;
+  std::vector<tmpl::Segment> owned;
+  const tmpl::Segment *segments = nullptr;
+  size_t count = 0;
+  size_t literalSize = 0;
+};
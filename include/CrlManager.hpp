@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <map>
+#include <mutex>
+#include <ctime>
+#include <cstdint>
+
+typedef struct x509_st X509;
+typedef struct evp_pkey_st EVP_PKEY;
+typedef struct X509_crl_st X509_CRL;
+
+/// @brief 吊销记录
+struct RevokedEntry
+{
+  time_t revokedAt;   // 吊销时间
+  time_t expiresAt;   // 证书过期时间（0 表示未知，不参与清理）
+  uint64_t crlNumber; // 加入时对应的CRL序号，用于生成增量CRL
+};
+
+/// @brief 原生CRL管理器
+/// @note  在内存中维护已吊销序列号集合，吊销时只追加新条目并用CA私钥重新签名，
+///        以原子方式（临时文件+rename）写出 crl.pem，避免每次调用 easyrsa gen-crl 全量重建。
+class CrlManager
+{
+public:
+  CrlManager(const std::string &pkiDir, const std::string &crlPath);
+  ~CrlManager();
+
+  CrlManager(const CrlManager &) = delete;
+  CrlManager &operator=(const CrlManager &) = delete;
+
+  /// @brief 进程内共享实例（pki 目录取 EASY_RSA_DIR/pki，输出到 OVPN_DIR/crl.pem）
+  static CrlManager &instance();
+
+  /// @brief 读取证书的序列号（十六进制）与过期时间
+  static bool readCertificate(const std::string &certPath, std::string &serialHex, time_t &expiresAt);
+
+  /// @brief 追加一条吊销记录并发布新的CRL
+  bool revoke(const std::string &serialHex, time_t expiresAt);
+
+  /// @brief 重新签名并原子写出完整CRL（同时按需写出增量CRL）
+  bool publish();
+
+  /// @brief 清理已过期证书的吊销记录，返回清理数量
+  size_t pruneExpired(time_t now);
+
+  /// @brief 是否额外生成增量CRL（写出到 crl 同目录的 crl-delta.pem）
+  void setDeltaEnabled(bool enabled) { deltaEnabled = enabled; }
+
+  /// @brief 写出完整CRL前是否自动清理过期条目
+  void setAutoPrune(bool enabled) { autoPrune = enabled; }
+
+  size_t size() const;
+
+private:
+  bool ensureLoaded();
+  bool loadIndex();
+  bool loadSigner();
+  bool publishLocked();
+  size_t pruneLocked(time_t now);
+  bool rebuildCrl();
+  X509_CRL *buildCrl(bool delta);
+  bool signAndWrite(X509_CRL *crl, uint64_t number, const std::string &path, bool delta);
+  uint64_t nextCrlNumber();
+  static bool writeFileAtomic(const std::string &path, const std::string &content, int mode);
+
+  std::string pkiDir;
+  std::string crlPath;
+  std::map<std::string, RevokedEntry> revoked; // 序列号(大写十六进制) -> 吊销记录
+  time_t indexMtime = 0;
+  uint64_t baseCrlNumber = 0; // 最近一次完整CRL的序号
+  bool loaded = false;
+  bool deltaEnabled = false;
+  bool autoPrune = true;
+  X509 *caCert = nullptr;
+  EVP_PKEY *caKey = nullptr;
+  X509_CRL *crl = nullptr; // 常驻内存的CRL，新吊销直接追加
+  mutable std::mutex mutex;
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+/// @brief 数据通道卸载（ovpn-dco）检测结果
+struct DcoStatus
+{
+  bool moduleLoaded = false;   // 内核模块已加载
+  bool openvpnSupport = false; // OpenVPN 为 2.6+ 且编译了 DCO 支持
+  int versionMajor = 0;
+  int versionMinor = 0;
+
+  bool available() const { return moduleLoaded && openvpnSupport; }
+  /// @brief OpenVPN 是否认识 disable-dco 等 2.6 新指令
+  bool supportsDcoOptions() const { return versionMajor > 2 || (versionMajor == 2 && versionMinor >= 6); }
+};
+
+/// @brief ovpn-dco 检测
+/// @note  所有检测都接收 sysfs 根目录与 openvpn --version 输出作为参数，便于用桩目录和桩输出验证。
+class DcoSupport
+{
+public:
+  static const char *DEFAULT_SYS_ROOT;
+
+  /// @brief 解析 openvpn --version 输出，得到版本号及是否带 [DCO] 编译特性
+  static bool parseVersionOutput(const std::string &output, int &major, int &minor, bool &dcoBuild);
+
+  /// @brief 检查 ovpn-dco 内核模块（ovpn_dco_v2 或主线 ovpn）是否已加载
+  static bool isModuleLoaded(const std::string &sysRoot = DEFAULT_SYS_ROOT);
+
+  /// @brief 综合检测
+  static DcoStatus detect(const std::string &versionOutput, const std::string &sysRoot = DEFAULT_SYS_ROOT);
+
+  /// @brief 网络设备是否由 DCO 驱动（存在且不是 tun 字符设备驱动创建的接口）
+  static bool isDeviceOffloaded(const std::string &device, const std::string &sysRoot = DEFAULT_SYS_ROOT);
+};
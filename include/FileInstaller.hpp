@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/// @brief 批量文件安装
+/// @note  每个文件先写入目标目录下的临时文件（内核态 copy_file_range，退化到 sendfile），
+///        在打开的描述符上 fchmod/fchown 并 fsync，全部暂存成功后再以 renameat2 逐个原子替换目标，
+///        最后对涉及的目录各 fsync 一次。任一文件暂存失败则清理全部临时文件，目标保持不变。
+///        替换前为已有目标建立硬链接备份，某个文件替换失败时逆序恢复已替换的文件并删除新建的文件；
+///        各文件的 rename 彼此独立，进程在替换过程中崩溃时批次可能只替换了一部分（备份以 .orig 结尾保留）。
+class FileInstaller
+{
+public:
+  FileInstaller() = default;
+  ~FileInstaller();
+
+  FileInstaller(const FileInstaller &) = delete;
+  FileInstaller &operator=(const FileInstaller &) = delete;
+
+  /// @brief 登记从 source 复制到 dest
+  FileInstaller &copy(const std::string &source, const std::string &dest, mode_t mode,
+                      uid_t owner = static_cast<uid_t>(-1), gid_t group = static_cast<gid_t>(-1));
+  /// @brief 登记将 content 写入 dest
+  FileInstaller &write(const std::string &content, const std::string &dest, mode_t mode,
+                       uid_t owner = static_cast<uid_t>(-1), gid_t group = static_cast<gid_t>(-1));
+  /// @brief 目标已存在时拒绝替换（RENAME_NOREPLACE），默认覆盖
+  FileInstaller &noReplace(bool enabled = true);
+  /// @brief 关闭逐文件 fsync，用于写入随后整体 syncfs 的暂存目录
+  FileInstaller &durable(bool enabled);
+
+  /// @brief 暂存并提交全部登记的文件，失败时 error 给出原因
+  bool commit(std::string &error);
+
+  size_t size() const { return entries.size(); }
+
+private:
+  struct Entry
+  {
+    std::string source; // 为空时写入 content
+    std::string content;
+    std::string dest;
+    mode_t mode;
+    uid_t owner;
+    gid_t group;
+    std::string staged; // 暂存的临时文件路径
+    std::string backup; // 替换前目标的硬链接备份，目标原先不存在时为空
+    bool installed = false;
+  };
+
+  bool stage(Entry &entry, std::string &error);
+  bool install(Entry &entry, std::string &error);
+  void rollback();
+  void discard();
+
+  std::vector<Entry> entries;
+  bool replace = true;
+  bool sync = true;
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/// @brief 基于位图的静态IPv4地址分配器
+/// @note  每个地址占一位，按64位字整体扫描查找空闲位，并记录下次扫描的起点（next-fit），
+///        /16 子网（65536个地址）下分配仍为均摊 O(1)。网络地址、服务端地址(.1)和广播地址预留。
+class IpAllocator
+{
+public:
+  static const int MIN_PREFIX_LENGTH = 16;
+  static const int MAX_PREFIX_LENGTH = 29;
+
+  IpAllocator() = default;
+  IpAllocator(uint32_t network, int prefixLength);
+
+  /// @brief 解析点分十进制地址（主机字节序）
+  static bool parseAddress(const std::string &text, uint32_t &addr);
+  /// @brief 解析 "10.8.0.0" 或 "10.8.0.0/20" 形式的子网，带前缀时覆盖 prefixLength
+  static bool parseSubnet(const std::string &text, uint32_t &network, int &prefixLength);
+  static std::string toString(uint32_t addr);
+  static uint32_t prefixToMask(int prefixLength);
+
+  /// @brief 分配一个空闲地址
+  bool allocate(uint32_t &addr);
+  /// @brief 将指定地址标记为已占用
+  bool reserve(uint32_t addr);
+  /// @brief 释放指定地址
+  bool release(uint32_t addr);
+  bool isAllocated(uint32_t addr) const;
+
+  uint32_t getNetwork() const { return network; }
+  int getPrefixLength() const { return prefixLength; }
+  size_t capacity() const { return bits; }
+  size_t used() const { return usedCount; }
+
+  /// @brief 从位图文件加载，子网参数取自文件头
+  bool load(const std::string &path);
+  /// @brief 原子写出位图文件
+  bool save(const std::string &path) const;
+
+private:
+  bool offsetOf(uint32_t addr, size_t &offset) const;
+  void markReserved();
+
+  uint32_t network = 0;
+  int prefixLength = 32;
+  size_t bits = 0;
+  size_t cursor = 0; // 下次扫描起始的字下标
+  size_t usedCount = 0;
+  std::vector<uint64_t> words;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include "KeySpec.hpp"
+
+/// @brief 单个算法的密钥池设置（保存在池目录的状态文件中，跨进程生效）
+struct KeyPoolOptions
+{
+  uint32_t size = 0;                   // 补充的目标数量，0 表示不使用密钥池
+  uint32_t lowWater = 0;               // 可用数量低于该值时后台补充到 size，0 取 size / 4
+  uint32_t maxAgeSeconds = 7 * 86400;  // 超过该时长未被取用的密钥在补充时销毁，0 不限
+  bool shred = true;                   // 销毁与取用后以零覆盖文件内容并 fsync，再删除
+};
+
+/// @brief 密钥池统计（跨进程累计）
+struct KeyPoolStats
+{
+  uint32_t available = 0;  // 当前可用的密钥数
+  uint64_t hits = 0;       // 签发时从池中取到密钥
+  uint64_t misses = 0;     // 池已启用但为空或取出的密钥签发失败，回退为现场生成
+  uint64_t generated = 0;  // 累计预生成的密钥数
+  uint64_t destroyed = 0;  // 过期或清空时销毁的密钥数
+};
+
+/// @brief 预生成的客户端私钥池
+/// @note  每个算法一个 0700 目录，密钥以 PKCS#8 PEM 逐个保存为 0600 文件（O_EXCL 临时文件写入后 rename）。
+///        取用时以 rename 把文件改名为本进程独占的名称，多个进程并发取用也不会拿到同一把密钥；
+///        读出后立即覆盖并删除，密钥只会被使用一次。后台线程在可用数量低于低水位时补充到目标数量，
+///        补充时销毁过期密钥。覆盖在写时复制文件系统与 SSD 上只能尽力而为。
+class KeyPool
+{
+public:
+  explicit KeyPool(const std::string &dir);
+  ~KeyPool();
+
+  KeyPool(const KeyPool &) = delete;
+  KeyPool &operator=(const KeyPool &) = delete;
+
+  /// @brief 进程内共享实例（目录为 OVPN_DIR/ovpn-mana/keypool）
+  static KeyPool &instance();
+
+  bool configure(KeyAlgorithm algorithm, const KeyPoolOptions &options);
+  bool options(KeyAlgorithm algorithm, KeyPoolOptions &options) const;
+  bool stats(KeyAlgorithm algorithm, KeyPoolStats &stats) const;
+
+  /// @brief 取出一把未使用过的密钥，池未启用或为空时返回 false（启用时计为未命中）
+  bool take(KeyAlgorithm algorithm, std::string &keyPem);
+  /// @brief 取出的密钥未能签发（已丢弃），把该次命中改计为未命中
+  void recordFailure(KeyAlgorithm algorithm);
+  /// @brief 销毁过期密钥并补充到目标数量，generated 返回本次生成的数量
+  bool fill(KeyAlgorithm algorithm, int &generated);
+  /// @brief 销毁全部可用密钥
+  bool drain(KeyAlgorithm algorithm, int &destroyed);
+
+  /// @brief 启动后台补充线程，按 intervalSeconds 与每次取用后检查各算法的低水位
+  void start(int intervalSeconds = 60);
+  void stop();
+
+  /// @brief 生成私钥（PKCS#8 PEM）：RSA 长度取 easy-rsa 的 EASYRSA_KEY_SIZE（默认 2048），EC 使用命名曲线
+  static bool generate(KeyAlgorithm algorithm, std::string &keyPem);
+  /// @brief 以私钥生成 CN 为 commonName 的证书请求（PEM）
+  static bool buildRequest(const std::string &keyPem, const std::string &commonName, std::string &requestPem);
+
+private:
+  struct State;
+
+  std::string algorithmDir(KeyAlgorithm algorithm) const;
+  bool updateState(KeyAlgorithm algorithm, const std::function<void(State &)> &update) const;
+  bool readState(KeyAlgorithm algorithm, State &state) const;
+  std::vector<std::string> listKeys(const std::string &dir, int64_t olderThan = 0) const;
+  bool store(const std::string &dir, const std::string &keyPem) const;
+  bool destroy(const std::string &path, bool shred) const;
+  void run(int intervalSeconds);
+
+  std::string dir;
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  std::thread worker;
+  bool stopping = false;
+  bool pending = false; // 有取用发生，后台线程应尽快检查低水位
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// 证书与私钥算法
+enum class KeyAlgorithm
+{
+  Rsa = 0,     // easy-rsa 默认（RSA），密钥交换使用 dh.pem
+  EcP256 = 1,  // ECDSA P-256
+  EcP384 = 2,  // ECDSA P-384
+  Ed25519 = 3, // EdDSA Ed25519
+};
+
+/// @brief 算法对应的签发参数与服务端密钥交换设置
+/// @note  非 RSA 服务以 dh none 关闭有限域 DH，握手只使用 ECDHE，不再生成与分发 dh.pem。
+///        ECDSA 以 ecdh-curve 指定同名曲线；X25519 不是 ecdh-curve 可用的曲线（OpenSSL 1.1.x 下报错），
+///        Ed25519 改用 tls-groups（OpenVPN 2.5 起）。服务端配置中的标记注释记录服务的算法，
+///        重建登记表时据此还原；早期版本创建的服务没有标记，按 ecdh-curve 还原。
+struct KeySpec
+{
+  KeyAlgorithm algorithm;
+  std::string name;          // 命令行与文档中的名称
+  std::string easyrsaAlgo;   // easy-rsa --use-algo
+  std::string easyrsaCurve;  // easy-rsa --curve，RSA 为空
+  std::string ecdhCurve;     // 服务端 ecdh-curve，RSA 与 Ed25519 为空
+  std::string tlsGroups;     // 服务端 tls-groups，为空时不输出
+
+  static const std::string MARKER; // 服务端配置中记录算法名的注释前缀
+
+  /// @brief 全部支持的算法
+  static const std::vector<KeySpec> &all();
+  static const KeySpec &of(KeyAlgorithm algorithm);
+  /// @brief 按名称查找，未找到返回 nullptr
+  static const KeySpec *find(const std::string &name);
+  /// @brief 由服务端配置的注释与 ecdh-curve 还原算法：标记优先，其次按 ecdh-curve，都没有时为 RSA
+  static const KeySpec &fromServerConfig(const std::vector<std::string> &comments, const std::string &ecdhCurve);
+
+  /// @brief easy-rsa 的全局参数（前后带空格，RSA 为单个空格）
+  std::string easyrsaOptions() const;
+  /// @brief 服务端配置中的密钥交换指令块，RSA 引用 dhPath，其余算法带标记注释
+  std::string keyExchange(const std::string &dhPath) const;
+  std::string marker() const { return MARKER + name; }
+  bool usesDh() const { return algorithm == KeyAlgorithm::Rsa; }
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+/// @brief OpenVPN 管理接口客户端（unix 套接字）
+/// @note  服务端配置以 management <runtime_dir>/management.sock unix 开启管理接口，
+///        用于在不重启进程的情况下断开指定客户端。每条命令等待 SUCCESS:/ERROR: 应答行，
+///        期间的 > 开头实时通知被跳过；所有读写均受截止时间限制。
+class ManagementClient
+{
+public:
+  explicit ManagementClient(int timeoutMs = 3000) : timeoutMs(timeoutMs) {}
+  ~ManagementClient();
+
+  ManagementClient(const ManagementClient &) = delete;
+  ManagementClient &operator=(const ManagementClient &) = delete;
+
+  /// @brief 连接管理套接字并读取欢迎信息，连接失败时 errno 为 connect 的错误码
+  bool connect(const std::string &socketPath);
+  void close();
+
+  /// @brief 执行单行应答的命令，reply 为去掉 SUCCESS:/ERROR: 前缀的应答内容
+  /// @return 应答为 SUCCESS 时返回 true
+  bool command(const std::string &cmd, std::string &reply);
+
+  /// @brief 断开通用名为 commonName 的全部会话；客户端不在线时返回 true
+  bool killClient(const std::string &commonName);
+
+private:
+  bool readLine(std::string &line);
+  bool writeAll(const std::string &data);
+
+  int timeoutMs;
+  int fd = -1;
+  std::string buffer;
+};
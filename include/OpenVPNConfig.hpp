@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+/// @brief OpenVPN 配置文件解析结果
+/// @note  按 OpenVPN 的规则切分参数（支持引号、反斜杠转义与 #/; 注释），
+///        建立“指令 -> 各次出现的参数列表”的索引，<ca>...</ca> 等内联块单独保存。
+///        load() 按文件修改时间缓存，同一配置在批量操作中只解析一次。
+class OpenVPNConfig
+{
+public:
+  using Args = std::vector<std::string>;
+
+  /// @brief 解析配置文本
+  static std::shared_ptr<const OpenVPNConfig> parse(const std::string &text);
+  /// @brief 读取并解析配置文件（按修改时间缓存），文件不存在返回 nullptr
+  static std::shared_ptr<const OpenVPNConfig> load(const std::string &path);
+
+  bool has(const std::string &directive) const;
+  /// @brief 指令首次出现的参数，不存在返回 nullptr
+  const Args *find(const std::string &directive) const;
+  /// @brief 指令每次出现的参数
+  const std::vector<Args> &findAll(const std::string &directive) const;
+  /// @brief 指令首次出现的第 index 个参数，不存在返回 fallback
+  std::string get(const std::string &directive, size_t index = 0, const std::string &fallback = "") const;
+  int getInt(const std::string &directive, size_t index = 0, int fallback = 0) const;
+
+  /// @brief 内联块内容（如 "ca"、"tls-auth"），不存在返回 nullptr
+  const std::string *inlineBlock(const std::string &tag) const;
+  /// @brief 整行注释（含前导 # 或 ;），按出现顺序
+  const std::vector<std::string> &comments() const { return commentLines; }
+
+private:
+  std::unordered_map<std::string, std::vector<Args>> directives;
+  std::unordered_map<std::string, std::string> blocks;
+  std::vector<std::string> commentLines;
+};
@@ -4,15 +4,116 @@
 #include <map>
 #include <filesystem>
 #include <iostream>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <sys/types.h>
+#include "DcoSupport.hpp"
+#include "KeySpec.hpp"
 
 namespace fs = std::filesystem;
 
+class ServiceRegistry;
+struct ServiceRecord;
+class OpenVPNConfig;
+class ClientSnapshot;
+struct OnlineClient;
+struct ClientDelta;
+struct SessionRecord;
+struct SessionTotals;
+struct UsagePolicy;
+struct PolicyDecision;
+struct RateLimit;
+struct KeyPoolOptions;
+struct KeyPoolStats;
+
 struct VPNService
 {
   std::string name;
   std::string configPath;
-  bool isActive;
-  bool isEnabled;
+  bool isActive = false;
+  bool isEnabled = false;
+  int shards = 1;       // 分片数量，非分片服务为1
+  int activeShards = 0; // 活跃的分片数量
+  bool dcoActive = false; // 数据通道是否由内核 ovpn-dco 承载
+};
+
+// 枚举服务时按需查询的字段（名称、配置路径与分片数量取自登记表，始终填充）
+struct ServiceFields
+{
+  static const unsigned STATE = 0x1;   // 活跃状态与活跃分片数（systemctl is-active）
+  static const unsigned ENABLED = 0x2; // 自启状态（systemctl is-enabled）
+  static const unsigned DCO = 0x4;     // 是否由 ovpn-dco 承载（读取配置与网卡，隐含 STATE）
+  static const unsigned ALL = STATE | ENABLED | DCO;
+};
+
+// 数据通道卸载模式
+enum class DcoMode
+{
+  Auto = 0,     // 可用时启用，否则回退到用户态
+  Off = 1,      // 始终使用用户态数据通道
+  Required = 2, // 不可用时创建失败
+};
+
+// 服务创建参数
+struct ServiceOptions
+{
+  static const int MAX_SHARDS = 16;
+
+  int prefixLength = 24; // 子网前缀长度（16~29），subnet 中带 /nn 时以其为准
+  int shards = 1;        // 分片数量（2的幂），>1 时创建 <name>-<k> 多个实例并平分子网
+  std::string profile = "default"; // 性能档案，见 ConfigProfile::all()
+  DcoMode dco = DcoMode::Auto;
+  KeyAlgorithm keyAlgorithm = KeyAlgorithm::Rsa; // 服务与其客户端证书的密钥算法
+};
+
+// 从服务端配置解析出的服务参数
+struct ServiceSettings
+{
+  int port = 0;
+  std::string proto;
+  std::string subnet; // 整个服务的子网，形如 10.8.0.0/24
+  std::string cipher; // 数据通道加密套件（协商列表）
+  KeyAlgorithm keyAlgorithm = KeyAlgorithm::Rsa;
+};
+
+// 批量生命周期操作
+enum class BulkAction
+{
+  Start = 0,
+  Stop = 1,
+  Restart = 2,
+};
+
+struct BulkOptions
+{
+  int concurrency = 8;          // 同时操作的服务数上限
+  int maxUnavailable = 0;       // >0 时为滚动模式：同时不可用的服务数上限，操作后须恢复健康才继续
+  int healthTimeoutMs = 30000;  // 滚动模式下等待服务恢复健康的最长时间
+};
+
+enum class BulkStatus
+{
+  Succeeded = 0,
+  Failed = 1,
+  Unhealthy = 2, // 操作完成但未在期限内恢复健康（滚动模式）
+  Skipped = 3,   // 滚动模式中前序失败后未执行
+};
+
+struct BulkResult
+{
+  std::string name;
+  BulkStatus status = BulkStatus::Skipped;
+};
+
+// 服务变更类型，决定变更的生效方式
+enum class ServiceChange
+{
+  Revocation,    // CRL 更新：crl-verify 在每次握手时重新读取，只需断开被吊销客户端的现有会话
+  ClientConfig,  // ccd 变更：客户端下次连接时读取，断开该客户端使其立即重连
+  ServerOptions, // push、路由等服务端指令：SIGHUP 使进程重读配置，进程与 tun 设备保留
+  Listen,        // 端口、协议、设备变更：必须重启
+  Disconnect,    // 配额与空闲规则断开客户端：必须经管理接口，没有管理接口时返回失败
 };
 
 struct VPNClient
@@ -21,73 +122,136 @@ struct VPNClient
   std::string vpnIp;
   std::string realIp;
   std::string since;
-  uint64_t bytesReceived;
-  uint64_t bytesSent;
+  int64_t connectedSince = 0; // 连接时间（epoch 秒）
+  uint64_t bytesReceived = 0;
+  uint64_t bytesSent = 0;
 };
 
 class OpenVPNManager
 {
 public:
+  OpenVPNManager();
+
   // 服务管理
-  static std::vector<VPNService> listServices();
-  static bool createService(const std::string &name, const std::string &subnet, int port = 1194);
+  static std::vector<VPNService> listServices(unsigned fields = ServiceFields::ALL);
+  /// @brief 逐个服务回调，visitor 返回 false 时停止；只查询 fields 指定的字段
+  static void visitServices(const std::function<bool(const VPNService &)> &visitor,
+                            unsigned fields = ServiceFields::ALL);
+  /// @brief 登记表中全部服务的记录（定长，不含 systemd 状态）
+  static std::vector<ServiceRecord> serviceRecords();
+  /// @brief 由登记记录生成服务信息，只查询 fields 指定的字段
+  static void describeService(const ServiceRecord &record, unsigned fields, VPNService &service);
+  static bool createService(const std::string &name, const std::string &subnet, int port = 1194,
+                            const ServiceOptions &options = ServiceOptions());
   static bool startService(const std::string &name);
   static bool stopService(const std::string &name);
   static bool restartService(const std::string &name);
+  /// @brief 向服务各实例发送 SIGHUP 重读配置（不重启进程）
+  static bool reloadService(const std::string &name);
+  /// @brief 按变更类型以最小代价使变更生效，commonName 为受影响的客户端
+  static bool applyServiceChange(const std::string &name, ServiceChange change, const std::string &commonName = "");
   static bool deleteService(const std::string &name);
+  static bool getServiceSettings(const std::string &name, ServiceSettings &settings);
+  /// @brief 对名称匹配 pattern（fnmatch 通配）的全部服务并行执行启动/停止/重启
+  static std::vector<BulkResult> bulkOperation(const std::string &pattern, BulkAction action,
+                                               const BulkOptions &options = BulkOptions());
 
   // 客户端管理
   static bool createClient(const std::string &name, const std::string &serviceName, const std::string &wanip);
   static bool revokeClient(const std::string &name, const std::string &serviceName);
   static std::vector<VPNClient> getOnlineClients(const std::string &serviceName);
+  /// @brief 在线客户端快照（数值化的紧凑记录，按连接时间排序）
+  static std::shared_ptr<const ClientSnapshot> getClientSnapshot(const std::string &serviceName);
+  /// @brief 获取快照及其版本，状态文件内容变化时版本递增
+  static std::shared_ptr<const ClientSnapshot> getClientSnapshot(const std::string &serviceName, uint64_t &version);
+  /// @brief 自 sinceVersion 以来的变化；版本为 0、已移出历史或来自其他进程时返回全量
+  static ClientDelta getClientDelta(const std::string &serviceName, uint64_t sinceVersion);
+  /// @brief 把在线客户端表发布到服务的共享内存段，快照版本未变时不重写；version 返回已发布的版本
+  static bool publishClients(const std::string &serviceName, uint64_t &version);
+  /// @brief 比较前后两次快照，把已下线或重新连接的客户端的上一次会话追加到会话日志
+  /// @note  首次调用只记录基准；同一服务只应有一个记录进程，recorded 返回本次追加的条数
+  static bool recordSessions(const std::string &serviceName, int &recorded);
+  /// @brief 会话日志中与 [from, to) 有交集的会话，commonName 为空时不限定
+  static bool querySessions(const std::string &serviceName, const std::string &commonName, int64_t from, int64_t to,
+                            size_t limit, std::vector<SessionRecord> &sessions);
+  static bool aggregateSessions(const std::string &serviceName, const std::string &commonName, int64_t from,
+                                int64_t to, SessionTotals &totals);
+  /// @brief 以当前快照累计各客户端本月流量并执行配额与空闲规则：断开超额或空闲的客户端，
+  ///        deny 时在各实例的 ccd/<client> 写入 disable，跨月后移除；decisions 返回本次执行的动作
+  /// @note  同一服务只应有一个执行进程，用量文件最多每 USAGE_SAVE_SECONDS 秒写入一次，有动作时立即写入
+  static bool enforcePolicy(const std::string &serviceName, const UsagePolicy &policy,
+                            std::vector<PolicyDecision> &decisions);
+  /// @brief 用量文件中客户端本月的累计流量，没有记录时返回 false
+  static bool getClientUsage(const std::string &serviceName, const std::string &commonName, uint64_t &bytes);
+  /// @brief 按名称查找在线客户端（快照哈希索引，O(1)），snapshot 持有返回记录所在的快照
+  static const OnlineClient *findOnlineClient(const std::string &serviceName, const std::string &name,
+                                              std::shared_ptr<const ClientSnapshot> &snapshot);
+  /// @brief 在全部服务中查找在线客户端，serviceName 返回所在服务
+  static const OnlineClient *locateOnlineClient(const std::string &name, std::string &serviceName,
+                                                std::shared_ptr<const ClientSnapshot> &snapshot);
   static int getTotalClientsCount(const std::string &serviceName);
   static std::string getOVPNFileContent(const std::string &name, const std::string &serviceName);
 
+  // 流量整形
+  /// @brief 设置服务的汇总限速，记录在各实例服务端配置的注释中，分片服务按实例数平分；不限速的方向为 0
+  static bool setServiceRate(const std::string &name, const RateLimit &limit);
+  /// @brief 设置客户端限速，记录在各实例 ccd/<client> 的注释中；全为 0 时移除
+  static bool setClientRate(const std::string &serviceName, const std::string &commonName, const RateLimit &limit);
+  /// @brief 生成服务各实例的 tc 批处理脚本（不执行），scripts 为 (设备名, 脚本)，顺序与实例相同
+  static bool buildShaping(const std::string &name, std::vector<std::pair<std::string, std::string>> &scripts);
+  /// @brief 重新生成并应用服务的限速，每个 tun 设备执行一次 tc -batch，设备不存在（实例未运行）时跳过
+  static bool applyShaping(const std::string &name);
+
+  // 数据通道卸载
+  static DcoStatus detectDco();
+
+  // 预生成私钥池
+  /// @brief 设置算法的密钥池，size 为 0 时停用；启用后 createClient 优先取用池中的密钥，只在本地签发证书
+  static bool configureKeyPool(KeyAlgorithm algorithm, const KeyPoolOptions &options);
+  static bool getKeyPoolStats(KeyAlgorithm algorithm, KeyPoolStats &stats);
+  /// @brief 立即销毁过期密钥并补充到目标数量（同步执行），generated 返回生成的数量
+  static bool fillKeyPool(KeyAlgorithm algorithm, int &generated);
+  /// @brief 销毁池中全部未使用的密钥
+  static bool drainKeyPool(KeyAlgorithm algorithm, int &destroyed);
+  /// @brief 在本进程启动或停止后台补充线程（适用于常驻进程）
+  static void startKeyPoolWorker(int intervalSeconds);
+  static void stopKeyPoolWorker();
+
 private:
+  static const int STOP_TIMEOUT_MS = 15000; // 等待单元停止的最长时间
+  static constexpr int SNAPSHOT_CHECK_MS = 1000; // 在线客户端快照复用而不检查状态文件的时间
+  static constexpr size_t SNAPSHOT_HISTORY = 8;  // 每个服务保留的历史快照数（含当前），用于增量同步
+  static constexpr int USAGE_SAVE_SECONDS = 60;   // 没有动作时用量文件的最短写入间隔
+
   static bool execCommand(const std::string &cmd, std::string &output);
+  static bool execCommand(const std::string &cmd, std::string &output, int &exitStatus);
   static bool isServiceActive(const std::string &name);
   static bool isServiceEnabled(const std::string &name);
   static std::string getServiceConfigPath(const std::string &name);
   static std::string getClientConfigPath(const std::string &name, const std::string &serviceName);
   static std::string getStatusFilePath(const std::string &serviceName);
-  static bool copyWithSudo(const std::string &src, const std::string &dest)
-  {
-    try
-    {
-      // 检查源文件是否存在
-      if (!fs::exists(src))
-      {
-        throw std::runtime_error("Source file does not exist");
-      }
-
-      // 使用临时文件避免权限问题
-      fs::path tempDest = fs::path(dest).parent_path() / ("temp_" + fs::path(dest).filename().string());
-
-      // 先复制到临时文件
-      fs::copy(src, tempDest, fs::copy_options::overwrite_existing);
-
-      // 使用sudo移动文件
-      std::string cmd = "sudo mv " + tempDest.string() + " " + dest;
-      std::string output;
-      if (!execCommand(cmd, output))
-      {
-        fs::remove(tempDest); // 清理临时文件
-        throw std::runtime_error("Failed to move file with sudo: " + output);
-      }
-
-      // 设置权限
-      cmd = "sudo chmod 644 " + dest;
-      if (!execCommand(cmd, output))
-      {
-        throw std::runtime_error("Failed to set permissions: " + output);
-      }
-
-      return true;
-    }
-    catch (const std::exception &e)
-    {
-      std::cerr << "File operation failed: " << e.what() << std::endl;
-      return false;
-    }
-  }
+  static std::string getSessionLogPath(const std::string &serviceName);
+  static std::string getUsagePath(const std::string &serviceName);
+  static bool updateClientConfig(const std::string &serviceName, const std::string &commonName, const std::string &key,
+                                 const std::string &line);
+  static bool replaceConfigLine(const std::string &path, const std::string &key, const std::string &line);
+  static bool issueFromKeyPool(const std::string &name, KeyAlgorithm algorithm);
+  static bool updateCrl(const std::string &serial, time_t expiresAt);
+  static std::string getServiceDir(const std::string &name);
+  static ServiceRegistry &registry();
+  static std::vector<ServiceRecord> scanServices();
+  static bool readServiceRecord(const std::string &configPath, ServiceRecord &record);
+  static int getListenPort(const OpenVPNConfig &config);
+  static std::string getManagementSocket(const OpenVPNConfig &config);
+  static int maskToPrefix(uint32_t mask);
+  static bool servicePrefixLength(uint32_t shardMask, int shardBits, int &prefixLength);
+  static bool readShardGroup(const std::string &name, int &shards, int &basePort);
+  static std::vector<std::string> getServiceUnits(const std::string &name);
+  static std::string getUnitList(const std::string &name);
+  static int countActiveUnits(const std::string &name);
+  static std::vector<pid_t> getMainPids(const std::string &name);
+  static bool waitHealthy(const std::string &name, int timeoutMs);
+  static bool isDcoActive(const std::string &name);
+  static bool assignStaticAddress(const std::string &name, const std::string &serviceName, bool &assigned);
+  static bool releaseStaticAddress(const std::string &name, const std::string &serviceName, bool removeConfig);
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <sys/types.h>
+
+/// @brief 等待一组进程退出
+/// @note  为每个进程打开 pidfd（Linux 5.3+），进程退出时描述符变为可读，用 poll 带截止时间等待，
+///        无需轮询 systemctl。内核不支持 pidfd 时退化为 kill(pid, 0) 短间隔探测。
+///        必须在触发退出（如 systemctl stop）之前 add，避免进程号被复用。
+class ProcessWatch
+{
+public:
+  ProcessWatch() = default;
+  ~ProcessWatch();
+
+  ProcessWatch(const ProcessWatch &) = delete;
+  ProcessWatch &operator=(const ProcessWatch &) = delete;
+
+  /// @brief 登记进程，pid <= 0 或进程已不存在时忽略
+  void add(pid_t pid);
+  size_t size() const { return watched.size(); }
+
+  /// @brief 等待全部进程退出，超时返回 false
+  bool waitAll(int timeoutMs);
+
+private:
+  struct Watched
+  {
+    pid_t pid;
+    int fd; // pidfd，不支持时为 -1
+  };
+
+  std::vector<Watched> watched;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+#include <ctime>
+#include <sys/types.h>
+
+/// @brief 服务登记记录（定长，直接映射到登记文件）
+struct ServiceRecord
+{
+  char name[64];
+  char profile[32];     // 性能档案名
+  uint32_t network;     // 子网网络地址（主机字节序）
+  uint16_t port;        // 首个实例端口，分片依次递增
+  uint8_t prefixLength; // 整个服务的子网前缀长度
+  uint8_t shards;
+  uint8_t proto;        // 0 udp，1 tcp
+  uint8_t dco;          // 创建时是否启用数据通道卸载
+  uint8_t dcoMode;      // 创建参数 DcoMode
+  uint8_t keyAlgorithm; // 证书与密钥算法 KeyAlgorithm
+  uint8_t reserved[4];
+  int64_t createdAt;
+
+  static const uint8_t PROTO_UDP = 0;
+  static const uint8_t PROTO_TCP = 1;
+
+  std::string protoName() const { return proto == PROTO_TCP ? "tcp" : "udp"; }
+};
+
+/// @brief 持久化的服务登记表
+/// @note  记录数组以二进制形式保存并 mmap 只读映射，查询服务元数据无需扫描目录或读取配置。
+///        文件头记录被监视目录及其中配置文件（名称以 watchSuffix 结尾）的最新修改时间，
+///        库外新增、删除或编辑配置后不一致，调用扫描函数重建；本进程的创建、删除直接更新登记表。
+///        每次查询 stat 一次目录与其中的配置文件，不读取文件内容。
+class ServiceRegistry
+{
+public:
+  using Scanner = std::function<std::vector<ServiceRecord>()>;
+
+  /// @param path      登记文件路径
+  /// @param watchDir     扫描函数读取配置的目录，用于判断登记表是否过期
+  /// @param watchSuffix  watchDir 中需要检查修改时间的配置文件后缀
+  /// @param scanner      过期时重建登记表的扫描函数
+  ServiceRegistry(const std::string &path, const std::string &watchDir, const std::string &watchSuffix,
+                  Scanner scanner);
+  ~ServiceRegistry();
+
+  ServiceRegistry(const ServiceRegistry &) = delete;
+  ServiceRegistry &operator=(const ServiceRegistry &) = delete;
+
+  /// @brief 映射登记文件，不存在或过期时重建
+  bool open();
+
+  bool find(const std::string &name, ServiceRecord &record);
+  std::vector<ServiceRecord> list();
+
+  /// @brief 新增或替换记录
+  bool put(const ServiceRecord &record);
+  bool remove(const std::string &name);
+
+  /// @brief 以 name 填充记录名（超长截断）
+  static void setName(ServiceRecord &record, const std::string &name);
+
+private:
+  struct Header;
+
+  bool ensureFreshLocked();
+  std::vector<ServiceRecord> currentLocked();
+  bool readWatchMtime(struct timespec &mtime) const;
+  bool mapLocked();
+  void unmapLocked();
+  bool writeLocked(const std::vector<ServiceRecord> &records, const struct timespec &mtime);
+  const ServiceRecord *records() const;
+  uint32_t count() const;
+
+  std::string path;
+  std::string watchDir;
+  std::string watchSuffix;
+  Scanner scanner;
+  std::mutex mutex;
+  void *data = nullptr;
+  size_t size = 0;
+  ino_t inode = 0;
+};
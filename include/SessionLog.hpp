@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/// @brief 一次已结束的客户端会话（定长，直接追加到会话日志）
+struct SessionRecord
+{
+  char commonName[64];
+  uint8_t realFamily;   // 4、6，未知为 0
+  uint8_t reserved;
+  uint16_t realPort;
+  uint32_t vpnIpv4;     // 主机字节序，0 表示未分配
+  uint8_t realAddr[16]; // 网络字节序，IPv4 占前 4 字节
+  int64_t start;        // 连接时间（epoch 秒）
+  int64_t end;          // 检测到断开的时间（epoch 秒）
+  uint64_t bytesReceived;
+  uint64_t bytesSent;
+};
+
+/// @brief 会话汇总
+struct SessionTotals
+{
+  uint64_t sessions = 0;
+  uint64_t duration = 0; // 秒
+  uint64_t bytesReceived = 0;
+  uint64_t bytesSent = 0;
+
+  void add(const SessionRecord &record);
+  void add(const SessionTotals &other);
+};
+
+/// @brief 服务的会话历史日志
+/// @note  数据文件为定长记录的追加日志，记录大致按结束时间递增。每满 BLOCK_RECORDS 条记录，
+///        在索引文件（数据文件名加 .idx）中追加一个稀疏索引项：块内开始、结束时间的范围，
+///        块内会话的汇总，以及通用名的布隆过滤器。查询按时间范围与布隆过滤器跳过无关的块，
+///        汇总时完全落在范围内且不限定通用名的块直接使用索引中的汇总，不读取记录。
+///        同一时刻只允许一个写入进程（flock）；读取以只读映射进行，可与写入并发。
+///        会话由记录进程比较前后两次 status.log 快照得到：在两次刷新之间开始并结束的会话不会出现，
+///        字节数为断开前最后一次刷新时的值，最后一个刷新间隔内的流量不计入。
+class SessionLog
+{
+public:
+  static const uint32_t BLOCK_RECORDS = 256;
+
+  explicit SessionLog(const std::string &path);
+  ~SessionLog();
+
+  SessionLog(const SessionLog &) = delete;
+  SessionLog &operator=(const SessionLog &) = delete;
+
+  /// @brief 打开或创建日志用于追加：截去不完整的尾部记录，索引缺失或不一致时重建
+  /// @return 已有其他写入进程或文件损坏时返回 false
+  bool openForAppend();
+  bool append(const std::vector<SessionRecord> &records);
+
+  /// @brief 与 [from, to) 有交集的会话，commonName 为空时不限定（超长时与记录一样截断后比较）；
+  ///        按日志顺序，最多 limit 条（0 不限）
+  /// @return 日志不存在时返回 true 且结果为空，损坏时返回 false
+  bool query(std::string_view commonName, int64_t from, int64_t to, size_t limit,
+             std::vector<SessionRecord> &sessions) const;
+  /// @brief 与 [from, to) 有交集的会话的汇总（按整次会话计）
+  bool aggregate(std::string_view commonName, int64_t from, int64_t to, SessionTotals &totals) const;
+
+  /// @brief 以 name 填充通用名（超过 63 字节截断）
+  static void setCommonName(SessionRecord &record, std::string_view name);
+
+private:
+  struct IndexEntry;
+  class MappedLog;
+
+  bool repairIndexLocked();
+  bool appendIndexLocked(uint64_t block);
+
+  std::string path;
+  std::string indexPath;
+  int fd = -1;
+  int indexFd = -1;
+  uint64_t count = 0;   // 数据文件中的记录数
+  uint64_t indexed = 0; // 已建索引的块数
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class ClientSnapshot;
+
+/// @brief 共享内存中的在线客户端记录（定长，名称在区域的字符串表中）
+struct SharedClientRecord
+{
+  uint32_t nameOffset;
+  uint16_t nameLength;
+  uint8_t realFamily; // 4、6，无法解析时为 0
+  uint8_t hasVpnIpv6;
+  uint16_t realPort;
+  uint16_t reserved;
+  uint32_t vpnIpv4;   // 主机字节序，0 表示未分配
+  uint8_t realAddr[16];
+  uint8_t vpnIpv6[16];
+  int64_t connectedSince;
+  uint64_t bytesReceived;
+  uint64_t bytesSent;
+};
+
+/// @brief 在线客户端表的共享内存发布端
+/// @note  每个服务一个 POSIX 共享内存段（/dev/shm/ovpn-mana.<服务名>），同一时刻只允许一个发布进程（flock）。
+///        段内两个数据区轮流写入：发布时写入非活动区，再切换活动区，序号在写入开始与切换时各加一。
+///        读端只在读取期间活动区被再次改写时重试，解析只在发布进程中进行一次。
+///        数据区不够时在段尾追加新区，段只增长不截断，已映射的读端不会访问到被截断的页。
+///        只接管本用户创建的段；关闭时删除段名。
+class SharedClientPublisher
+{
+public:
+  SharedClientPublisher() = default;
+  ~SharedClientPublisher();
+
+  SharedClientPublisher(const SharedClientPublisher &) = delete;
+  SharedClientPublisher &operator=(const SharedClientPublisher &) = delete;
+
+  /// @brief 创建或接管服务的共享内存段，已有其他发布进程或段属于其他用户时失败
+  bool open(const std::string &serviceName);
+  /// @brief 解除映射并删除段名
+  void close();
+  bool isOpen() const { return data != nullptr; }
+
+  /// @brief 发布快照，version 为快照版本
+  bool publish(const ClientSnapshot &snapshot, uint64_t version);
+
+  /// @brief 服务对应的共享内存段名，服务名含 '/' 时返回空串
+  static std::string segmentName(const std::string &serviceName);
+
+private:
+  bool growLocked(size_t required);
+
+  int fd = -1;
+  void *data = nullptr;
+  size_t size = 0;
+  std::string segment; // 取得发布锁后的段名，关闭时删除
+};
+
+/// @brief 在线客户端表的只读映射
+/// @note  read 在共享内存上直接完成，数据区位置不变时不做系统调用；发布端扩展段后读端重新映射一次。
+///        发布进程退出后表不再更新，open 会失败；长期持有的读端可定期以 publisherAlive 检查。
+class SharedClientReader
+{
+public:
+  /// @brief 一致的一份客户端表
+  struct View
+  {
+    uint64_t version = 0;     // 发布的快照版本
+    int64_t publishedAt = 0;  // 发布时间（epoch 秒）
+    std::vector<SharedClientRecord> records;
+    std::string strings;      // 名称字符串表
+
+    std::string_view name(const SharedClientRecord &record) const
+    {
+      return std::string_view(strings.data() + record.nameOffset, record.nameLength);
+    }
+  };
+
+  /// @brief 数据区回调，返回后校验序号，数据区在此期间被改写时重试
+  /// @note  回调可能被调用多次，只应写入调用方自己的缓冲区；重试前读到的内容可能不一致，
+  ///        访问名称前须检查 nameOffset + nameLength 不超过 stringsSize
+  using Visitor = void (*)(void *context, uint64_t version, int64_t publishedAt, const SharedClientRecord *records,
+                           uint32_t count, const char *strings, uint32_t stringsSize);
+
+  SharedClientReader() = default;
+  ~SharedClientReader();
+
+  SharedClientReader(const SharedClientReader &) = delete;
+  SharedClientReader &operator=(const SharedClientReader &) = delete;
+
+  /// @brief 只读映射服务的共享内存段，不存在或发布进程已退出时失败
+  bool open(const std::string &serviceName);
+  void close();
+
+  /// @brief 发布进程是否仍持有该段（一次 flock 探测）
+  bool publisherAlive() const;
+
+  /// @brief 读取完整的一份客户端表（复用 view 已有的容量）
+  bool read(View &view);
+  /// @brief 以回调访问一致的数据区，不复制整张表
+  bool visit(Visitor visitor, void *context);
+
+private:
+  bool remap();
+
+  int fd = -1;
+  const void *data = nullptr;
+  size_t size = 0;
+};
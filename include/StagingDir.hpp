@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// @brief 事务式暂存目录
+/// @note  在目标所在文件系统上创建临时目录，先在其中构建完整的文件树，提交时 syncfs 一次，
+///        再按登记顺序以 renameat2(RENAME_NOREPLACE) 发布到最终位置。任一发布失败时把已发布的条目移回，
+///        未提交即析构则整体 remove_all，不会留下半成品。
+class StagingDir
+{
+public:
+  /// @brief 在 parent 下创建 .staging-<tag>-XXXXXX 目录
+  StagingDir(const std::string &parent, const std::string &tag);
+  ~StagingDir();
+
+  StagingDir(const StagingDir &) = delete;
+  StagingDir &operator=(const StagingDir &) = delete;
+
+  bool valid() const { return !root.empty(); }
+  const std::string &path() const { return root; }
+  /// @brief 暂存区内的路径
+  std::string stagedPath(const std::string &relative) const;
+
+  /// @brief 登记提交时将暂存区内的 relative 发布为 dest（按登记顺序发布）
+  void publish(const std::string &relative, const std::string &dest);
+
+  /// @brief 落盘并发布全部登记条目，失败时已发布的条目被撤回
+  bool commit(std::string &error);
+  /// @brief 丢弃暂存区
+  void rollback();
+
+private:
+  struct Publication
+  {
+    std::string staged;
+    std::string dest;
+  };
+
+  std::string root;
+  std::vector<Publication> publications;
+};
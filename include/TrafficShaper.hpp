@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/// @brief 限速（bit/s），0 表示不限
+struct RateLimit
+{
+  uint64_t download = 0; // 发往客户端：tun 出方向，HTB 整形排队
+  uint64_t upload = 0;   // 来自客户端：tun 入方向，超速丢弃
+
+  bool empty() const { return download == 0 && upload == 0; }
+};
+
+/// @brief 一个需要限速的客户端
+struct ShapedClient
+{
+  uint32_t vpnIpv4 = 0; // 主机字节序
+  RateLimit limit;
+};
+
+/// @brief 把服务与客户端的限速生成 tc 批处理脚本
+/// @note  出方向为 HTB：服务限速时所有流量经 1:1 汇总，未限速的客户端落入默认类 1:ffff；
+///        每个客户端一个叶子类，类号取 VPN 地址低 16 位（服务端地址与广播地址不会是客户端，不与 1:1、1:ffff 冲突）。
+///        入方向为 ingress 上的 police，客户端超速丢弃，未超速的继续匹配服务的汇总限速。
+///        两个方向的分类都以 u32 哈希表按地址末字节分成 256 个桶，每个包只比较同一桶内的规则。
+///        脚本前 RESET_LINES 行删除设备上已有的 qdisc（不存在时失败，执行时忽略），其余各行均须成功。
+///        生成过程不访问系统，可离线比对输出。
+class TrafficShaper
+{
+public:
+  static const std::string MARKER; // ccd 与服务端配置中记录限速的注释前缀
+  static const int RESET_LINES = 2;
+
+  /// @brief 生成设备 device（子网 network/prefixLength）的批处理脚本，没有任何限速时只删除已有规则
+  static void buildBatch(const std::string &device, uint32_t network, int prefixLength, const RateLimit &serviceLimit,
+                         std::vector<ShapedClient> clients, std::string &script);
+
+  /// @brief 解析注释行 "# ovpn-mana rate <下行> <上行>"
+  static bool parseMarker(const std::string &comment, RateLimit &limit);
+  /// @brief 限速的注释行，不限速时为空串
+  static std::string marker(const RateLimit &limit);
+};
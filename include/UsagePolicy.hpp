@@ -0,0 +1,96 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+class ClientSnapshot;
+
+/// @brief 流量配额与空闲断开规则
+struct UsagePolicy
+{
+  uint64_t monthlyQuotaBytes = 0; // 每个客户端每月的收发流量上限，0 不限
+  int idleSeconds = 0;            // 持续空闲多久断开，0 不检查
+  uint64_t idleBytes = 64 * 1024; // 流量增长不超过该值视为空闲（keepalive 也计入字节数）
+  bool denyOverQuota = false;     // 超额后在 ccd 中写入 disable 拒绝重连，直到下月
+};
+
+/// @brief 单个客户端的累计用量（定长，直接保存到用量文件）
+struct UsageCounter
+{
+  char commonName[64];
+  uint32_t month;         // 年 * 12 + 月（本地时间）
+  uint32_t flags;
+  uint64_t monthBytes;    // 本月已结束会话的流量
+  uint64_t sessionBase;   // 当前会话在本月开始前已产生的流量
+  uint64_t sessionBytes;  // 当前会话最后一次看到的流量
+  uint64_t activityMark;  // 上次判定为活跃时的流量
+  int64_t sessionStart;   // 当前会话的连接时间
+  int64_t lastActivity;   // 上次判定为活跃的时间
+
+  static const uint32_t ONLINE = 1;
+  static const uint32_t DISABLED = 2; // 因超额由本引擎写入了 ccd disable
+  static const uint32_t KICKED = 4;   // 当前会话已要求断开，重新连接前不再重复
+
+  uint64_t usage() const { return monthBytes + sessionBytes - sessionBase; }
+};
+
+enum class PolicyAction
+{
+  Kick,    // 经管理接口断开
+  Disable, // 写入 ccd disable 并断开
+  Enable   // 新的月份开始，移除本引擎写入的 disable
+};
+
+enum class PolicyReason
+{
+  Quota,
+  Idle,
+  NewMonth
+};
+
+struct PolicyDecision
+{
+  std::string commonName;
+  PolicyAction action;
+  PolicyReason reason;
+  uint64_t usage;
+  bool applied = true; // 由执行方在动作未生效时置为 false
+};
+
+/// @brief 按客户端名称累计用量并评估配额与空闲规则
+/// @note  每个客户端一个定长计数器，以名称哈希表定位；每次评估遍历快照与计数器各一次，O(n)。
+///        重新连接（连接时间变化或计数回退）与下线时把上一会话的流量并入本月累计，跨月时清零，
+///        并移除上月之后再无会话的计数器。计数器保存在用量文件中，记录进程重启后继续累计。
+class UsageTracker
+{
+public:
+  explicit UsageTracker(const std::string &path);
+
+  /// @brief 读取用量文件，不存在时从空白开始
+  bool load();
+  /// @brief 写入临时文件后 rename 替换
+  bool save() const;
+
+  /// @brief 以快照更新计数器并给出需要执行的动作
+  void evaluate(const ClientSnapshot &snapshot, const UsagePolicy &policy, int64_t now,
+                std::vector<PolicyDecision> &decisions);
+  /// @brief 动作未生效时清除计数器上的标记（DISABLED、KICKED），下次评估重新给出该动作
+  void unmark(std::string_view commonName, uint32_t flags);
+  /// @brief 客户端本月的累计流量
+  bool usage(std::string_view commonName, uint64_t &bytes) const;
+
+  /// @brief 本地时间的 年 * 12 + 月
+  static uint32_t monthOf(int64_t epoch);
+
+private:
+  uint32_t counterFor(std::string_view commonName, uint32_t month, bool &created);
+  void rebuildIndex();
+
+  std::string path;
+  std::vector<UsageCounter> counters;
+  std::unordered_map<std::string_view, uint32_t> index; // 键引用 counters 中的名称，counters 重新分配后重建
+  std::vector<uint32_t> seen; // 与 counters 对应，最近一次出现在快照中的评估序号
+  uint32_t tick = 0;
+};
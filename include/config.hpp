@@ -6,4 +6,5 @@ const std::string EASY_RSA_DIR = "/home/xuwh/easy-rsa";
 const std::string OVPN_DIR = "/etc/openvpn";
 const std::string OPENVPN_BIN = "/usr/sbin/openvpn";
 const std::string SYSTEMCTL_BIN = "/bin/systemctl";
+const std::string TC_BIN = "/usr/sbin/tc";
 const std::string OVPN_SERVER_CONF_DIR = OVPN_DIR + "/server";
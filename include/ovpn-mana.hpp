@@ -45,8 +45,34 @@ extern "C"
   /// @param  count  服务数量
   /// @return  错误码
   /// @note    该函数会获取OpenVPN服务列表，并返回服务数量。服务列表中的每个服务包含名称、配置路径、是否激活和是否自启等信息。
+  /// @deprecated services 须能容纳全部服务，新代码使用 ovpn_mana_services_begin/next/end 或 ovpn_mana_visit_services
   LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_list_services(ovpn_mana_handle_t handle, ovpn_service_t *services, int &service_count);
 
+  /// @brief  开始枚举服务
+  /// @param  handle  句柄
+  /// @param  fields  需要查询的字段 OVPN_SERVICE_FIELD_*，只需名称时传 OVPN_SERVICE_FIELD_NAME 可跳过 systemctl 调用
+  /// @param  iter  迭代器，用毕须以 ovpn_mana_services_end 释放
+  /// @return  错误码
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_services_begin(ovpn_mana_handle_t handle, unsigned int fields, ovpn_service_iter_t *iter);
+
+  /// @brief  取下一个服务（状态在此时查询）
+  /// @param  iter  迭代器
+  /// @param  service  服务信息，字符串在下一次调用或 end 前有效
+  /// @return  错误码，没有更多服务时返回 OVPN_ERR_NOT_FOUND
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_services_next(ovpn_service_iter_t iter, ovpn_service_info_t *service);
+
+  /// @brief  结束枚举并释放迭代器
+  /// @param  iter  迭代器
+  LIB_API void LIB_API_CALL ovpn_mana_services_end(ovpn_service_iter_t iter);
+
+  /// @brief  以回调方式枚举服务
+  /// @param  handle  句柄
+  /// @param  fields  需要查询的字段 OVPN_SERVICE_FIELD_*
+  /// @param  visitor  回调，返回非 0 时停止枚举；service 仅在回调期间有效
+  /// @param  user_data  透传给回调的指针
+  /// @return  错误码
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_visit_services(ovpn_mana_handle_t handle, unsigned int fields, ovpn_service_visitor_t visitor, void *user_data);
+
   /// @brief  创建OpenVPN服务
   /// @param  handle  句柄
   /// @param  name  服务名称
@@ -55,6 +81,16 @@ extern "C"
   /// @note    该函数会创建一个OpenVPN服务，并返回错误码。服务名称和端口号必须合法。
   LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_create_service(ovpn_mana_handle_t handle, const char *name, const char* subnet, int port);
 
+  /// @brief  按参数创建OpenVPN服务
+  /// @param  handle  句柄
+  /// @param  name  服务名称
+  /// @param  subnet  子网，可写作 10.8.0.0 或 10.8.0.0/20
+  /// @param  port  服务端口
+  /// @param  options  创建参数（可为nullptr，使用默认值）
+  /// @return  错误码
+  /// @note    客户端地址由服务内的地址位图固定分配，每个服务最大支持 /16 子网。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_create_service_ex(ovpn_mana_handle_t handle, const char *name, const char *subnet, int port, const ovpn_service_options_t *options);
+
   /// @brief  启动OpenVPN服务
   /// @param  handle  句柄
   /// @param  name  服务名称
@@ -76,6 +112,14 @@ extern "C"
   /// @note    该函数会重启一个OpenVPN服务，并返回错误码。服务名称必须合法。
   LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_restart_service(ovpn_mana_handle_t handle, const char *name);
 
+  /// @brief  重载OpenVPN服务
+  /// @param  handle  句柄
+  /// @param  name  服务名称
+  /// @return  错误码
+  /// @note    向服务各实例发送 SIGHUP 重读配置，进程不退出，适用于 push、路由等服务端指令的变更；
+  ///          端口、协议变更仍需重启。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_reload_service(ovpn_mana_handle_t handle, const char *name);
+
   /// @brief  删除OpenVPN服务
   /// @param  handle  句柄
   /// @param  name  服务名称
@@ -83,6 +127,48 @@ extern "C"
   /// @note    该函数会删除一个OpenVPN服务，并返回错误码。服务名称必须合法。
   LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_delete_service(ovpn_mana_handle_t handle, const char *name);
 
+  /// @brief  批量启动/停止/重启服务
+  /// @param  handle  句柄
+  /// @param  pattern  服务名通配模式（fnmatch，如 "*"、"edge-*"）
+  /// @param  action  OVPN_BULK_START / OVPN_BULK_STOP / OVPN_BULK_RESTART
+  /// @param  options  执行参数（可为nullptr，使用默认值）
+  /// @param  results  各服务结果（按服务名排序）
+  /// @param  results_capacity  results 可容纳的条数
+  /// @param  result_count  匹配的服务数量（可能大于 results_capacity，超出部分不写入）
+  /// @return  错误码，全部成功返回 OVPN_ERR_SUCCESS，任一服务未成功返回 OVPN_ERR_FAILURE
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_bulk_service_op(ovpn_mana_handle_t handle, const char *pattern, int action, const ovpn_bulk_options_t *options, ovpn_bulk_result_t *results, int results_capacity, int &result_count);
+
+  /// @brief  获取服务监听端口（取自解析后的服务端配置，分片服务为首个分片端口）
+  /// @param  handle  句柄
+  /// @param  name  服务名称
+  /// @param  port  端口
+  /// @return  错误码，服务不存在返回 OVPN_ERR_NOT_FOUND
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_service_port(ovpn_mana_handle_t handle, const char *name, int &port);
+
+  /// @brief  获取服务协议（udp/tcp 等）
+  /// @param  handle  句柄
+  /// @param  name  服务名称
+  /// @param  proto  输出缓冲区
+  /// @param  proto_size  缓冲区大小
+  /// @return  错误码，缓冲区不足返回 OVPN_ERR_INVALID_PARAM
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_service_proto(ovpn_mana_handle_t handle, const char *name, char *proto, int proto_size);
+
+  /// @brief  获取服务子网（形如 10.8.0.0/24，分片服务为整个服务的子网）
+  /// @param  handle  句柄
+  /// @param  name  服务名称
+  /// @param  subnet  输出缓冲区
+  /// @param  subnet_size  缓冲区大小
+  /// @return  错误码，缓冲区不足返回 OVPN_ERR_INVALID_PARAM
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_service_subnet(ovpn_mana_handle_t handle, const char *name, char *subnet, int subnet_size);
+
+  /// @brief  获取服务数据通道加密套件（data-ciphers 协商列表或旧版 cipher）
+  /// @param  handle  句柄
+  /// @param  name  服务名称
+  /// @param  cipher  输出缓冲区
+  /// @param  cipher_size  缓冲区大小
+  /// @return  错误码，缓冲区不足返回 OVPN_ERR_INVALID_PARAM
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_service_cipher(ovpn_mana_handle_t handle, const char *name, char *cipher, int cipher_size);
+
   /// @brief  创建OpenVPN客户端
   /// @param  handle  句柄
   /// @param  service_name  服务名称
@@ -108,6 +194,145 @@ extern "C"
   /// @note    该函数会获取在线OpenVPN客户端列表，并返回客户端数量。客户端列表中的每个客户端包含名称、VPN IP、真实 IP、上线时间、接收字节数和发送字节数等信息。
   LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_online_clients(ovpn_mana_handle_t handle, const char *service_name, ovpn_client_t *clients, int &client_count);
 
+  /// @brief  以列式表导出在线客户端
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  table  输出的列式表，用毕须以 ovpn_mana_free_client_table 释放
+  /// @return  错误码
+  /// @note    地址与时间为数值，名称集中在字符串表中，每个客户端约 60 字节（ovpn_client_t 为 352 字节），
+  ///          按列排序、筛选只需访问对应的列。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_client_table(ovpn_mana_handle_t handle, const char *service_name, ovpn_client_table_t **table);
+
+  /// @brief  释放列式表
+  /// @param  table  ovpn_mana_get_client_table 返回的表
+  LIB_API void LIB_API_CALL ovpn_mana_free_client_table(ovpn_client_table_t *table);
+
+  /// @brief  获取自指定版本以来在线客户端的变化
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  since_version  上次返回的 version，首次调用传 0
+  /// @param  delta  输出的增量，用毕须以 ovpn_mana_free_client_delta 释放
+  /// @return  错误码
+  /// @note    每个服务保留最近 8 个版本的快照，起始版本已移出历史时返回全量（full 为 1）。
+  ///          结果大小与变化的客户端数成正比，与在线总数无关。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_online_clients_since(ovpn_mana_handle_t handle, const char *service_name, unsigned long long since_version, ovpn_client_delta_t **delta);
+
+  /// @brief  释放增量
+  /// @param  delta  ovpn_mana_get_online_clients_since 返回的增量
+  LIB_API void LIB_API_CALL ovpn_mana_free_client_delta(ovpn_client_delta_t *delta);
+
+  /// @brief  把在线客户端表发布到共享内存
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  version  已发布的快照版本，可为 NULL
+  /// @return  错误码
+  /// @note    每台主机每个服务只应有一个发布进程（openvpnmgr service -publish），定期调用；
+  ///          状态文件未变化时不重写共享内存。其他进程以 ovpn_mana_shared_clients_open 读取，无需解析状态文件。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_publish_clients(ovpn_mana_handle_t handle, const char *service_name, unsigned long long *version);
+
+  /// @brief  只读映射服务的共享内存客户端表，不需要管理器句柄与 root 权限
+  /// @param  service_name  服务名称
+  /// @param  reader  读端
+  /// @return  错误码，没有发布进程（或发布进程已退出）时返回 OVPN_ERR_NOT_FOUND
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_shared_clients_open(const char *service_name, ovpn_shared_clients_t *reader);
+
+  /// @brief  从共享内存读取一致的在线客户端表
+  /// @param  reader  读端
+  /// @param  clients  输出缓冲区，可为 NULL
+  /// @param  clients_capacity  缓冲区可容纳的客户端数
+  /// @param  client_count  在线客户端数量（可能大于 clients_capacity，超出部分不写入）
+  /// @param  version  发布的快照版本，可为 NULL
+  /// @return  错误码，尚未发布时返回 OVPN_ERR_NOT_FOUND，发布过于频繁无法取得一致视图时返回 OVPN_ERR_TIMEOUT
+  /// @note    直接读共享内存，不做系统调用也不解析文件。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_shared_clients_read(ovpn_shared_clients_t reader, ovpn_client_t *clients, int clients_capacity, int &client_count, unsigned long long *version);
+
+  /// @brief  关闭读端
+  LIB_API void LIB_API_CALL ovpn_mana_shared_clients_close(ovpn_shared_clients_t reader);
+
+  /// @brief  把自上次调用以来结束的会话追加到服务的会话日志
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  recorded  本次追加的会话数，可为 NULL
+  /// @return  错误码
+  /// @note    以前后两次快照的差异判断下线与重新连接，应由唯一的记录进程定期调用（service -publish 每次检查时调用）；
+  ///          记录进程未运行期间结束的会话不会被记录。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_record_sessions(ovpn_mana_handle_t handle, const char *service_name, int *recorded);
+
+  /// @brief  查询与 [from, to) 有交集的历史会话
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  common_name  客户端名称，NULL 或空串表示全部
+  /// @param  from  起始时间（epoch 秒）
+  /// @param  to  结束时间（epoch 秒，不含）
+  /// @param  sessions  输出缓冲区，可为 NULL
+  /// @param  sessions_capacity  缓冲区可容纳的会话数
+  /// @param  session_count  匹配的会话数（可能大于 sessions_capacity，超出部分不写入）
+  /// @return  错误码
+  /// @note    按稀疏索引（每 256 条记录的时间范围与名称布隆过滤器）跳过无关的块。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_query_sessions(ovpn_mana_handle_t handle, const char *service_name, const char *common_name, long long from, long long to, ovpn_session_t *sessions, int sessions_capacity, int &session_count);
+
+  /// @brief  汇总与 [from, to) 有交集的历史会话（按整次会话计）
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  common_name  客户端名称，NULL 或空串表示全部
+  /// @param  from  起始时间（epoch 秒）
+  /// @param  to  结束时间（epoch 秒，不含）
+  /// @param  totals  汇总结果
+  /// @return  错误码
+  /// @note    不限定客户端时，完全落在范围内的块直接使用索引中的汇总。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_aggregate_sessions(ovpn_mana_handle_t handle, const char *service_name, const char *common_name, long long from, long long to, ovpn_session_totals_t *totals);
+
+  /// @brief  累计各客户端本月的流量并执行配额与空闲规则
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  policy  规则
+  /// @param  actions  输出缓冲区，可为 NULL
+  /// @param  actions_capacity  缓冲区可容纳的动作数
+  /// @param  action_count  本次执行的动作数（可能大于 actions_capacity，超出部分不写入）
+  /// @return  错误码，部分动作执行失败时返回 OVPN_ERR_FAILURE，action_count 仍有效，失败的动作 applied 为 0
+  /// @note    应由唯一的执行进程定期调用（service -publish 带 --quota 或 --idle 时每次检查调用）。
+  ///          流量跨重新连接按客户端名称累计，计数器保存在 /etc/openvpn/ovpn-mana/usage/<服务名>.usage；
+  ///          每次调用遍历快照与计数器各一次。未开启管理接口的早期服务无法断开：断开动作报告为未生效并在下次调用重试，超额拒绝在客户端重连时生效。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_enforce_policy(ovpn_mana_handle_t handle, const char *service_name, const ovpn_usage_policy_t *policy, ovpn_policy_action_t *actions, int actions_capacity, int &action_count);
+
+  /// @brief  查询客户端本月的累计流量
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  common_name  客户端名称
+  /// @param  bytes  累计的收发字节数
+  /// @return  错误码，没有记录返回 OVPN_ERR_NOT_FOUND
+  /// @note    读取用量文件，执行进程未写入的最近一段时间（至多 60 秒）不计入。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_client_usage(ovpn_mana_handle_t handle, const char *service_name, const char *common_name, unsigned long long *bytes);
+
+  /// @brief  查询单个客户端是否在线
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  name  客户端名称（证书通用名）
+  /// @param  client  在线时返回客户端信息
+  /// @return  错误码，不在线返回 OVPN_ERR_NOT_FOUND
+  /// @note    快照按名称建有哈希索引，状态文件未更新时不解析、不做系统调用。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_online_client(ovpn_mana_handle_t handle, const char *service_name, const char *name, ovpn_client_t *client);
+
+  /// @brief  在全部服务中查找在线客户端
+  /// @param  handle  句柄
+  /// @param  name  客户端名称（证书通用名）
+  /// @param  service_name  返回客户端所在的服务名称
+  /// @param  service_name_size  service_name 缓冲区大小
+  /// @param  client  返回客户端信息，可为 NULL
+  /// @return  错误码，不在线返回 OVPN_ERR_NOT_FOUND，缓冲区不足返回 OVPN_ERR_INVALID_PARAM
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_find_online_client(ovpn_mana_handle_t handle, const char *name, char *service_name, int service_name_size, ovpn_client_t *client);
+
+  /// @brief  按条件查询在线客户端
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  query  查询条件，NULL 表示全部客户端按连接时间排序
+  /// @param  clients  结果缓冲区
+  /// @param  clients_capacity  clients 可容纳的条数
+  /// @param  client_count  结果数量（可能大于 clients_capacity，超出部分不写入）
+  /// @return  错误码，地址段格式错误返回 OVPN_ERR_INVALID_PARAM
+  /// @note    筛选在库内完成，指定 limit 时只对前 K 个做部分排序。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_query_online_clients(ovpn_mana_handle_t handle, const char *service_name, const ovpn_client_query_t *query, ovpn_client_t *clients, int clients_capacity, int &client_count);
+
   /// @brief  获取总客户端数量
   /// @param  handle  句柄
   /// @param  service_name  服务名称
@@ -126,6 +351,90 @@ extern "C"
   /// @note    该函数会返回指定OpenVPN客户端配置文件内容，并返回配置文件大小。客户端名称和服务名称必须合法。
   LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_client_config(ovpn_mana_handle_t handle, const char *service_name, const char *name, char *ovpn_file, int &ovpn_file_size);
 
+  /// @brief  检测数据通道卸载（ovpn-dco）可用性
+  /// @param  handle  句柄
+  /// @param  module_loaded  内核模块是否已加载
+  /// @param  openvpn_support  OpenVPN 是否支持 DCO（2.6+ 且带 [DCO] 编译特性）
+  /// @return  错误码
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_detect_dco(ovpn_mana_handle_t handle, int &module_loaded, int &openvpn_support);
+
+  /// @brief  设置服务的汇总限速
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  limit  限速，两个方向均为 0 时移除
+  /// @return  错误码
+  /// @note    记录在各实例服务端配置的注释中，分片服务按实例数平分；调用 ovpn_mana_apply_shaping 后生效。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_set_service_rate(ovpn_mana_handle_t handle, const char *service_name, const ovpn_rate_limit_t *limit);
+
+  /// @brief  设置客户端限速
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  common_name  客户端名称
+  /// @param  limit  限速，两个方向均为 0 时移除
+  /// @return  错误码
+  /// @note    记录在 ccd/<client> 的注释中；批量修改后调用一次 ovpn_mana_apply_shaping 生效。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_set_client_rate(ovpn_mana_handle_t handle, const char *service_name, const char *common_name, const ovpn_rate_limit_t *limit);
+
+  /// @brief  按已设置的限速重建服务 tun 设备上的 tc 规则
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @return  错误码
+  /// @note    每个设备一次 tc -batch，出方向为按 VPN 地址分类的 HTB，入方向为 police；未运行的实例跳过。
+  ///          实例重启后 tun 设备重建，规则须再次应用；没有固定地址的客户端按当前在线地址限速。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_apply_shaping(ovpn_mana_handle_t handle, const char *service_name);
+
+  /// @brief  生成服务的 tc 批处理脚本而不执行
+  /// @param  handle  句柄
+  /// @param  service_name  服务名称
+  /// @param  script  输出缓冲区，可为 NULL
+  /// @param  script_size  缓冲区大小
+  /// @param  script_length  脚本长度（不含结尾 '\0'），缓冲区不足时返回 OVPN_ERR_INVALID_PARAM
+  /// @return  错误码
+  /// @note    各实例的脚本以 "# <设备名>" 注释行分隔，可直接交给 tc -batch，也可用于离线比对。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_build_shaping(ovpn_mana_handle_t handle, const char *service_name, char *script, int script_size, int &script_length);
+
+  /// @brief  设置算法的预生成私钥池
+  /// @param  handle  句柄
+  /// @param  key_algo  算法 OVPN_KEY_*
+  /// @param  options  池设置，size 为 0 时停用
+  /// @return  错误码
+  /// @note    启用后 ovpn_mana_create_client 优先取用池中的密钥（每把只用一次），只生成请求并签发，
+  ///          池为空时回退为 easy-rsa 现场生成。密钥以 0600 保存在 OVPN_DIR/ovpn-mana/keypool/<算法>/。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_configure(ovpn_mana_handle_t handle, int key_algo, const ovpn_key_pool_options_t *options);
+
+  /// @brief  获取预生成私钥池的统计
+  /// @param  handle  句柄
+  /// @param  key_algo  算法 OVPN_KEY_*
+  /// @param  stats  输出统计
+  /// @return  错误码
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_stats(ovpn_mana_handle_t handle, int key_algo, ovpn_key_pool_stats_t *stats);
+
+  /// @brief  销毁过期密钥并立即补充到目标数量
+  /// @param  handle  句柄
+  /// @param  key_algo  算法 OVPN_KEY_*
+  /// @param  generated  本次生成的数量
+  /// @return  错误码
+  /// @note    同步执行，RSA 每把约数百毫秒；常驻进程可改用 ovpn_mana_key_pool_start 在后台补充。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_fill(ovpn_mana_handle_t handle, int key_algo, int &generated);
+
+  /// @brief  销毁池中全部未使用的密钥
+  /// @param  handle  句柄
+  /// @param  key_algo  算法 OVPN_KEY_*
+  /// @param  destroyed  销毁的数量
+  /// @return  错误码
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_drain(ovpn_mana_handle_t handle, int key_algo, int &destroyed);
+
+  /// @brief  在本进程启动后台补充线程
+  /// @param  handle  句柄
+  /// @param  interval_seconds  检查间隔（秒），每次取用后也会立即检查
+  /// @return  错误码
+  /// @note    可用数量低于低水位时补充到目标数量；句柄销毁前应调用 ovpn_mana_key_pool_stop。
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_start(ovpn_mana_handle_t handle, int interval_seconds);
+
+  /// @brief  停止后台补充线程（等待正在进行的生成完成）
+  /// @param  handle  句柄
+  /// @return  错误码
+  LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_stop(ovpn_mana_handle_t handle);
 
 #ifdef __cplusplus
 }
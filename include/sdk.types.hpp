@@ -6,6 +6,9 @@ typedef int ovpn_err_t;
 
 typedef void* ovpn_mana_handle_t;
 
+typedef void* ovpn_service_iter_t;
+typedef void* ovpn_shared_clients_t;
+
 
 typedef struct {
 
@@ -14,7 +17,52 @@ typedef struct {
     int is_activated;          // 是否激活
     int is_enabled;         // 是否自启
 
-} ovpn_service_t;
+} ovpn_service_t; // 布局保持不变以兼容已有调用方，新增字段只在 ovpn_service_info_t 中提供
+
+
+/* 枚举服务时返回的服务信息，字符串指向库内缓冲区，仅在下一次 next/回调返回前有效 */
+typedef struct {
+
+    const char *name;          // 服务名称
+    const char *config_path;   // 配置路径（分片服务为首个分片）
+    int shard_count;           // 分片数量（非分片服务为1）
+    int is_activated;          // 是否激活（OVPN_SERVICE_FIELD_STATE）
+    int active_shards;         // 活跃的分片数量（OVPN_SERVICE_FIELD_STATE）
+    int is_enabled;            // 是否自启（OVPN_SERVICE_FIELD_ENABLED）
+    int dco_active;            // 数据通道是否由内核 ovpn-dco 承载（OVPN_SERVICE_FIELD_DCO）
+
+} ovpn_service_info_t;
+
+/* 服务枚举回调，返回非 0 时停止枚举 */
+typedef int (*ovpn_service_visitor_t)(const ovpn_service_info_t *service, void *user_data);
+
+
+typedef struct {
+
+    int prefix_length;      // 子网前缀长度（16~29，0 表示默认 24）
+    int shards;             // 分片数量（2的幂，0 或 1 表示不分片）
+    char profile[32];       // 性能档案名（default/throughput/latency/low-power-clients，空串为 default）
+    int dco_mode;           // 数据通道卸载模式 OVPN_DCO_*
+    int key_algo;           // 证书与密钥算法 OVPN_KEY_*（0 为 RSA）
+
+} ovpn_service_options_t;
+
+
+typedef struct {
+
+    int concurrency;        // 同时操作的服务数上限（0 表示默认 8）
+    int max_unavailable;    // >0 时为滚动模式：同时不可用的服务数上限，逐个恢复健康后继续
+    int health_timeout_ms;  // 滚动模式等待恢复健康的时间（0 表示默认 30000）
+
+} ovpn_bulk_options_t;
+
+
+typedef struct {
+
+    char name[64];          // 服务名称
+    int status;             // OVPN_BULK_*
+
+} ovpn_bulk_result_t;
 
 
 typedef struct {
@@ -28,6 +76,180 @@ typedef struct {
 
 } ovpn_client_t;
 
+
+/* 在线客户端列式表：各列为长度 count 的数组，与表头同一块内存，由 ovpn_mana_free_client_table 释放 */
+typedef struct {
+
+    int count;                                // 客户端数量，按连接时间升序
+    int strings_size;                         // 字符串表字节数
+    const char *strings;                      // 名称字符串表，各名称以 '\0' 结尾
+    const unsigned int *name;                 // 名称在 strings 中的偏移
+    const unsigned char *real_family;         // 真实地址族 4/6，未知为 0
+    const unsigned short *real_port;          // 真实端口
+    const unsigned char (*real_addr)[16];     // 真实地址（网络字节序，IPv4 占前 4 字节）
+    const unsigned int *vpn_ipv4;             // VPN IPv4（主机字节序），0 表示未分配
+    const long long *connected_since;         // 连接时间（epoch 秒）
+    const unsigned long long *bytes_received; // 接收字节数
+    const unsigned long long *bytes_sent;     // 发送字节数
+
+} ovpn_client_table_t;
+
+
+/* 在线客户端增量：各数组与表头同一块内存，由 ovpn_mana_free_client_delta 释放 */
+typedef struct {
+
+    unsigned long long version;   // 当前版本，下次调用时传入
+    int full;                     // 1 表示全量：起始版本无效或已过期，added 为全部在线客户端，调用方应先清空本地列表
+    int added_count;              // 新上线的客户端数量
+    int updated_count;            // 字节计数、地址或连接时间变化的客户端数量
+    int removed_count;            // 已下线的客户端数量
+    const ovpn_client_t *added;
+    const ovpn_client_t *updated;
+    const char (*removed)[128];   // 已下线的客户端名称
+
+} ovpn_client_delta_t;
+
+
+/* 已结束的客户端会话 */
+typedef struct {
+
+    char common_name[64];              // 客户端名称
+    char private_ipv4[32];             // VPN IP地址
+    char public_ipv4[64];              // 实际IP地址
+    long long start;                   // 连接时间（epoch 秒）
+    long long end;                     // 断开时间（epoch 秒）
+    unsigned long long bytes_received; // 接收字节数
+    unsigned long long bytes_sent;     // 发送字节数
+
+} ovpn_session_t;
+
+
+/* 会话汇总 */
+typedef struct {
+
+    unsigned long long sessions;       // 会话数
+    unsigned long long duration;       // 总时长（秒）
+    unsigned long long bytes_received; // 接收字节数
+    unsigned long long bytes_sent;     // 发送字节数
+
+} ovpn_session_totals_t;
+
+
+/* 流量配额与空闲断开规则 */
+typedef struct {
+
+    unsigned long long monthly_quota_bytes; // 每个客户端每月的收发流量上限，0 不限
+    int idle_seconds;                       // 持续空闲多久断开，0 不检查
+    unsigned long long idle_bytes;          // 流量增长不超过该值视为空闲，0 表示默认 65536
+    int deny_over_quota;                    // 非 0 时超额后在 ccd 中写入 disable，直到下月
+
+} ovpn_usage_policy_t;
+
+
+/* 执行规则时采取的动作 */
+typedef struct {
+
+    char common_name[64];              // 客户端名称
+    int action;                        // OVPN_POLICY_*
+    int reason;                        // OVPN_POLICY_REASON_*
+    unsigned long long usage;          // 客户端本月的累计流量
+    int applied;                       // 动作已生效为 1；未能执行（如早期服务没有管理接口）为 0，下次调用重试
+
+} ovpn_policy_action_t;
+
+
+/* 限速，0 表示该方向不限 */
+typedef struct {
+
+    unsigned long long download_bps; // 发往客户端（bit/s），HTB 整形
+    unsigned long long upload_bps;   // 来自客户端（bit/s），超速丢弃
+
+} ovpn_rate_limit_t;
+
+
+/* 预生成私钥池设置（按算法，跨进程生效） */
+typedef struct {
+
+    unsigned int size;             // 补充的目标数量，0 表示停用
+    unsigned int low_water;        // 可用数量低于该值时后台补充，0 取 size / 4
+    unsigned int max_age_seconds;  // 超过该时长未被取用的密钥在补充时销毁，0 不限
+    int shred;                     // 非 0 时销毁与取用后先以零覆盖文件内容再删除
+
+} ovpn_key_pool_options_t;
+
+
+/* 预生成私钥池统计 */
+typedef struct {
+
+    unsigned int available;        // 当前可用的密钥数
+    unsigned long long hits;       // 签发时从池中取到密钥
+    unsigned long long misses;     // 池已启用但为空或取出的密钥签发失败，回退为现场生成
+    unsigned long long generated;  // 累计预生成的密钥数
+    unsigned long long destroyed;  // 过期或清空时销毁的密钥数
+
+} ovpn_key_pool_stats_t;
+
+
+/* 在线客户端查询条件，字符串为 NULL 或空串时不参与筛选 */
+typedef struct {
+
+    const char *name_prefix;          // 名称前缀
+    const char *real_cidr;            // 真实地址段，如 203.0.113.0/24
+    const char *vpn_cidr;             // VPN 地址段，如 10.8.0.0/25
+    unsigned long long min_bytes;     // 收发字节合计下限
+    long long connected_after;        // 连接时间不早于（epoch 秒）
+    int sort_by;                      // OVPN_CLIENT_SORT_*
+    int descending;                   // 非 0 为降序
+    int limit;                        // 返回条数上限（top-K），0 表示不限
+
+} ovpn_client_query_t;
+
+/* 数据通道卸载模式 */
+#define OVPN_DCO_AUTO 0      // 可用时启用，否则回退到用户态
+#define OVPN_DCO_OFF 1       // 始终使用用户态
+#define OVPN_DCO_REQUIRED 2  // 不可用时创建失败
+
+/* 证书与密钥算法 */
+#define OVPN_KEY_RSA 0       // easy-rsa 默认，使用 dh.pem
+#define OVPN_KEY_EC_P256 1   // ECDSA P-256，dh none + ecdh-curve prime256v1
+#define OVPN_KEY_EC_P384 2   // ECDSA P-384，dh none + ecdh-curve secp384r1
+#define OVPN_KEY_ED25519 3   // Ed25519，dh none + tls-groups X25519（OpenVPN 2.5+）
+
+/* 枚举服务时按需查询的字段，名称、配置路径与分片数量始终返回 */
+#define OVPN_SERVICE_FIELD_NAME 0x0      // 仅登记信息，不调用 systemctl
+#define OVPN_SERVICE_FIELD_STATE 0x1     // 活跃状态
+#define OVPN_SERVICE_FIELD_ENABLED 0x2   // 自启状态
+#define OVPN_SERVICE_FIELD_DCO 0x4       // DCO 承载状态（隐含 STATE）
+#define OVPN_SERVICE_FIELD_ALL 0x7
+
+/* 在线客户端排序键 */
+#define OVPN_CLIENT_SORT_SINCE 0
+#define OVPN_CLIENT_SORT_NAME 1
+#define OVPN_CLIENT_SORT_BYTES_RECEIVED 2
+#define OVPN_CLIENT_SORT_BYTES_SENT 3
+#define OVPN_CLIENT_SORT_BYTES_TOTAL 4
+
+/* 批量操作 */
+#define OVPN_BULK_START 0
+#define OVPN_BULK_STOP 1
+#define OVPN_BULK_RESTART 2
+
+/* 批量操作中单个服务的结果 */
+#define OVPN_BULK_SUCCEEDED 0
+#define OVPN_BULK_FAILED 1
+#define OVPN_BULK_UNHEALTHY 2   // 操作完成但未在期限内恢复健康
+#define OVPN_BULK_SKIPPED 3     // 滚动模式中因前序失败而未执行
+
+/* 规则动作 */
+#define OVPN_POLICY_KICK 0      // 经管理接口断开
+#define OVPN_POLICY_DISABLE 1   // 写入 ccd disable 并断开
+#define OVPN_POLICY_ENABLE 2    // 新的月份开始，移除 disable
+
+/* 规则动作的原因 */
+#define OVPN_POLICY_REASON_QUOTA 0
+#define OVPN_POLICY_REASON_IDLE 1
+#define OVPN_POLICY_REASON_NEW_MONTH 2
+
 /* 错误码 */
 #define OVPN_ERR_SUCCESS 0
 #define OVPN_ERR_FAILURE -1
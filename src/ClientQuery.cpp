@@ -0,0 +1,141 @@
+#include "ClientQuery.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <arpa/inet.h>
+
+bool AddressRange::parse(const std::string &text, AddressRange &range)
+{
+  std::string address = text;
+  int prefix = -1;
+  size_t slash = text.find('/');
+  if (slash != std::string::npos)
+  {
+    address = text.substr(0, slash);
+    char *end = nullptr;
+    long value = strtol(text.c_str() + slash + 1, &end, 10);
+    if (!end || *end != '\0' || end == text.c_str() + slash + 1)
+      return false;
+    prefix = static_cast<int>(value);
+  }
+
+  AddressRange parsed;
+  if (inet_pton(AF_INET, address.c_str(), parsed.addr) == 1)
+    parsed.family = 4;
+  else if (inet_pton(AF_INET6, address.c_str(), parsed.addr) == 1)
+    parsed.family = 6;
+  else
+    return false;
+
+  const int maxPrefix = parsed.family == 4 ? 32 : 128;
+  if (prefix < 0)
+    prefix = maxPrefix;
+  if (prefix > maxPrefix)
+    return false;
+  parsed.prefixLength = prefix;
+  range = parsed;
+  return true;
+}
+
+bool AddressRange::contains(uint8_t otherFamily, const uint8_t other[16]) const
+{
+  if (family == 0)
+    return true;
+  if (otherFamily != family)
+    return false;
+  int full = prefixLength / 8;
+  if (memcmp(addr, other, full) != 0)
+    return false;
+  int bits = prefixLength % 8;
+  if (bits == 0)
+    return true;
+  uint8_t mask = static_cast<uint8_t>(0xFF << (8 - bits));
+  return (addr[full] & mask) == (other[full] & mask);
+}
+
+bool ClientQuery::matches(const ClientSnapshot &snapshot, const OnlineClient &client) const
+{
+  if (!namePrefix.empty() && snapshot.name(client).compare(0, namePrefix.size(), namePrefix) != 0)
+    return false;
+  if (client.connectedSince < connectedAfter)
+    return false;
+  if (client.bytesReceived + client.bytesSent < minBytes)
+    return false;
+  if (!realRange.contains(client.realFamily, client.realAddr))
+    return false;
+  if (vpnRange.family == 4)
+  {
+    uint8_t vpn[16] = {};
+    uint32_t networkOrder = htonl(client.vpnIpv4);
+    memcpy(vpn, &networkOrder, sizeof(networkOrder));
+    if (client.vpnIpv4 == 0 || !vpnRange.contains(4, vpn))
+      return false;
+  }
+  else if (vpnRange.family == 6 && (!client.hasVpnIpv6 || !vpnRange.contains(6, client.vpnIpv6)))
+  {
+    return false;
+  }
+  return true;
+}
+
+std::vector<uint32_t> ClientQuery::run(const ClientSnapshot &snapshot) const
+{
+  std::vector<uint32_t> result;
+  for (size_t i = 0; i < snapshot.size(); ++i)
+  {
+    if (matches(snapshot, snapshot[i]))
+      result.push_back(static_cast<uint32_t>(i));
+  }
+
+  // 快照已按连接时间升序，该排序键下直接截取
+  if (sortKey == ClientSortKey::ConnectedSince)
+  {
+    if (descending)
+      std::reverse(result.begin(), result.end());
+    if (limit > 0 && result.size() > limit)
+      result.resize(limit);
+    return result;
+  }
+
+  auto key = [&](uint32_t index) -> uint64_t
+  {
+    const OnlineClient &client = snapshot[index];
+    switch (sortKey)
+    {
+    case ClientSortKey::BytesReceived:
+      return client.bytesReceived;
+    case ClientSortKey::BytesSent:
+      return client.bytesSent;
+    default:
+      return client.bytesReceived + client.bytesSent;
+    }
+  };
+  // 相同键按下标（即连接时间）保持稳定顺序
+  auto less = [&](uint32_t a, uint32_t b)
+  {
+    if (sortKey == ClientSortKey::Name)
+    {
+      int cmp = snapshot.name(snapshot[a]).compare(snapshot.name(snapshot[b]));
+      if (cmp != 0)
+        return descending ? cmp > 0 : cmp < 0;
+    }
+    else
+    {
+      uint64_t ka = key(a), kb = key(b);
+      if (ka != kb)
+        return descending ? ka > kb : ka < kb;
+    }
+    return a < b;
+  };
+
+  if (limit > 0 && result.size() > limit)
+  {
+    std::partial_sort(result.begin(), result.begin() + limit, result.end(), less);
+    result.resize(limit);
+  }
+  else
+  {
+    std::sort(result.begin(), result.end(), less);
+  }
+  return result;
+}
@@ -0,0 +1,520 @@
+#include "ClientSnapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+
+namespace
+{
+  // 逗号分隔的下一个字段
+  std::string_view nextField(std::string_view &line)
+  {
+    size_t comma = line.find(',');
+    std::string_view field = line.substr(0, comma);
+    line = comma == std::string_view::npos ? std::string_view() : line.substr(comma + 1);
+    return field;
+  }
+
+  bool parseUint64(std::string_view text, uint64_t &value)
+  {
+    if (text.empty())
+      return false;
+    value = 0;
+    for (char c : text)
+    {
+      if (c < '0' || c > '9')
+        return false;
+      value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+  }
+
+  bool parseNumber(std::string_view text, int &value)
+  {
+    uint64_t parsed = 0;
+    if (text.size() > 9 || !parseUint64(text, parsed))
+      return false;
+    value = static_cast<int>(parsed);
+    return true;
+  }
+
+  bool parseAddressText(std::string_view text, uint8_t &family, uint8_t addr[16])
+  {
+    char buf[INET6_ADDRSTRLEN];
+    if (text.empty() || text.size() >= sizeof(buf))
+      return false;
+    memcpy(buf, text.data(), text.size());
+    buf[text.size()] = '\0';
+    memset(addr, 0, 16);
+    if (inet_pton(AF_INET, buf, addr) == 1)
+    {
+      family = 4;
+      return true;
+    }
+    if (inet_pton(AF_INET6, buf, addr) == 1)
+    {
+      family = 6;
+      return true;
+    }
+    return false;
+  }
+
+  // 本地时间转 epoch：按 (年, 月, 日, 时) 缓存 mktime 的结果，同一小时内的时间只需加上分秒
+  // （状态文件中的连接时间集中在少数几天内，直接映射的小表即可覆盖）
+  struct LocalClock
+  {
+    struct Entry
+    {
+      int32_t key = -1;
+      int64_t hourBase = 0;
+    };
+    Entry entries[64];
+
+    bool toEpoch(int y, int mon, int d, int h, int mi, int s, int64_t &epoch)
+    {
+      if (y < 1970 || y > 9999 || mon < 1 || mon > 12 || d < 1 || d > 31 || h > 23 || mi > 59 || s > 60)
+        return false;
+      const int32_t key = ((y * 12 + mon - 1) * 31 + d - 1) * 24 + h;
+      Entry &entry = entries[key & 63];
+      if (entry.key != key)
+      {
+        struct tm tm = {};
+        tm.tm_year = y - 1900;
+        tm.tm_mon = mon - 1;
+        tm.tm_mday = d;
+        tm.tm_hour = h;
+        tm.tm_isdst = -1;
+        time_t value = mktime(&tm);
+        if (value == static_cast<time_t>(-1))
+          return false;
+        entry.key = key;
+        entry.hourBase = value;
+      }
+      epoch = entry.hourBase + mi * 60 + s;
+      return true;
+    }
+  };
+
+  bool parseClock(std::string_view text, int &h, int &mi, int &s)
+  {
+    return text.size() == 8 && text[2] == ':' && text[5] == ':' && parseNumber(text.substr(0, 2), h) &&
+           parseNumber(text.substr(3, 2), mi) && parseNumber(text.substr(6, 2), s);
+  }
+
+  // 下一个以空白分隔的单词
+  std::string_view nextWord(std::string_view &text)
+  {
+    size_t start = text.find_first_not_of(' ');
+    if (start == std::string_view::npos)
+      return text = std::string_view();
+    size_t end = text.find(' ', start);
+    std::string_view word = text.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+    text = end == std::string_view::npos ? std::string_view() : text.substr(end);
+    return word;
+  }
+
+  // FNV-1a
+  uint64_t hashName(std::string_view name)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : name)
+    {
+      hash ^= c;
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  size_t roundUpPowerOfTwo(size_t value)
+  {
+    size_t capacity = 8;
+    while (capacity < value)
+      capacity <<= 1;
+    return capacity;
+  }
+}
+
+ClientSnapshot::ClientSnapshot(size_t arenaHint)
+    : arena(std::max<size_t>(arenaHint, 4096)), clients(&arena), slots(&arena)
+{
+}
+
+// 先按文件大小预估分配区容量（文本本身、约每 140 字节文本一条记录及索引），再把文件直接读入分配区
+std::shared_ptr<const ClientSnapshot> ClientSnapshot::load(const std::vector<std::string> &statusFiles)
+{
+  std::vector<int> fds;
+  size_t total = 0;
+  for (const auto &path : statusFiles)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0)
+      continue;
+    if (fstat(fd, &st) != 0)
+    {
+      close(fd);
+      continue;
+    }
+    total += static_cast<size_t>(st.st_size);
+    fds.push_back(fd);
+  }
+
+  auto snapshot = std::make_shared<ClientSnapshot>(total * 2 + 4096);
+  for (int fd : fds)
+  {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      size_t capacity = static_cast<size_t>(st.st_size);
+      char *buffer = static_cast<char *>(snapshot->arena.allocate(capacity, 1));
+      size_t length = 0;
+      while (length < capacity)
+      {
+        ssize_t n = read(fd, buffer + length, capacity - length);
+        if (n <= 0)
+          break;
+        length += static_cast<size_t>(n);
+      }
+      snapshot->parseBuffer(buffer, length);
+    }
+    close(fd);
+  }
+  snapshot->finish();
+  return snapshot;
+}
+
+void ClientSnapshot::parse(std::string_view text)
+{
+  char *buffer = static_cast<char *>(arena.allocate(std::max<size_t>(text.size(), 1), 1));
+  memcpy(buffer, text.data(), text.size());
+  parseBuffer(buffer, text.size());
+}
+
+// status-version 1：CLIENT LIST 段为 "Common Name,Real Address,Bytes Received,Bytes Sent,Connected Since"，
+// ROUTING TABLE 段为 "Virtual Address,Common Name,Real Address,Last Ref"
+void ClientSnapshot::parseBuffer(const char *data, size_t size)
+{
+  // 每个客户端在两个段中各占一行，按行数预留记录与索引容量
+  size_t lines = 0;
+  for (const char *p = data, *end = data + size; (p = static_cast<const char *>(memchr(p, '\n', end - p))); ++p)
+    ++lines;
+  const size_t expected = clients.size() + lines / 2 + 1;
+  clients.reserve(expected);
+  if (slots.size() < expected * 2)
+    rebuildIndex(roundUpPowerOfTwo(expected * 2));
+
+  enum class Section
+  {
+    None,
+    Clients,
+    Routing
+  } section = Section::None;
+
+  std::string_view text(data, size);
+  size_t pos = 0;
+  while (pos < text.size())
+  {
+    size_t eol = text.find('\n', pos);
+    if (eol == std::string_view::npos)
+      eol = text.size();
+    std::string_view line = text.substr(pos, eol - pos);
+    pos = eol + 1;
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    if (line.empty())
+      continue;
+
+    if (line == "OpenVPN CLIENT LIST")
+    {
+      section = Section::Clients;
+      continue;
+    }
+    if (line == "ROUTING TABLE")
+    {
+      section = Section::Routing;
+      continue;
+    }
+    if (line == "GLOBAL STATS" || line == "END")
+      break;
+
+    if (section == Section::Clients)
+    {
+      if (line.compare(0, 8, "Updated,") == 0 || line.compare(0, 12, "Common Name,") == 0)
+        continue;
+      std::string_view rest = line;
+      std::string_view name = nextField(rest);
+      std::string_view real = nextField(rest);
+      std::string_view received = nextField(rest);
+      std::string_view sent = nextField(rest);
+      std::string_view since = nextField(rest);
+      if (name.empty() || since.empty())
+        continue;
+
+      OnlineClient client = {};
+      client.name = name.data();
+      client.nameLength = static_cast<uint32_t>(name.size());
+      parseEndpoint(real, client.realFamily, client.realAddr, client.realPort);
+      parseUint64(received, client.bytesReceived);
+      parseUint64(sent, client.bytesSent);
+      client.since = since.data();
+      client.sinceLength = static_cast<uint32_t>(since.size());
+      parseTime(since, client.connectedSince);
+
+      // 同名客户端以后出现者为准
+      uint32_t *slot = slotFor(name);
+      if (*slot != 0)
+      {
+        clients[*slot - 1] = client;
+        continue;
+      }
+      if ((clients.size() + 1) * 2 > slots.size())
+      {
+        rebuildIndex(slots.size() * 2);
+        slot = slotFor(name);
+      }
+      clients.push_back(client);
+      *slot = static_cast<uint32_t>(clients.size());
+    }
+    else if (section == Section::Routing)
+    {
+      if (line.compare(0, 16, "Virtual Address,") == 0)
+        continue;
+      std::string_view rest = line;
+      std::string_view virtualAddress = nextField(rest);
+      std::string_view name = nextField(rest);
+      uint32_t *slot = slotFor(name);
+      uint8_t family = 0;
+      uint8_t addr[16];
+      // 跳过 iroute 子网（带 /）与 TAP 模式的 MAC 地址
+      if (*slot == 0 || !parseAddressText(virtualAddress, family, addr))
+        continue;
+      OnlineClient &client = clients[*slot - 1];
+      if (family == 4)
+      {
+        uint32_t networkOrder;
+        memcpy(&networkOrder, addr, sizeof(networkOrder));
+        client.vpnIpv4 = ntohl(networkOrder);
+      }
+      else
+      {
+        memcpy(client.vpnIpv6, addr, 16);
+        client.hasVpnIpv6 = 1;
+      }
+    }
+  }
+}
+
+void ClientSnapshot::finish()
+{
+  std::stable_sort(clients.begin(), clients.end(), [](const OnlineClient &a, const OnlineClient &b)
+                   { return a.connectedSince < b.connectedSince; });
+  rebuildIndex(roundUpPowerOfTwo(clients.size() * 2));
+}
+
+uint32_t *ClientSnapshot::slotFor(std::string_view key)
+{
+  const size_t mask = slots.size() - 1;
+  for (size_t slot = hashName(key) & mask;; slot = (slot + 1) & mask)
+  {
+    uint32_t &entry = slots[slot];
+    if (entry == 0 || name(clients[entry - 1]) == key)
+      return &entry;
+  }
+}
+
+void ClientSnapshot::rebuildIndex(size_t capacity)
+{
+  slots.assign(capacity, 0);
+  const size_t mask = capacity - 1;
+  for (size_t i = 0; i < clients.size(); ++i)
+  {
+    size_t slot = hashName(name(clients[i])) & mask;
+    while (slots[slot] != 0)
+      slot = (slot + 1) & mask;
+    slots[slot] = static_cast<uint32_t>(i + 1);
+  }
+}
+
+const OnlineClient *ClientSnapshot::find(std::string_view key) const
+{
+  if (slots.empty())
+    return nullptr;
+  const size_t mask = slots.size() - 1;
+  for (size_t slot = hashName(key) & mask; slots[slot] != 0; slot = (slot + 1) & mask)
+  {
+    const OnlineClient &client = clients[slots[slot] - 1];
+    if (name(client) == key)
+      return &client;
+  }
+  return nullptr;
+}
+
+bool ClientSnapshot::parseTime(std::string_view text, int64_t &epoch)
+{
+  static thread_local LocalClock clock;
+  static const char MONTHS[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+
+  // 2.6：YYYY-MM-DD HH:MM:SS
+  if (text.size() == 19 && text[4] == '-' && text[7] == '-' && text[10] == ' ')
+  {
+    return parseNumber(text.substr(0, 4), year) && parseNumber(text.substr(5, 2), month) &&
+           parseNumber(text.substr(8, 2), day) && parseClock(text.substr(11), hour, minute, second) &&
+           clock.toEpoch(year, month, day, hour, minute, second, epoch);
+  }
+
+  // 旧版 ctime：Www Mmm d HH:MM:SS YYYY（日期可能以空格补齐）
+  std::string_view rest = text;
+  nextWord(rest);
+  std::string_view monthName = nextWord(rest);
+  std::string_view dayText = nextWord(rest);
+  std::string_view clockText = nextWord(rest);
+  std::string_view yearText = nextWord(rest);
+  if (monthName.size() != 3)
+    return false;
+  for (int i = 0; i < 12; ++i)
+  {
+    if (monthName == std::string_view(MONTHS + i * 3, 3))
+      month = i + 1;
+  }
+  return month != 0 && parseNumber(dayText, day) && parseClock(clockText, hour, minute, second) &&
+         parseNumber(yearText, year) && clock.toEpoch(year, month, day, hour, minute, second, epoch);
+}
+
+bool ClientSnapshot::parseEndpoint(std::string_view text, uint8_t &family, uint8_t addr[16], uint16_t &port)
+{
+  family = 0;
+  port = 0;
+  memset(addr, 0, 16);
+  std::string_view host = text;
+  std::string_view portText;
+  if (!text.empty() && text.front() == '[')
+  {
+    size_t close = text.find(']');
+    if (close == std::string_view::npos)
+      return false;
+    host = text.substr(1, close - 1);
+    if (close + 1 < text.size() && text[close + 1] == ':')
+      portText = text.substr(close + 2);
+  }
+  else if (text.find(':') == text.rfind(':') && text.find(':') != std::string_view::npos)
+  {
+    // 仅一个冒号时为 IPv4:port
+    host = text.substr(0, text.find(':'));
+    portText = text.substr(text.find(':') + 1);
+  }
+  else if (!parseAddressText(text, family, addr) && text.rfind(':') != std::string_view::npos)
+  {
+    // 不带方括号的 IPv6:port
+    host = text.substr(0, text.rfind(':'));
+    portText = text.substr(text.rfind(':') + 1);
+  }
+  else
+  {
+    return family != 0;
+  }
+
+  uint64_t value = 0;
+  if (!parseAddressText(host, family, addr))
+    return false;
+  if (parseUint64(portText, value) && value <= 65535)
+    port = static_cast<uint16_t>(value);
+  return true;
+}
+
+void ClientSnapshot::formatAddress(uint8_t family, const uint8_t addr[16], char *buf, size_t size)
+{
+  if (size == 0)
+    return;
+  buf[0] = '\0';
+  if ((family != 4 && family != 6) || !inet_ntop(family == 4 ? AF_INET : AF_INET6, addr, buf, size))
+    buf[0] = '\0';
+}
+
+void ClientSnapshot::formatEndpoint(const OnlineClient &client, char *buf, size_t size)
+{
+  char address[INET6_ADDRSTRLEN];
+  formatAddress(client.realFamily, client.realAddr, address, sizeof(address));
+  if (address[0] == '\0' || client.realPort == 0)
+    snprintf(buf, size, "%s", address);
+  else if (client.realFamily == 6)
+    snprintf(buf, size, "[%s]:%u", address, client.realPort);
+  else
+    snprintf(buf, size, "%s:%u", address, client.realPort);
+}
+
+void ClientSnapshot::formatTime(int64_t epoch, char *buf, size_t size)
+{
+  if (size == 0)
+    return;
+  buf[0] = '\0';
+  if (epoch <= 0)
+    return;
+  time_t value = static_cast<time_t>(epoch);
+  struct tm tm;
+  if (localtime_r(&value, &tm))
+    strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
+std::string ClientSnapshot::formatEndpoint(const OnlineClient &client)
+{
+  char buf[INET6_ADDRSTRLEN + 8];
+  formatEndpoint(client, buf, sizeof(buf));
+  return buf;
+}
+
+std::string ClientSnapshot::formatTime(int64_t epoch)
+{
+  char buf[32];
+  formatTime(epoch, buf, sizeof(buf));
+  return buf;
+}
+
+namespace
+{
+  // 除名称外的字段是否一致
+  bool sameState(const OnlineClient &a, const OnlineClient &b)
+  {
+    return a.bytesReceived == b.bytesReceived && a.bytesSent == b.bytesSent &&
+           a.connectedSince == b.connectedSince && a.realFamily == b.realFamily && a.realPort == b.realPort &&
+           memcmp(a.realAddr, b.realAddr, sizeof(a.realAddr)) == 0 && a.vpnIpv4 == b.vpnIpv4 &&
+           a.hasVpnIpv6 == b.hasVpnIpv6 && memcmp(a.vpnIpv6, b.vpnIpv6, sizeof(a.vpnIpv6)) == 0;
+  }
+}
+
+void ClientDelta::compute()
+{
+  added.clear();
+  updated.clear();
+  removed.clear();
+  full = !base;
+  if (!snapshot)
+    return;
+  if (full)
+  {
+    added.reserve(snapshot->size());
+    for (size_t i = 0; i < snapshot->size(); ++i)
+      added.push_back(static_cast<uint32_t>(i));
+    return;
+  }
+  if (base == snapshot)
+    return;
+
+  // 两次按名称哈希查找，O(n)
+  for (size_t i = 0; i < snapshot->size(); ++i)
+  {
+    const OnlineClient &client = (*snapshot)[i];
+    const OnlineClient *previous = base->find(ClientSnapshot::name(client));
+    if (previous == nullptr)
+      added.push_back(static_cast<uint32_t>(i));
+    else if (!sameState(*previous, client))
+      updated.push_back(static_cast<uint32_t>(i));
+  }
+  for (size_t i = 0; i < base->size(); ++i)
+  {
+    if (snapshot->find(ClientSnapshot::name((*base)[i])) == nullptr)
+      removed.push_back(static_cast<uint32_t>(i));
+  }
+}
@@ -0,0 +1,164 @@
+#include "ConfigTemplate.hpp"
+#include "config.hpp"
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sys/stat.h>
+
+namespace
+{
+  constexpr std::string_view SERVER_TEMPLATE =
+      "{{marker}}\n"
+      "topology subnet\n"
+      "port {{port}}\n"
+      "proto {{proto}}\n"
+      "dev {{dev}}\n"
+      "ca {{service_dir}}/ca.crt\n"
+      "cert {{service_dir}}/server.crt\n"
+      "key {{service_dir}}/server.key\n"
+      "{{key_exchange}}"
+      "tls-auth {{service_dir}}/ta.key 0\n"
+      "server {{network}} {{netmask}}{{pool}}\n"
+      "persist-key\n"
+      "persist-tun\n"
+      "ifconfig-pool-persist {{runtime_dir}}/ipp.txt\n"
+      "client-config-dir {{runtime_dir}}/ccd\n"
+      "status {{runtime_dir}}/status.log\n"
+      "crl-verify {{crl}}\n"
+      "management {{runtime_dir}}/management.sock unix\n"
+      "verb 3\n"
+      "{{tuning}}";
+
+  constexpr std::string_view CLIENT_TEMPLATE =
+      "client\n"
+      "dev tun\n"
+      "proto {{proto}}\n"
+      "{{remotes}}"
+      "resolv-retry infinite\n"
+      "nobind\n"
+      "persist-key\n"
+      "persist-tun\n"
+      "remote-cert-tls server\n"
+      "verb 3\n"
+      "{{tuning}}"
+      "<ca>\n{{ca}}</ca>\n"
+      "<cert>\n{{cert}}</cert>\n"
+      "<key>\n{{key}}</key>\n"
+      "<tls-auth>\n{{tls_auth}}</tls-auth>\n"
+      "key-direction 1\n";
+
+  constexpr size_t SERVER_SEGMENT_COUNT = tmpl::countSegments(SERVER_TEMPLATE);
+  constexpr size_t CLIENT_SEGMENT_COUNT = tmpl::countSegments(CLIENT_TEMPLATE);
+  static_assert(SERVER_SEGMENT_COUNT > 0, "invalid built-in server template");
+  static_assert(CLIENT_SEGMENT_COUNT > 0, "invalid built-in client template");
+
+  constexpr auto SERVER_SEGMENTS = tmpl::compile<SERVER_SEGMENT_COUNT>(SERVER_TEMPLATE);
+  constexpr auto CLIENT_SEGMENTS = tmpl::compile<CLIENT_SEGMENT_COUNT>(CLIENT_TEMPLATE);
+
+  // 覆盖模板按文件修改时间缓存，文件不存在或解析失败时使用内置模板
+  struct TemplateCache
+  {
+    std::mutex mutex;
+    time_t mtime = 0;
+    std::shared_ptr<const ConfigTemplate> parsed;
+  };
+
+  std::shared_ptr<const ConfigTemplate> loadTemplate(TemplateCache &cache, const std::string &path,
+                                                     const std::shared_ptr<const ConfigTemplate> &builtin)
+  {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+      return builtin;
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.parsed && cache.mtime == st.st_mtime)
+      return cache.parsed;
+
+    std::ifstream file(path);
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string error;
+    std::shared_ptr<const ConfigTemplate> parsed = ConfigTemplate::parse(text, error);
+    if (!parsed)
+    {
+      std::cerr << "Invalid config template " << path << ": " << error << ", using built-in template" << std::endl;
+      return builtin;
+    }
+    cache.mtime = st.st_mtime;
+    cache.parsed = parsed;
+    return parsed;
+  }
+}
+
+ConfigTemplate::ConfigTemplate(std::string_view source, const tmpl::Segment *segments, size_t count)
+    : source(source), segments(segments), count(count)
+{
+  measure();
+}
+
+ConfigTemplate::ConfigTemplate(const std::string &text)
+    : storage(text)
+{
+  source = storage;
+}
+
+void ConfigTemplate::measure()
+{
+  literalSize = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (segments[i].slot == tmpl::Slot::Literal)
+      literalSize += segments[i].length;
+  }
+}
+
+std::shared_ptr<const ConfigTemplate> ConfigTemplate::parse(const std::string &text, std::string &error)
+{
+  std::shared_ptr<ConfigTemplate> result(new ConfigTemplate(text));
+  size_t parsed = tmpl::scan(result->source, [&](const tmpl::Segment &segment) { result->owned.push_back(segment); });
+  if (parsed == 0)
+  {
+    error = "empty template, unterminated '{{' or unknown placeholder";
+    return nullptr;
+  }
+  result->segments = result->owned.data();
+  result->count = result->owned.size();
+  result->measure();
+  return result;
+}
+
+void ConfigTemplate::render(const tmpl::SlotValues &values, std::string &out) const
+{
+  size_t total = literalSize;
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (segments[i].slot != tmpl::Slot::Literal)
+      total += values[static_cast<size_t>(segments[i].slot)].size();
+  }
+
+  out.clear();
+  out.reserve(total);
+  for (size_t i = 0; i < count; ++i)
+  {
+    const tmpl::Segment &segment = segments[i];
+    if (segment.slot == tmpl::Slot::Literal)
+      out.append(source.data() + segment.offset, segment.length);
+    else
+      out.append(values[static_cast<size_t>(segment.slot)]);
+  }
+}
+
+std::shared_ptr<const ConfigTemplate> ConfigTemplate::server()
+{
+  static const std::shared_ptr<const ConfigTemplate> builtin =
+      std::make_shared<const ConfigTemplate>(SERVER_TEMPLATE, SERVER_SEGMENTS.data(), SERVER_SEGMENTS.size());
+  static TemplateCache cache;
+  return loadTemplate(cache, OVPN_DIR + "/templates/server.conf.tmpl", builtin);
+}
+
+std::shared_ptr<const ConfigTemplate> ConfigTemplate::client()
+{
+  static const std::shared_ptr<const ConfigTemplate> builtin =
+      std::make_shared<const ConfigTemplate>(CLIENT_TEMPLATE, CLIENT_SEGMENTS.data(), CLIENT_SEGMENTS.size());
+  static TemplateCache cache;
+  return loadTemplate(cache, OVPN_DIR + "/templates/client.ovpn.tmpl", builtin);
+}
@@ -0,0 +1,456 @@
+#include "CrlManager.hpp"
+#include "config.hpp"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include <openssl/bn.h>
+#include <openssl/evp.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  // CRL 有效期，与 easy-rsa 默认的 EASYRSA_CRL_DAYS 保持一致
+  const long CRL_VALID_SECONDS = 180L * 24 * 3600;
+
+  // 规范化序列号：去掉前导零并统一为大写十六进制
+  std::string normalizeSerial(const std::string &serialHex)
+  {
+    BIGNUM *bn = nullptr;
+    if (!BN_hex2bn(&bn, serialHex.c_str()))
+      return "";
+    char *hex = BN_bn2hex(bn);
+    std::string result = hex ? hex : "";
+    OPENSSL_free(hex);
+    BN_free(bn);
+    return result;
+  }
+
+  // 将 ASN1 时间字符串（如 250424101010Z）转换为 time_t
+  time_t parseAsn1Time(const std::string &text)
+  {
+    ASN1_TIME *t = ASN1_TIME_new();
+    time_t result = 0;
+    struct tm tm = {};
+    if (t && ASN1_TIME_set_string(t, text.c_str()) && ASN1_TIME_to_tm(t, &tm))
+      result = timegm(&tm);
+    ASN1_TIME_free(t);
+    return result;
+  }
+
+  time_t fileMtime(const std::string &path)
+  {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_mtime : 0;
+  }
+
+  X509_REVOKED *makeRevoked(const std::string &serialHex, time_t revokedAt)
+  {
+    BIGNUM *bn = nullptr;
+    if (!BN_hex2bn(&bn, serialHex.c_str()))
+      return nullptr;
+    ASN1_INTEGER *serial = BN_to_ASN1_INTEGER(bn, nullptr);
+    BN_free(bn);
+    ASN1_TIME *when = ASN1_TIME_set(nullptr, revokedAt);
+    X509_REVOKED *rev = X509_REVOKED_new();
+    bool ok = serial && when && rev &&
+              X509_REVOKED_set_serialNumber(rev, serial) &&
+              X509_REVOKED_set_revocationDate(rev, when);
+    ASN1_INTEGER_free(serial);
+    ASN1_TIME_free(when);
+    if (!ok)
+    {
+      X509_REVOKED_free(rev);
+      return nullptr;
+    }
+    return rev;
+  }
+}
+
+CrlManager::CrlManager(const std::string &pkiDir, const std::string &crlPath)
+    : pkiDir(pkiDir), crlPath(crlPath)
+{
+}
+
+CrlManager::~CrlManager()
+{
+  X509_CRL_free(crl);
+  X509_free(caCert);
+  EVP_PKEY_free(caKey);
+}
+
+CrlManager &CrlManager::instance()
+{
+  static CrlManager manager(EASY_RSA_DIR + "/pki", OVPN_DIR + "/crl.pem");
+  return manager;
+}
+
+bool CrlManager::readCertificate(const std::string &certPath, std::string &serialHex, time_t &expiresAt)
+{
+  FILE *fp = fopen(certPath.c_str(), "r");
+  if (!fp)
+    return false;
+  X509 *cert = PEM_read_X509(fp, nullptr, nullptr, nullptr);
+  fclose(fp);
+  if (!cert)
+    return false;
+
+  BIGNUM *bn = ASN1_INTEGER_to_BN(X509_get_serialNumber(cert), nullptr);
+  char *hex = bn ? BN_bn2hex(bn) : nullptr;
+  serialHex = hex ? hex : "";
+  OPENSSL_free(hex);
+  BN_free(bn);
+
+  struct tm tm = {};
+  expiresAt = ASN1_TIME_to_tm(X509_get0_notAfter(cert), &tm) ? timegm(&tm) : 0;
+  X509_free(cert);
+  return !serialHex.empty();
+}
+
+size_t CrlManager::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return revoked.size();
+}
+
+// 首次使用或 index.txt 被外部修改时，从 easy-rsa 数据库重新加载
+bool CrlManager::ensureLoaded()
+{
+  if (!caKey && !loadSigner())
+    return false;
+  if (loaded && fileMtime(pkiDir + "/index.txt") == indexMtime)
+    return true;
+  if (!loadIndex() || !rebuildCrl())
+    return false;
+  baseCrlNumber = nextCrlNumber() - 1;
+  loaded = true;
+  return true;
+}
+
+// 解析 index.txt 中状态为 R 的记录：R <过期时间> <吊销时间[,原因]> <序列号> <文件> <DN>
+bool CrlManager::loadIndex()
+{
+  std::string indexPath = pkiDir + "/index.txt";
+  std::ifstream index(indexPath);
+  if (!index.is_open())
+  {
+    std::cerr << "Failed to open CA index: " << indexPath << std::endl;
+    return false;
+  }
+
+  revoked.clear();
+  std::string line;
+  while (std::getline(index, line))
+  {
+    if (line.empty() || line[0] != 'R')
+      continue;
+
+    std::vector<std::string> fields;
+    std::istringstream iss(line);
+    std::string field;
+    while (std::getline(iss, field, '\t'))
+      fields.push_back(field);
+    if (fields.size() < 4)
+      continue;
+
+    std::string serial = normalizeSerial(fields[3]);
+    if (serial.empty())
+      continue;
+
+    RevokedEntry entry;
+    entry.expiresAt = parseAsn1Time(fields[1]);
+    entry.revokedAt = parseAsn1Time(fields[2].substr(0, fields[2].find(',')));
+    entry.crlNumber = 0;
+    revoked[serial] = entry;
+  }
+  indexMtime = fileMtime(indexPath);
+  return true;
+}
+
+// 加载CA证书与私钥（要求CA私钥未加密，与 --batch 模式一致）
+bool CrlManager::loadSigner()
+{
+  FILE *fp = fopen((pkiDir + "/ca.crt").c_str(), "r");
+  if (!fp)
+  {
+    std::cerr << "Failed to open CA certificate in " << pkiDir << std::endl;
+    return false;
+  }
+  caCert = PEM_read_X509(fp, nullptr, nullptr, nullptr);
+  fclose(fp);
+
+  fp = fopen((pkiDir + "/private/ca.key").c_str(), "r");
+  if (!fp)
+  {
+    std::cerr << "Failed to open CA private key in " << pkiDir << std::endl;
+    return false;
+  }
+  // 传入空口令回调，加密的私钥直接失败而不是阻塞等待输入
+  caKey = PEM_read_PrivateKey(fp, nullptr, [](char *, int, int, void *) { return 0; }, nullptr);
+  fclose(fp);
+
+  if (!caCert || !caKey || X509_check_private_key(caCert, caKey) != 1)
+  {
+    std::cerr << "CA certificate/key unusable for native CRL signing" << std::endl;
+    X509_free(caCert);
+    EVP_PKEY_free(caKey);
+    caCert = nullptr;
+    caKey = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool CrlManager::rebuildCrl()
+{
+  X509_CRL *fresh = buildCrl(false);
+  if (!fresh)
+    return false;
+  X509_CRL_free(crl);
+  crl = fresh;
+  return true;
+}
+
+X509_CRL *CrlManager::buildCrl(bool delta)
+{
+  X509_CRL *result = X509_CRL_new();
+  if (!result)
+    return nullptr;
+  for (const auto &pair : revoked)
+  {
+    if (delta && pair.second.crlNumber <= baseCrlNumber)
+      continue;
+    X509_REVOKED *rev = makeRevoked(pair.first, pair.second.revokedAt);
+    if (!rev || !X509_CRL_add0_revoked(result, rev))
+    {
+      X509_REVOKED_free(rev);
+      X509_CRL_free(result);
+      return nullptr;
+    }
+  }
+  return result;
+}
+
+// 读取 pki/crlnumber（与 openssl ca 共用），不存在时从 1 开始
+uint64_t CrlManager::nextCrlNumber()
+{
+  std::ifstream in(pkiDir + "/crlnumber");
+  std::string hex;
+  if (in >> hex)
+  {
+    try
+    {
+      return std::stoull(hex, nullptr, 16);
+    }
+    catch (...)
+    {
+    }
+  }
+  return 1;
+}
+
+bool CrlManager::revoke(const std::string &serialHex, time_t expiresAt)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  // 已加载时直接追加，不因调用方刚执行的 easyrsa revoke 改动 index.txt 而全量重载
+  bool wasLoaded = loaded;
+  if (!wasLoaded && !ensureLoaded())
+    return false;
+
+  std::string serial = normalizeSerial(serialHex);
+  if (serial.empty())
+    return false;
+
+  // 刚加载的数据可能已经包含了这条记录（easyrsa revoke 先行写入 index.txt）：
+  // 此时它已在完整CRL中，但加载时的序号为 0，需按本次吊销编号，否则不会进入增量CRL
+  auto existing = revoked.find(serial);
+  if (existing != revoked.end())
+  {
+    if (!wasLoaded && existing->second.crlNumber == 0)
+      existing->second.crlNumber = nextCrlNumber();
+  }
+  else
+  {
+    RevokedEntry entry;
+    entry.revokedAt = time(nullptr);
+    entry.expiresAt = expiresAt;
+    entry.crlNumber = nextCrlNumber();
+    revoked[serial] = entry;
+
+    X509_REVOKED *rev = makeRevoked(serial, entry.revokedAt);
+    if (!rev || !X509_CRL_add0_revoked(crl, rev))
+    {
+      X509_REVOKED_free(rev);
+      return false;
+    }
+  }
+
+  // 本次 index.txt 的变化由调用方的吊销操作引起，无需重新加载
+  if (wasLoaded)
+    indexMtime = fileMtime(pkiDir + "/index.txt");
+
+  return publishLocked();
+}
+
+bool CrlManager::publish()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!ensureLoaded())
+    return false;
+  return publishLocked();
+}
+
+bool CrlManager::publishLocked()
+{
+  if (autoPrune)
+    pruneLocked(time(nullptr));
+
+  uint64_t number = nextCrlNumber();
+  if (!signAndWrite(crl, number, crlPath, false))
+    return false;
+
+  if (deltaEnabled)
+  {
+    X509_CRL *delta = buildCrl(true);
+    std::string deltaPath = (fs::path(crlPath).parent_path() / "crl-delta.pem").string();
+    bool ok = delta && signAndWrite(delta, number, deltaPath, true);
+    X509_CRL_free(delta);
+    if (!ok)
+      std::cerr << "Failed to publish delta CRL: " << deltaPath << std::endl;
+  }
+
+  // 推进 crlnumber，保持与 easy-rsa 的序号连续
+  char next[32];
+  snprintf(next, sizeof(next), "%02llX", static_cast<unsigned long long>(number + 1));
+  std::string numberHex = next;
+  if (numberHex.size() % 2)
+    numberHex = "0" + numberHex;
+  return writeFileAtomic(pkiDir + "/crlnumber", numberHex + "\n", 0644);
+}
+
+size_t CrlManager::pruneExpired(time_t now)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!ensureLoaded())
+    return 0;
+  return pruneLocked(now);
+}
+
+// 过期证书即使未吊销也无法通过校验，其吊销记录可以安全移除
+size_t CrlManager::pruneLocked(time_t now)
+{
+  size_t before = revoked.size();
+  for (auto it = revoked.begin(); it != revoked.end();)
+  {
+    if (it->second.expiresAt != 0 && it->second.expiresAt < now)
+      it = revoked.erase(it);
+    else
+      ++it;
+  }
+  size_t pruned = before - revoked.size();
+  if (pruned > 0 && rebuildCrl())
+    baseCrlNumber = nextCrlNumber() - 1;
+  return pruned;
+}
+
+bool CrlManager::signAndWrite(X509_CRL *target, uint64_t number, const std::string &path, bool delta)
+{
+  time_t now = time(nullptr);
+  ASN1_TIME *lastUpdate = ASN1_TIME_set(nullptr, now);
+  ASN1_TIME *nextUpdate = ASN1_TIME_set(nullptr, now + CRL_VALID_SECONDS);
+  ASN1_INTEGER *crlNumber = ASN1_INTEGER_new();
+  bool ok = lastUpdate && nextUpdate && crlNumber &&
+            X509_CRL_set_version(target, 1) &&
+            X509_CRL_set_issuer_name(target, X509_get_subject_name(caCert)) &&
+            X509_CRL_set1_lastUpdate(target, lastUpdate) &&
+            X509_CRL_set1_nextUpdate(target, nextUpdate) &&
+            ASN1_INTEGER_set_uint64(crlNumber, number) &&
+            X509_CRL_add1_ext_i2d(target, NID_crl_number, crlNumber, 0, X509V3_ADD_REPLACE) > 0;
+  ASN1_TIME_free(lastUpdate);
+  ASN1_TIME_free(nextUpdate);
+
+  if (ok && delta)
+  {
+    ok = ASN1_INTEGER_set_uint64(crlNumber, baseCrlNumber) &&
+         X509_CRL_add1_ext_i2d(target, NID_delta_crl, crlNumber, 1, X509V3_ADD_REPLACE) > 0;
+  }
+  ASN1_INTEGER_free(crlNumber);
+
+  if (ok)
+  {
+    X509V3_CTX ctx;
+    X509V3_set_ctx(&ctx, caCert, nullptr, nullptr, target, 0);
+    X509_EXTENSION *akid = X509V3_EXT_conf_nid(nullptr, &ctx, NID_authority_key_identifier, "keyid:always");
+    if (akid)
+    {
+      int pos = X509_CRL_get_ext_by_NID(target, NID_authority_key_identifier, -1);
+      if (pos >= 0)
+        X509_EXTENSION_free(X509_CRL_delete_ext(target, pos));
+      X509_CRL_add_ext(target, akid, -1);
+      X509_EXTENSION_free(akid);
+    }
+  }
+
+  // Ed25519/Ed448 等签名算法不使用独立摘要
+  int keyType = EVP_PKEY_id(caKey);
+  const EVP_MD *md = (keyType == EVP_PKEY_ED25519 || keyType == EVP_PKEY_ED448) ? nullptr : EVP_sha256();
+  ok = ok && X509_CRL_sort(target) && X509_CRL_sign(target, caKey, md) > 0;
+  if (!ok)
+  {
+    std::cerr << "Failed to sign CRL: " << path << std::endl;
+    return false;
+  }
+
+  std::unique_ptr<BIO, int (*)(BIO *)> bio(BIO_new(BIO_s_mem()), BIO_free);
+  if (!bio || !PEM_write_bio_X509_CRL(bio.get(), target))
+    return false;
+  char *data = nullptr;
+  long len = BIO_get_mem_data(bio.get(), &data);
+  return writeFileAtomic(path, std::string(data, len), 0644);
+}
+
+// 写入同目录临时文件，fsync 后 rename 覆盖目标，读者不会看到半写的文件
+bool CrlManager::writeFileAtomic(const std::string &path, const std::string &content, int mode)
+{
+  std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+  int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+  if (fd < 0)
+  {
+    std::cerr << "Failed to create temp file: " << tmpPath << std::endl;
+    return false;
+  }
+
+  const char *p = content.data();
+  size_t left = content.size();
+  bool ok = true;
+  while (left > 0)
+  {
+    ssize_t n = write(fd, p, left);
+    if (n < 0)
+    {
+      ok = false;
+      break;
+    }
+    p += n;
+    left -= n;
+  }
+  ok = ok && fchmod(fd, mode) == 0 && fsync(fd) == 0;
+  ok = (close(fd) == 0) && ok;
+
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+  {
+    std::cerr << "Failed to write file atomically: " << path << std::endl;
+    unlink(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,57 @@
+#include "DcoSupport.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+const char *DcoSupport::DEFAULT_SYS_ROOT = "/sys";
+
+// 首行形如 "OpenVPN 2.6.3 x86_64-pc-linux-gnu [SSL (OpenSSL)] [LZO] [LZ4] [EPOLL] [MH/PKTINFO] [AEAD] [DCO]"
+bool DcoSupport::parseVersionOutput(const std::string &output, int &major, int &minor, bool &dcoBuild)
+{
+  size_t pos = output.find("OpenVPN ");
+  if (pos == std::string::npos)
+    return false;
+  if (sscanf(output.c_str() + pos, "OpenVPN %d.%d", &major, &minor) != 2)
+    return false;
+
+  std::string firstLine = output.substr(pos, output.find('\n', pos) - pos);
+  dcoBuild = firstLine.find("[DCO]") != std::string::npos ||
+             output.find("DCO version:") != std::string::npos;
+  return true;
+}
+
+bool DcoSupport::isModuleLoaded(const std::string &sysRoot)
+{
+  std::error_code ec;
+  return fs::exists(sysRoot + "/module/ovpn_dco_v2", ec) || fs::exists(sysRoot + "/module/ovpn", ec);
+}
+
+DcoStatus DcoSupport::detect(const std::string &versionOutput, const std::string &sysRoot)
+{
+  DcoStatus status;
+  bool dcoBuild = false;
+  if (parseVersionOutput(versionOutput, status.versionMajor, status.versionMinor, dcoBuild))
+    status.openvpnSupport = dcoBuild && status.supportsDcoOptions();
+  status.moduleLoaded = isModuleLoaded(sysRoot);
+  return status;
+}
+
+// tun 驱动创建的接口带有 tun_flags 属性，DCO 接口没有；uevent 中的 DEVTYPE 可直接判断
+bool DcoSupport::isDeviceOffloaded(const std::string &device, const std::string &sysRoot)
+{
+  std::error_code ec;
+  fs::path devPath = fs::path(sysRoot) / "class" / "net" / device;
+  if (device.empty() || !fs::exists(devPath, ec))
+    return false;
+
+  std::ifstream uevent(devPath / "uevent");
+  std::string line;
+  while (std::getline(uevent, line))
+  {
+    if (line.rfind("DEVTYPE=", 0) == 0)
+      return line.find("ovpn") != std::string::npos;
+  }
+  return !fs::exists(devPath / "tun_flags", ec);
+}
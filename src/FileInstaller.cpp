@@ -0,0 +1,282 @@
+#include "FileInstaller.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+namespace
+{
+  std::string parentDir(const std::string &path)
+  {
+    size_t pos = path.find_last_of('/');
+    if (pos == std::string::npos)
+      return ".";
+    return pos == 0 ? "/" : path.substr(0, pos);
+  }
+
+  std::string describe(const std::string &what, const std::string &path)
+  {
+    return what + " " + path + ": " + strerror(errno);
+  }
+
+  // 优先 copy_file_range（同文件系统时可由内核直接共享或复制数据块），不支持时退化到 sendfile
+  // copied 返回实际复制的字节数，源文件在复制期间被截断时少于 size
+  bool copyContents(int in, int out, off_t size, off_t &copied)
+  {
+    bool useCopyRange = true;
+    copied = 0;
+    while (copied < size)
+    {
+      size_t count = static_cast<size_t>(size - copied);
+      ssize_t n = useCopyRange ? copy_file_range(in, nullptr, out, nullptr, count, 0)
+                               : sendfile(out, in, nullptr, count);
+      if (n < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        if (useCopyRange && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP))
+        {
+          useCopyRange = false;
+          continue;
+        }
+        return false;
+      }
+      if (n == 0)
+        break; // 源文件被截断
+      copied += n;
+    }
+    return copied == size;
+  }
+
+  bool writeContents(int fd, const std::string &content)
+  {
+    const char *p = content.data();
+    size_t left = content.size();
+    while (left > 0)
+    {
+      ssize_t n = ::write(fd, p, left);
+      if (n < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        return false;
+      }
+      p += n;
+      left -= n;
+    }
+    return true;
+  }
+}
+
+FileInstaller::~FileInstaller()
+{
+  discard();
+}
+
+FileInstaller &FileInstaller::copy(const std::string &source, const std::string &dest, mode_t mode, uid_t owner,
+                                   gid_t group)
+{
+  entries.push_back(Entry{source, std::string(), dest, mode, owner, group, std::string(), std::string(), false});
+  return *this;
+}
+
+FileInstaller &FileInstaller::write(const std::string &content, const std::string &dest, mode_t mode, uid_t owner,
+                                    gid_t group)
+{
+  entries.push_back(Entry{std::string(), content, dest, mode, owner, group, std::string(), std::string(), false});
+  return *this;
+}
+
+FileInstaller &FileInstaller::noReplace(bool enabled)
+{
+  replace = !enabled;
+  return *this;
+}
+
+FileInstaller &FileInstaller::durable(bool enabled)
+{
+  sync = enabled;
+  return *this;
+}
+
+bool FileInstaller::commit(std::string &error)
+{
+  for (auto &entry : entries)
+  {
+    if (!stage(entry, error))
+    {
+      discard();
+      return false;
+    }
+  }
+
+  std::set<std::string> dirs;
+  for (auto &entry : entries)
+  {
+    if (!install(entry, error))
+    {
+      rollback();
+      discard();
+      return false;
+    }
+    entry.staged.clear();
+    dirs.insert(parentDir(entry.dest));
+  }
+
+  // 全部替换成功后才删除原文件的备份
+  for (auto &entry : entries)
+  {
+    if (!entry.backup.empty())
+      unlink(entry.backup.c_str());
+  }
+
+  // 目录项变更落盘，每个目录只同步一次
+  for (const auto &dir : dirs)
+  {
+    int fd = sync ? open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC) : -1;
+    if (fd >= 0)
+    {
+      fsync(fd);
+      close(fd);
+    }
+  }
+  entries.clear();
+  return true;
+}
+
+bool FileInstaller::stage(Entry &entry, std::string &error)
+{
+  std::string tmpl = entry.dest + ".XXXXXX";
+  int out = mkostemp(&tmpl[0], O_CLOEXEC);
+  if (out < 0)
+  {
+    error = describe("Failed to create temp file for", entry.dest);
+    return false;
+  }
+  entry.staged = tmpl;
+
+  bool ok = true;
+  if (!entry.source.empty())
+  {
+    int in = open(entry.source.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (in < 0 || fstat(in, &st) != 0)
+    {
+      error = describe("Failed to open", entry.source);
+      ok = false;
+    }
+    else
+    {
+      off_t copied = 0;
+      errno = 0;
+      if (!copyContents(in, out, st.st_size, copied))
+      {
+        error = copied < st.st_size && errno == 0 ? "Source truncated while copying " + entry.source
+                                                  : describe("Failed to copy", entry.source);
+        ok = false;
+      }
+    }
+    if (in >= 0)
+      close(in);
+  }
+  else if (!writeContents(out, entry.content))
+  {
+    error = describe("Failed to write", entry.staged);
+    ok = false;
+  }
+
+  if (ok && fchmod(out, entry.mode) != 0)
+  {
+    error = describe("Failed to set mode on", entry.staged);
+    ok = false;
+  }
+  if (ok && (entry.owner != static_cast<uid_t>(-1) || entry.group != static_cast<gid_t>(-1)) &&
+      fchown(out, entry.owner, entry.group) != 0)
+  {
+    error = describe("Failed to set owner on", entry.staged);
+    ok = false;
+  }
+  if (ok && sync && fsync(out) != 0)
+  {
+    error = describe("Failed to sync", entry.staged);
+    ok = false;
+  }
+  close(out);
+  return ok;
+}
+
+bool FileInstaller::install(Entry &entry, std::string &error)
+{
+  // 覆盖模式下先为已有目标建立硬链接备份，后续文件失败时据此恢复
+  if (replace)
+  {
+    std::string backup = entry.staged + ".orig";
+    if (link(entry.dest.c_str(), backup.c_str()) == 0)
+      entry.backup = backup;
+    else if (errno != ENOENT)
+    {
+      error = describe("Failed to back up", entry.dest);
+      return false;
+    }
+  }
+
+  unsigned int flags = replace ? 0 : RENAME_NOREPLACE;
+  bool ok = renameat2(AT_FDCWD, entry.staged.c_str(), AT_FDCWD, entry.dest.c_str(), flags) == 0;
+
+  // 内核或文件系统不支持 renameat2 标志时：覆盖模式用 rename，不覆盖模式用 link（目标存在时同样失败）
+  if (!ok && (errno == ENOSYS || errno == EINVAL))
+  {
+    ok = replace ? rename(entry.staged.c_str(), entry.dest.c_str()) == 0
+                 : link(entry.staged.c_str(), entry.dest.c_str()) == 0 && unlink(entry.staged.c_str()) == 0;
+  }
+  if (!ok)
+  {
+    error = describe("Failed to install", entry.dest);
+    if (!entry.backup.empty())
+    {
+      unlink(entry.backup.c_str());
+      entry.backup.clear();
+    }
+    return false;
+  }
+  entry.installed = true;
+  return true;
+}
+
+// 逆序撤销已替换的文件：有备份的恢复原文件，原先不存在的删除
+void FileInstaller::rollback()
+{
+  for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+  {
+    if (!it->installed)
+      continue;
+    if (!it->backup.empty())
+      rename(it->backup.c_str(), it->dest.c_str());
+    else
+      unlink(it->dest.c_str());
+    it->installed = false;
+    it->backup.clear();
+  }
+}
+
+void FileInstaller::discard()
+{
+  for (auto &entry : entries)
+  {
+    if (!entry.staged.empty())
+    {
+      unlink(entry.staged.c_str());
+      entry.staged.clear();
+    }
+    if (!entry.backup.empty())
+    {
+      unlink(entry.backup.c_str());
+      entry.backup.clear();
+    }
+  }
+  entries.clear();
+}
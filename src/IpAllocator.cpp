@@ -0,0 +1,216 @@
+#include "IpAllocator.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+namespace
+{
+  const uint32_t BITMAP_MAGIC = 0x5049564F; // "OVIP"
+  const uint32_t BITMAP_VERSION = 1;
+
+  struct BitmapHeader
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t network;
+    uint32_t prefixLength;
+    uint32_t cursor;
+    uint32_t wordCount;
+  };
+}
+
+IpAllocator::IpAllocator(uint32_t network, int prefixLength)
+    : network(network & prefixToMask(prefixLength)), prefixLength(prefixLength)
+{
+  bits = size_t(1) << (32 - prefixLength);
+  words.assign((bits + 63) / 64, 0);
+  markReserved();
+}
+
+// 预留网络地址、服务端地址与广播地址，末字中超出范围的位置为已占用，扫描时无需边界判断
+void IpAllocator::markReserved()
+{
+  size_t tail = bits % 64;
+  if (tail)
+    words.back() |= ~0ULL << tail;
+  words[0] |= 0x3; // .0 网络地址, .1 服务端
+  words[(bits - 1) / 64] |= 1ULL << ((bits - 1) % 64);
+  usedCount = 3;
+}
+
+bool IpAllocator::parseAddress(const std::string &text, uint32_t &addr)
+{
+  struct in_addr in;
+  if (inet_pton(AF_INET, text.c_str(), &in) != 1)
+    return false;
+  addr = ntohl(in.s_addr);
+  return true;
+}
+
+bool IpAllocator::parseSubnet(const std::string &text, uint32_t &network, int &prefixLength)
+{
+  size_t slash = text.find('/');
+  if (slash != std::string::npos)
+  {
+    try
+    {
+      prefixLength = std::stoi(text.substr(slash + 1));
+    }
+    catch (...)
+    {
+      return false;
+    }
+  }
+  if (prefixLength < MIN_PREFIX_LENGTH || prefixLength > MAX_PREFIX_LENGTH)
+    return false;
+  if (!parseAddress(text.substr(0, slash), network))
+    return false;
+  network &= prefixToMask(prefixLength);
+  return true;
+}
+
+std::string IpAllocator::toString(uint32_t addr)
+{
+  char buf[INET_ADDRSTRLEN];
+  struct in_addr in;
+  in.s_addr = htonl(addr);
+  inet_ntop(AF_INET, &in, buf, sizeof(buf));
+  return buf;
+}
+
+uint32_t IpAllocator::prefixToMask(int prefixLength)
+{
+  return prefixLength <= 0 ? 0 : ~0U << (32 - prefixLength);
+}
+
+bool IpAllocator::offsetOf(uint32_t addr, size_t &offset) const
+{
+  if ((addr & prefixToMask(prefixLength)) != network)
+    return false;
+  offset = addr - network;
+  return true;
+}
+
+bool IpAllocator::allocate(uint32_t &addr)
+{
+  if (usedCount >= bits)
+    return false;
+
+  size_t count = words.size();
+  for (size_t i = 0; i < count; ++i)
+  {
+    size_t index = (cursor + i) % count;
+    uint64_t word = words[index];
+    if (word == ~0ULL)
+      continue;
+    int bit = __builtin_ctzll(~word);
+    words[index] = word | (1ULL << bit);
+    ++usedCount;
+    cursor = index;
+    addr = network + static_cast<uint32_t>(index * 64 + bit);
+    return true;
+  }
+  return false;
+}
+
+bool IpAllocator::reserve(uint32_t addr)
+{
+  size_t offset;
+  if (!offsetOf(addr, offset))
+    return false;
+  uint64_t &word = words[offset / 64];
+  uint64_t mask = 1ULL << (offset % 64);
+  if (word & mask)
+    return false;
+  word |= mask;
+  ++usedCount;
+  return true;
+}
+
+bool IpAllocator::release(uint32_t addr)
+{
+  size_t offset;
+  if (!offsetOf(addr, offset) || offset <= 1 || offset == bits - 1)
+    return false;
+  uint64_t &word = words[offset / 64];
+  uint64_t mask = 1ULL << (offset % 64);
+  if (!(word & mask))
+    return false;
+  word &= ~mask;
+  --usedCount;
+  return true;
+}
+
+bool IpAllocator::isAllocated(uint32_t addr) const
+{
+  size_t offset;
+  return offsetOf(addr, offset) && (words[offset / 64] & (1ULL << (offset % 64)));
+}
+
+bool IpAllocator::load(const std::string &path)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open())
+    return false;
+
+  BitmapHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      header.magic != BITMAP_MAGIC || header.version != BITMAP_VERSION ||
+      header.prefixLength < MIN_PREFIX_LENGTH || header.prefixLength > MAX_PREFIX_LENGTH ||
+      header.wordCount != ((size_t(1) << (32 - header.prefixLength)) + 63) / 64)
+  {
+    std::cerr << "Invalid IP bitmap file: " << path << std::endl;
+    return false;
+  }
+
+  std::vector<uint64_t> loaded(header.wordCount);
+  if (!in.read(reinterpret_cast<char *>(loaded.data()), loaded.size() * sizeof(uint64_t)))
+    return false;
+
+  network = header.network;
+  prefixLength = header.prefixLength;
+  bits = size_t(1) << (32 - prefixLength);
+  words.swap(loaded);
+  cursor = header.cursor < words.size() ? header.cursor : 0;
+  usedCount = 0;
+  for (uint64_t word : words)
+    usedCount += __builtin_popcountll(word);
+  // 末字的填充位不计入占用数
+  if (bits % 64)
+    usedCount -= 64 - bits % 64;
+  return true;
+}
+
+bool IpAllocator::save(const std::string &path) const
+{
+  BitmapHeader header;
+  header.magic = BITMAP_MAGIC;
+  header.version = BITMAP_VERSION;
+  header.network = network;
+  header.prefixLength = prefixLength;
+  header.cursor = static_cast<uint32_t>(cursor);
+  header.wordCount = static_cast<uint32_t>(words.size());
+
+  std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(words.data()), words.size() * sizeof(uint64_t));
+    if (!out.good())
+    {
+      std::cerr << "Failed to write IP bitmap: " << tmpPath << std::endl;
+      std::remove(tmpPath.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+  {
+    std::cerr << "Failed to replace IP bitmap: " << path << std::endl;
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,574 @@
+#include "KeyPool.hpp"
+#include "config.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <openssl/crypto.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/ec.h>
+#include <openssl/objects.h>
+
+/// @brief 池目录中的状态文件（定长，flock 保护的读改写）
+struct KeyPool::State
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t size;
+  uint32_t lowWater;
+  uint32_t maxAgeSeconds;
+  uint32_t shred;
+  uint32_t reserved;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t generated;
+  uint64_t destroyed;
+
+  bool valid() const { return memcmp(magic, "OVPNKEY", 8) == 0 && version == 1; }
+
+  KeyPoolOptions options() const
+  {
+    KeyPoolOptions result;
+    result.size = size;
+    result.lowWater = lowWater;
+    result.maxAgeSeconds = maxAgeSeconds;
+    result.shred = shred != 0;
+    return result;
+  }
+};
+
+namespace
+{
+  const char *STATE_FILE = "/pool.state";
+  const char *KEY_SUFFIX = ".key";
+  const int DEFAULT_RSA_BITS = 2048; // easy-rsa 默认的 EASYRSA_KEY_SIZE
+  const int64_t STALE_TEMP_SECONDS = 3600; // 进程中途退出留下的临时与已认领文件
+
+  std::atomic<uint64_t> sequence{0};
+
+  bool parseKeyBits(std::string text, int &bits)
+  {
+    text.erase(std::remove(text.begin(), text.end(), '"'), text.end());
+    char *end = nullptr;
+    const long value = strtol(text.c_str(), &end, 10);
+    if (end == text.c_str() || *end != '\0' || value < 1024 || value > 16384)
+      return false;
+    bits = static_cast<int>(value);
+    return true;
+  }
+
+  // 与 build-client-full 生成的 RSA 密钥长度一致：环境变量 EASYRSA_KEY_SIZE 优先，其次 easy-rsa 加载的 vars
+  // （pki/vars 优先于安装目录下的 vars，只加载找到的第一个），都未设置时为 easy-rsa 的默认值
+  int rsaKeyBits()
+  {
+    int bits = DEFAULT_RSA_BITS;
+    if (const char *env = getenv("EASYRSA_KEY_SIZE"))
+    {
+      if (parseKeyBits(env, bits))
+        return bits;
+    }
+    for (const std::string &path : {EASY_RSA_DIR + "/pki/vars", EASY_RSA_DIR + "/vars"})
+    {
+      std::ifstream vars(path);
+      if (!vars.is_open())
+        continue;
+      std::string line;
+      while (std::getline(vars, line))
+      {
+        std::istringstream fields(line);
+        std::string command, name, value;
+        if (fields >> command >> name >> value && command == "set_var" && name == "EASYRSA_KEY_SIZE")
+          parseKeyBits(value, bits);
+      }
+      break;
+    }
+    return bits;
+  }
+
+  // 本进程内唯一的文件名后缀
+  std::string uniqueSuffix()
+  {
+    return std::to_string(getpid()) + "-" + std::to_string(sequence.fetch_add(1));
+  }
+
+  bool writeAll(int fd, const char *p, size_t left)
+  {
+    while (left > 0)
+    {
+      ssize_t n = write(fd, p, left);
+      if (n < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        return false;
+      }
+      p += n;
+      left -= n;
+    }
+    return true;
+  }
+
+  bool readAll(const std::string &path, std::string &content)
+  {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return false;
+    content.clear();
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0)
+      content.append(buffer, n);
+    OPENSSL_cleanse(buffer, sizeof(buffer));
+    close(fd);
+    return n == 0;
+  }
+
+  uint32_t effectiveLowWater(const KeyPoolOptions &options)
+  {
+    uint32_t low = options.lowWater ? options.lowWater : options.size / 4;
+    return std::max<uint32_t>(1, std::min(low, options.size));
+  }
+
+  int64_t nowSeconds()
+  {
+    return time(nullptr);
+  }
+}
+
+KeyPool::KeyPool(const std::string &dir) : dir(dir) {}
+
+KeyPool::~KeyPool()
+{
+  stop();
+}
+
+KeyPool &KeyPool::instance()
+{
+  static KeyPool pool(OVPN_DIR + "/ovpn-mana/keypool");
+  return pool;
+}
+
+std::string KeyPool::algorithmDir(KeyAlgorithm algorithm) const
+{
+  return dir + "/" + KeySpec::of(algorithm).name;
+}
+
+// 目录逐级创建为 0700，已存在时收紧权限
+static bool ensurePrivateDir(const std::string &path)
+{
+  size_t pos = 0;
+  while ((pos = path.find('/', pos + 1)) != std::string::npos)
+  {
+    mkdir(path.substr(0, pos).c_str(), 0755);
+  }
+  if (mkdir(path.c_str(), 0700) != 0 && errno != EEXIST)
+    return false;
+  return chmod(path.c_str(), 0700) == 0;
+}
+
+bool KeyPool::readState(KeyAlgorithm algorithm, State &state) const
+{
+  memset(&state, 0, sizeof(state));
+  int fd = open((algorithmDir(algorithm) + STATE_FILE).c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return errno == ENOENT; // 未配置过的算法：池未启用，统计为零
+  flock(fd, LOCK_SH);
+  ssize_t n = pread(fd, &state, sizeof(state), 0);
+  close(fd);
+  if (n != static_cast<ssize_t>(sizeof(state)) || !state.valid())
+  {
+    memset(&state, 0, sizeof(state));
+    return false;
+  }
+  return true;
+}
+
+bool KeyPool::updateState(KeyAlgorithm algorithm, const std::function<void(State &)> &update) const
+{
+  const std::string path = algorithmDir(algorithm);
+  if (!ensurePrivateDir(path))
+  {
+    std::cerr << "Failed to create key pool directory: " << path << std::endl;
+    return false;
+  }
+  int fd = open((path + STATE_FILE).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd < 0)
+    return false;
+  flock(fd, LOCK_EX);
+  State state;
+  if (pread(fd, &state, sizeof(state), 0) != static_cast<ssize_t>(sizeof(state)) || !state.valid())
+  {
+    // 新建或损坏：以默认设置（未启用）重新开始
+    memset(&state, 0, sizeof(state));
+    memcpy(state.magic, "OVPNKEY", 8);
+    state.version = 1;
+    KeyPoolOptions defaults;
+    state.maxAgeSeconds = defaults.maxAgeSeconds;
+    state.shred = defaults.shred;
+  }
+  update(state);
+  bool ok = pwrite(fd, &state, sizeof(state), 0) == static_cast<ssize_t>(sizeof(state));
+  close(fd);
+  return ok;
+}
+
+bool KeyPool::configure(KeyAlgorithm algorithm, const KeyPoolOptions &options)
+{
+  if (options.lowWater > options.size)
+  {
+    std::cerr << "Key pool low water mark exceeds pool size" << std::endl;
+    return false;
+  }
+  bool ok = updateState(algorithm, [&](State &state)
+                        {
+    state.size = options.size;
+    state.lowWater = options.lowWater;
+    state.maxAgeSeconds = options.maxAgeSeconds;
+    state.shred = options.shred ? 1 : 0; });
+  if (ok)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending = true;
+    wakeup.notify_all();
+  }
+  return ok;
+}
+
+bool KeyPool::options(KeyAlgorithm algorithm, KeyPoolOptions &options) const
+{
+  State state;
+  if (!readState(algorithm, state))
+    return false;
+  options = state.valid() ? state.options() : KeyPoolOptions();
+  return true;
+}
+
+bool KeyPool::stats(KeyAlgorithm algorithm, KeyPoolStats &stats) const
+{
+  State state;
+  if (!readState(algorithm, state))
+    return false;
+  stats.available = static_cast<uint32_t>(listKeys(algorithmDir(algorithm)).size());
+  stats.hits = state.hits;
+  stats.misses = state.misses;
+  stats.generated = state.generated;
+  stats.destroyed = state.destroyed;
+  return true;
+}
+
+// 目录中可用的密钥文件；olderThan > 0 时只列出修改时间早于它的文件
+std::vector<std::string> KeyPool::listKeys(const std::string &path, int64_t olderThan) const
+{
+  std::vector<std::string> keys;
+  DIR *d = opendir(path.c_str());
+  if (!d)
+    return keys;
+  const size_t suffixLength = strlen(KEY_SUFFIX);
+  while (struct dirent *entry = readdir(d))
+  {
+    const size_t length = strlen(entry->d_name);
+    if (entry->d_name[0] == '.' || length <= suffixLength ||
+        strcmp(entry->d_name + length - suffixLength, KEY_SUFFIX) != 0)
+      continue;
+    std::string file = path + "/" + entry->d_name;
+    if (olderThan > 0)
+    {
+      struct stat st;
+      if (stat(file.c_str(), &st) != 0 || st.st_mtime >= olderThan)
+        continue;
+    }
+    keys.push_back(std::move(file));
+  }
+  closedir(d);
+  return keys;
+}
+
+// 以 0600 的 O_EXCL 临时文件写入，fsync 后改名为可取用的密钥文件
+bool KeyPool::store(const std::string &path, const std::string &keyPem) const
+{
+  const std::string suffix = uniqueSuffix();
+  const std::string tmpPath = path + "/.tmp-" + suffix;
+  int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if (fd < 0)
+    return false;
+  bool ok = writeAll(fd, keyPem.data(), keyPem.size()) && fsync(fd) == 0;
+  ok = (close(fd) == 0) && ok;
+  const std::string keyPath = path + "/" + std::to_string(nowSeconds()) + "-" + suffix + KEY_SUFFIX;
+  if (!ok || rename(tmpPath.c_str(), keyPath.c_str()) != 0)
+  {
+    destroy(tmpPath, true);
+    return false;
+  }
+  return true;
+}
+
+// 覆盖后删除：以零写满原长度并 fsync，使私钥不再以明文留在原数据块中（文件系统允许时）
+bool KeyPool::destroy(const std::string &path, bool shred) const
+{
+  if (shred)
+  {
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+      struct stat st;
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+      {
+        std::string zeros(static_cast<size_t>(st.st_size), '\0');
+        if (writeAll(fd, zeros.data(), zeros.size()))
+          fsync(fd);
+      }
+      close(fd);
+    }
+  }
+  return unlink(path.c_str()) == 0 || errno == ENOENT;
+}
+
+bool KeyPool::take(KeyAlgorithm algorithm, std::string &keyPem)
+{
+  State state;
+  if (!readState(algorithm, state) || state.size == 0)
+    return false;
+
+  const std::string path = algorithmDir(algorithm);
+  bool taken = false;
+  for (const std::string &key : listKeys(path))
+  {
+    // rename 是原子的：并发取用同一文件时只有一个进程成功，其余得到 ENOENT 后尝试下一个
+    const std::string claimed = path + "/.claim-" + uniqueSuffix();
+    if (rename(key.c_str(), claimed.c_str()) != 0)
+      continue;
+    taken = readAll(claimed, keyPem);
+    destroy(claimed, state.shred != 0);
+    if (taken)
+      break;
+    OPENSSL_cleanse(&keyPem[0], keyPem.size());
+    keyPem.clear();
+  }
+
+  updateState(algorithm, [&](State &s)
+              { (taken ? s.hits : s.misses)++; });
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending = true;
+  }
+  wakeup.notify_all();
+  return taken;
+}
+
+void KeyPool::recordFailure(KeyAlgorithm algorithm)
+{
+  updateState(algorithm, [](State &s)
+              {
+                if (s.hits > 0)
+                  --s.hits;
+                ++s.misses;
+              });
+}
+
+bool KeyPool::fill(KeyAlgorithm algorithm, int &generated)
+{
+  generated = 0;
+  KeyPoolOptions opts;
+  if (!options(algorithm, opts))
+    return false;
+  const std::string path = algorithmDir(algorithm);
+  if (!ensurePrivateDir(path))
+  {
+    std::cerr << "Failed to create key pool directory: " << path << std::endl;
+    return false;
+  }
+
+  // 清理过期密钥与中途退出留下的临时文件
+  int destroyed = 0;
+  const int64_t now = nowSeconds();
+  if (opts.maxAgeSeconds > 0)
+  {
+    for (const std::string &key : listKeys(path, now - opts.maxAgeSeconds))
+    {
+      if (destroy(key, opts.shred))
+        ++destroyed;
+    }
+  }
+  if (DIR *d = opendir(path.c_str()))
+  {
+    while (struct dirent *entry = readdir(d))
+    {
+      if (strncmp(entry->d_name, ".tmp-", 5) != 0 && strncmp(entry->d_name, ".claim-", 7) != 0)
+        continue;
+      const std::string file = path + "/" + entry->d_name;
+      struct stat st;
+      if (stat(file.c_str(), &st) == 0 && st.st_mtime < now - STALE_TEMP_SECONDS)
+        destroy(file, true);
+    }
+    closedir(d);
+  }
+
+  const size_t available = listKeys(path).size();
+  bool ok = true;
+  for (size_t i = available; i < opts.size; ++i)
+  {
+    std::string keyPem;
+    ok = generate(algorithm, keyPem) && store(path, keyPem);
+    OPENSSL_cleanse(&keyPem[0], keyPem.size());
+    if (!ok)
+    {
+      std::cerr << "Failed to generate pooled key in " << path << std::endl;
+      break;
+    }
+    ++generated;
+  }
+
+  if (generated > 0 || destroyed > 0)
+  {
+    updateState(algorithm, [&](State &state)
+                {
+      state.generated += generated;
+      state.destroyed += destroyed; });
+  }
+  return ok;
+}
+
+bool KeyPool::drain(KeyAlgorithm algorithm, int &destroyed)
+{
+  destroyed = 0;
+  KeyPoolOptions opts;
+  if (!options(algorithm, opts))
+    return false;
+  for (const std::string &key : listKeys(algorithmDir(algorithm)))
+  {
+    if (destroy(key, opts.shred))
+      ++destroyed;
+  }
+  if (destroyed > 0)
+  {
+    updateState(algorithm, [&](State &state)
+                { state.destroyed += destroyed; });
+  }
+  return true;
+}
+
+void KeyPool::start(int intervalSeconds)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (worker.joinable())
+    return;
+  stopping = false;
+  pending = true;
+  worker = std::thread(&KeyPool::run, this, std::max(1, intervalSeconds));
+}
+
+void KeyPool::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!worker.joinable())
+      return;
+    stopping = true;
+  }
+  wakeup.notify_all();
+  worker.join();
+}
+
+// 后台线程：定时或有取用时检查各算法，低于低水位的补充到目标数量；生成时不持有锁
+void KeyPool::run(int intervalSeconds)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!stopping)
+  {
+    pending = false;
+    lock.unlock();
+    for (const KeySpec &spec : KeySpec::all())
+    {
+      KeyPoolOptions opts;
+      KeyPoolStats current;
+      if (!options(spec.algorithm, opts) || opts.size == 0 || !stats(spec.algorithm, current))
+        continue;
+      if (current.available < effectiveLowWater(opts))
+      {
+        int generated = 0;
+        fill(spec.algorithm, generated);
+      }
+    }
+    lock.lock();
+    wakeup.wait_for(lock, std::chrono::seconds(intervalSeconds), [this]
+                    { return stopping || pending; });
+  }
+}
+
+bool KeyPool::generate(KeyAlgorithm algorithm, std::string &keyPem)
+{
+  const KeySpec &spec = KeySpec::of(algorithm);
+  int type = EVP_PKEY_RSA;
+  if (algorithm == KeyAlgorithm::Ed25519)
+    type = EVP_PKEY_ED25519;
+  else if (!spec.easyrsaCurve.empty())
+    type = EVP_PKEY_EC;
+
+  std::unique_ptr<EVP_PKEY_CTX, void (*)(EVP_PKEY_CTX *)> ctx(EVP_PKEY_CTX_new_id(type, nullptr), EVP_PKEY_CTX_free);
+  if (!ctx || EVP_PKEY_keygen_init(ctx.get()) <= 0)
+    return false;
+  if (type == EVP_PKEY_RSA && EVP_PKEY_CTX_set_rsa_keygen_bits(ctx.get(), rsaKeyBits()) <= 0)
+    return false;
+  if (type == EVP_PKEY_EC &&
+      (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx.get(), OBJ_sn2nid(spec.easyrsaCurve.c_str())) <= 0 ||
+       EVP_PKEY_CTX_set_ec_param_enc(ctx.get(), OPENSSL_EC_NAMED_CURVE) <= 0))
+    return false;
+
+  EVP_PKEY *raw = nullptr;
+  if (EVP_PKEY_keygen(ctx.get(), &raw) <= 0)
+    return false;
+  std::unique_ptr<EVP_PKEY, void (*)(EVP_PKEY *)> key(raw, EVP_PKEY_free);
+
+  // 安全内存 BIO：释放时清零，私钥不在普通堆中残留
+  std::unique_ptr<BIO, int (*)(BIO *)> bio(BIO_new(BIO_s_secmem()), BIO_free);
+  if (!bio || !PEM_write_bio_PrivateKey(bio.get(), key.get(), nullptr, nullptr, 0, nullptr, nullptr))
+    return false;
+  char *data = nullptr;
+  long len = BIO_get_mem_data(bio.get(), &data);
+  keyPem.assign(data, len);
+  return true;
+}
+
+bool KeyPool::buildRequest(const std::string &keyPem, const std::string &commonName, std::string &requestPem)
+{
+  std::unique_ptr<BIO, int (*)(BIO *)> in(BIO_new_mem_buf(keyPem.data(), static_cast<int>(keyPem.size())), BIO_free);
+  if (!in)
+    return false;
+  std::unique_ptr<EVP_PKEY, void (*)(EVP_PKEY *)> key(PEM_read_bio_PrivateKey(in.get(), nullptr, nullptr, nullptr),
+                                                      EVP_PKEY_free);
+  std::unique_ptr<X509_REQ, void (*)(X509_REQ *)> req(X509_REQ_new(), X509_REQ_free);
+  if (!key || !req)
+    return false;
+
+  X509_NAME *subject = X509_REQ_get_subject_name(req.get());
+  // Ed25519 不使用单独的摘要算法
+  const EVP_MD *md = EVP_PKEY_id(key.get()) == EVP_PKEY_ED25519 ? nullptr : EVP_sha256();
+  bool ok = X509_REQ_set_version(req.get(), 0) &&
+            X509_NAME_add_entry_by_txt(subject, "CN", MBSTRING_UTF8,
+                                       reinterpret_cast<const unsigned char *>(commonName.c_str()), -1, -1, 0) &&
+            X509_REQ_set_pubkey(req.get(), key.get()) && X509_REQ_sign(req.get(), key.get(), md) > 0;
+  if (!ok)
+    return false;
+
+  std::unique_ptr<BIO, int (*)(BIO *)> out(BIO_new(BIO_s_mem()), BIO_free);
+  if (!out || !PEM_write_bio_X509_REQ(out.get(), req.get()))
+    return false;
+  char *data = nullptr;
+  long len = BIO_get_mem_data(out.get(), &data);
+  requestPem.assign(data, len);
+  return true;
+}
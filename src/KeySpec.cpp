@@ -0,0 +1,74 @@
+#include "KeySpec.hpp"
+
+const std::string KeySpec::MARKER = "# ovpn-mana key ";
+
+const std::vector<KeySpec> &KeySpec::all()
+{
+  static const std::vector<KeySpec> specs = {
+      {KeyAlgorithm::Rsa, "rsa", "rsa", "", "", ""},
+      {KeyAlgorithm::EcP256, "p256", "ec", "prime256v1", "prime256v1", ""},
+      {KeyAlgorithm::EcP384, "p384", "ec", "secp384r1", "secp384r1", ""},
+      // Ed25519 只用于签名，密钥交换使用对应的 X25519
+      {KeyAlgorithm::Ed25519, "ed25519", "ed", "ed25519", "", "X25519"},
+  };
+  return specs;
+}
+
+const KeySpec &KeySpec::of(KeyAlgorithm algorithm)
+{
+  for (const auto &spec : all())
+  {
+    if (spec.algorithm == algorithm)
+      return spec;
+  }
+  return all().front();
+}
+
+const KeySpec *KeySpec::find(const std::string &name)
+{
+  for (const auto &spec : all())
+  {
+    if (spec.name == name)
+      return &spec;
+  }
+  return nullptr;
+}
+
+const KeySpec &KeySpec::fromServerConfig(const std::vector<std::string> &comments, const std::string &ecdhCurve)
+{
+  for (const auto &comment : comments)
+  {
+    if (comment.rfind(MARKER, 0) != 0)
+      continue;
+    if (const KeySpec *spec = find(comment.substr(MARKER.size())))
+      return *spec;
+  }
+  // 早期版本以 ecdh-curve 记录算法，Ed25519 服务写的是 X25519
+  if (ecdhCurve == "X25519")
+    return of(KeyAlgorithm::Ed25519);
+  for (const auto &spec : all())
+  {
+    if (!spec.ecdhCurve.empty() && spec.ecdhCurve == ecdhCurve)
+      return spec;
+  }
+  return all().front();
+}
+
+std::string KeySpec::easyrsaOptions() const
+{
+  if (easyrsaCurve.empty())
+    return " ";
+  return " --use-algo=" + easyrsaAlgo + " --curve=" + easyrsaCurve + " ";
+}
+
+std::string KeySpec::keyExchange(const std::string &dhPath) const
+{
+  if (usesDh())
+    return "dh " + dhPath + "\n";
+  std::string block = marker() + "\ndh none\n";
+  if (!ecdhCurve.empty())
+    block += "ecdh-curve " + ecdhCurve + "\n";
+  if (!tlsGroups.empty())
+    block += "tls-groups " + tlsGroups + "\n";
+  return block;
+}
@@ -0,0 +1,153 @@
+#include "ManagementClient.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace
+{
+  // 去掉应答前缀及其后的空格
+  std::string stripPrefix(const std::string &line, size_t prefixLength)
+  {
+    size_t start = line.find_first_not_of(' ', prefixLength);
+    return start == std::string::npos ? "" : line.substr(start);
+  }
+}
+
+ManagementClient::~ManagementClient()
+{
+  close();
+}
+
+bool ManagementClient::connect(const std::string &socketPath)
+{
+  close();
+  struct sockaddr_un addr = {};
+  if (socketPath.size() >= sizeof(addr.sun_path))
+    return false;
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return false;
+  if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+  {
+    // 保留 connect 的错误码，调用方据此区分实例未运行
+    int error = errno;
+    close();
+    errno = error;
+    return false;
+  }
+
+  // 欢迎信息形如 >INFO:OpenVPN Management Interface Version 5 ...
+  std::string line;
+  if (!readLine(line) || line.compare(0, 6, ">INFO:") != 0)
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void ManagementClient::close()
+{
+  if (fd >= 0)
+    ::close(fd);
+  fd = -1;
+  buffer.clear();
+}
+
+bool ManagementClient::command(const std::string &cmd, std::string &reply)
+{
+  reply.clear();
+  if (fd < 0 || !writeAll(cmd + "\n"))
+    return false;
+
+  std::string line;
+  while (readLine(line))
+  {
+    if (line.compare(0, 8, "SUCCESS:") == 0)
+    {
+      reply = stripPrefix(line, 8);
+      return true;
+    }
+    if (line.compare(0, 6, "ERROR:") == 0)
+    {
+      reply = stripPrefix(line, 6);
+      return false;
+    }
+    // 其余为 > 开头的实时通知
+  }
+  reply = "no reply from management interface";
+  return false;
+}
+
+bool ManagementClient::killClient(const std::string &commonName)
+{
+  // 参数按配置文件规则解析，加引号并转义以容纳空格等字符
+  std::string quoted = "\"";
+  for (char c : commonName)
+  {
+    if (c == '"' || c == '\\')
+      quoted += '\\';
+    quoted += c;
+  }
+  quoted += "\"";
+
+  std::string reply;
+  if (command("kill " + quoted, reply))
+    return true;
+  return reply.find("not found") != std::string::npos;
+}
+
+bool ManagementClient::readLine(std::string &line)
+{
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+  size_t eol;
+  while ((eol = buffer.find('\n')) == std::string::npos)
+  {
+    int remaining = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count());
+    if (remaining <= 0)
+      return false;
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, remaining);
+    if (ready < 0 && errno == EINTR)
+      continue;
+    if (ready <= 0)
+      return false;
+
+    char chunk[1024];
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    buffer.append(chunk, n);
+  }
+  line = buffer.substr(0, eol);
+  buffer.erase(0, eol + 1);
+  if (!line.empty() && line.back() == '\r')
+    line.pop_back();
+  return true;
+}
+
+bool ManagementClient::writeAll(const std::string &data)
+{
+  size_t written = 0;
+  while (written < data.size())
+  {
+    ssize_t n = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    written += n;
+  }
+  return true;
+}
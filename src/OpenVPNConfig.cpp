@@ -0,0 +1,189 @@
+#include "OpenVPNConfig.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace
+{
+  // 切分一行参数：空白分隔，单引号内原样保留，双引号与无引号部分支持反斜杠转义，
+  // 不在参数中间的 # 或 ; 开始注释
+  std::vector<std::string> tokenize(const std::string &line)
+  {
+    std::vector<std::string> tokens;
+    std::string token;
+    bool inToken = false;
+    char quote = 0;
+    for (size_t i = 0; i < line.size(); ++i)
+    {
+      char c = line[i];
+      if (quote == '\'')
+      {
+        if (c == '\'')
+          quote = 0;
+        else
+          token += c;
+        continue;
+      }
+      if (c == '\\' && i + 1 < line.size())
+      {
+        token += line[++i];
+        inToken = true;
+        continue;
+      }
+      if (quote == '"')
+      {
+        if (c == '"')
+          quote = 0;
+        else
+          token += c;
+        continue;
+      }
+      if (c == '"' || c == '\'')
+      {
+        quote = c;
+        inToken = true;
+        continue;
+      }
+      if (c == ' ' || c == '\t' || c == '\r')
+      {
+        if (inToken)
+        {
+          tokens.push_back(token);
+          token.clear();
+          inToken = false;
+        }
+        continue;
+      }
+      if (!inToken && (c == '#' || c == ';'))
+        break;
+      token += c;
+      inToken = true;
+    }
+    if (inToken)
+      tokens.push_back(token);
+    return tokens;
+  }
+
+  struct CachedConfig
+  {
+    struct timespec mtime;
+    off_t size;
+    std::shared_ptr<const OpenVPNConfig> config;
+  };
+}
+
+std::shared_ptr<const OpenVPNConfig> OpenVPNConfig::parse(const std::string &text)
+{
+  auto config = std::make_shared<OpenVPNConfig>();
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line))
+  {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos)
+      continue;
+
+    if (line[start] == '#' || line[start] == ';')
+    {
+      config->commentLines.push_back(line.substr(start));
+      continue;
+    }
+
+    // 内联块 <tag> ... </tag>
+    if (line[start] == '<' && line.find('>', start) != std::string::npos)
+    {
+      std::string tag = line.substr(start + 1, line.find('>', start) - start - 1);
+      std::string end = "</" + tag + ">";
+      std::string content;
+      while (std::getline(lines, line))
+      {
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos != std::string::npos && line.compare(pos, end.size(), end) == 0)
+          break;
+        content += line + "\n";
+      }
+      config->blocks[tag] = content;
+      continue;
+    }
+
+    std::vector<std::string> tokens = tokenize(line);
+    if (tokens.empty())
+      continue;
+    std::string directive = tokens.front();
+    if (directive.rfind("--", 0) == 0)
+      directive.erase(0, 2);
+    config->directives[directive].emplace_back(tokens.begin() + 1, tokens.end());
+  }
+  return config;
+}
+
+std::shared_ptr<const OpenVPNConfig> OpenVPNConfig::load(const std::string &path)
+{
+  static std::mutex mutex;
+  static std::map<std::string, CachedConfig> cache;
+
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+    return nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(path);
+    if (it != cache.end() && it->second.mtime.tv_sec == st.st_mtim.tv_sec &&
+        it->second.mtime.tv_nsec == st.st_mtim.tv_nsec && it->second.size == st.st_size)
+      return it->second.config;
+  }
+
+  std::ifstream file(path);
+  if (!file.is_open())
+    return nullptr;
+  std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::shared_ptr<const OpenVPNConfig> config = parse(text);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  cache[path] = CachedConfig{st.st_mtim, st.st_size, config};
+  return config;
+}
+
+bool OpenVPNConfig::has(const std::string &directive) const
+{
+  return directives.count(directive) != 0;
+}
+
+const OpenVPNConfig::Args *OpenVPNConfig::find(const std::string &directive) const
+{
+  auto it = directives.find(directive);
+  return it == directives.end() ? nullptr : &it->second.front();
+}
+
+const std::vector<OpenVPNConfig::Args> &OpenVPNConfig::findAll(const std::string &directive) const
+{
+  static const std::vector<Args> empty;
+  auto it = directives.find(directive);
+  return it == directives.end() ? empty : it->second;
+}
+
+std::string OpenVPNConfig::get(const std::string &directive, size_t index, const std::string &fallback) const
+{
+  const Args *args = find(directive);
+  return args && index < args->size() ? (*args)[index] : fallback;
+}
+
+int OpenVPNConfig::getInt(const std::string &directive, size_t index, int fallback) const
+{
+  const Args *args = find(directive);
+  if (!args || index >= args->size())
+    return fallback;
+  char *end = nullptr;
+  long value = strtol((*args)[index].c_str(), &end, 10);
+  return end && *end == '\0' ? static_cast<int>(value) : fallback;
+}
+
+const std::string *OpenVPNConfig::inlineBlock(const std::string &tag) const
+{
+  auto it = blocks.find(tag);
+  return it == blocks.end() ? nullptr : &it->second;
+}
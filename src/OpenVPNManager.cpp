@@ -1,74 +1,489 @@
 ﻿#include "OpenVPNManager.hpp"
 #include "config.hpp"
+#include "CrlManager.hpp"
+#include "IpAllocator.hpp"
+#include "ConfigProfile.hpp"
+#include "ConfigTemplate.hpp"
+#include "FileInstaller.hpp"
+#include "StagingDir.hpp"
+#include "ServiceRegistry.hpp"
+#include "OpenVPNConfig.hpp"
+#include "ProcessWatch.hpp"
+#include "ManagementClient.hpp"
+#include "ClientSnapshot.hpp"
+#include "SharedClientTable.hpp"
+#include "SessionLog.hpp"
+#include "UsagePolicy.hpp"
+#include "TrafficShaper.hpp"
+#include "KeyPool.hpp"
 #include <iomanip>
 #include <fstream>
 #include <sstream>
 #include <array>
-#include <thread>
+#include <deque>
 #include <iostream>
 #include <memory>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <unordered_map>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
 #if defined(UNIX) || defined(__unix__) || defined(__APPLE__)
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fnmatch.h>
 #else
 #define getuid() 0
 #define popen _popen
 #define pclose _pclose
+// _pclose 直接返回退出码
+#define WIFEXITED(status) true
+#define WEXITSTATUS(status) (status)
+#define WIFSIGNALED(status) false
+#define WTERMSIG(status) 0
 #endif
 
 namespace fs = std::filesystem;
 
+namespace
+{
+  // 地址位图的进程间排他锁，防止并发创建客户端时重复分配
+  class BitmapLock
+  {
+  public:
+    explicit BitmapLock(const std::string &path)
+        : fd(open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600))
+    {
+      if (fd >= 0)
+        flock(fd, LOCK_EX);
+    }
+    ~BitmapLock()
+    {
+      if (fd >= 0)
+        close(fd);
+    }
+
+  private:
+    int fd;
+  };
+
+  // 生成 OpenVPN 静态密钥（2048 位，与 openvpn --genkey secret 输出格式一致）
+  bool generateStaticKey(std::string &key)
+  {
+    unsigned char random[256];
+    if (RAND_bytes(random, sizeof(random)) != 1)
+      return false;
+
+    static const char HEX[] = "0123456789abcdef";
+    key = "#\n# 2048 bit OpenVPN static key\n#\n-----BEGIN OpenVPN Static key V1-----\n";
+    for (size_t i = 0; i < sizeof(random); ++i)
+    {
+      key += HEX[random[i] >> 4];
+      key += HEX[random[i] & 0x0f];
+      if (i % 16 == 15)
+        key += '\n';
+    }
+    key += "-----END OpenVPN Static key V1-----\n";
+    OPENSSL_cleanse(random, sizeof(random));
+    return true;
+  }
+
+  // 按修改时间缓存的文件内容，批量创建客户端时 CA 证书与 tls-auth 密钥无需逐个重新读取
+  std::shared_ptr<const std::string> readCachedFile(const std::string &path, bool cache = true)
+  {
+    struct CachedFile
+    {
+      fs::file_time_type mtime;
+      std::shared_ptr<const std::string> content;
+    };
+    static std::mutex mutex;
+    static std::map<std::string, CachedFile> files;
+
+    std::error_code ec;
+    fs::file_time_type mtime = fs::last_write_time(path, ec);
+    if (ec)
+      return nullptr;
+
+    if (cache)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = files.find(path);
+      if (it != files.end() && it->second.mtime == mtime)
+        return it->second.content;
+    }
+
+    std::ifstream file(path);
+    if (!file.is_open())
+      return nullptr;
+    auto content = std::make_shared<const std::string>((std::istreambuf_iterator<char>(file)),
+                                                       std::istreambuf_iterator<char>());
+    if (cache)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      files[path] = CachedFile{mtime, content};
+    }
+    return content;
+  }
+
+  // 服务的在线客户端快照缓存：状态文件的修改时间与大小不变时复用快照及其索引
+  struct CachedSnapshot
+  {
+    std::vector<std::string> statusFiles;
+    std::vector<std::pair<struct timespec, off_t>> stamps;
+    std::chrono::steady_clock::time_point checkedAt;
+    std::shared_ptr<const ClientSnapshot> snapshot;
+    uint64_t version = 0;
+    // 最近的快照（含当前）及其版本，按版本升序
+    std::deque<std::pair<uint64_t, std::shared_ptr<const ClientSnapshot>>> history;
+  };
+
+  std::mutex snapshotMutex;
+  std::unordered_map<std::string, CachedSnapshot> snapshotCache;
+
+  // 快照版本全局递增，起点取进程启动时间，使其他进程或上次运行得到的版本不会误命中历史
+  uint64_t nextSnapshotVersion()
+  {
+    static uint64_t version = static_cast<uint64_t>(time(nullptr)) << 20;
+    return ++version;
+  }
+
+  std::vector<std::pair<struct timespec, off_t>> statStatusFiles(const std::vector<std::string> &statusFiles)
+  {
+    std::vector<std::pair<struct timespec, off_t>> stamps;
+    stamps.reserve(statusFiles.size());
+    for (const auto &path : statusFiles)
+    {
+      struct stat st;
+      if (stat(path.c_str(), &st) == 0)
+        stamps.emplace_back(st.st_mtim, st.st_size);
+      else
+        stamps.emplace_back(timespec{0, 0}, -1);
+    }
+    return stamps;
+  }
+
+  bool sameStamps(const std::vector<std::pair<struct timespec, off_t>> &a,
+                  const std::vector<std::pair<struct timespec, off_t>> &b)
+  {
+    if (a.size() != b.size())
+      return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+      if (a[i].first.tv_sec != b[i].first.tv_sec || a[i].first.tv_nsec != b[i].first.tv_nsec ||
+          a[i].second != b[i].second)
+        return false;
+    }
+    return true;
+  }
+}
+
 // 辅助函数：执行shell命令
 bool OpenVPNManager::execCommand(const std::string &cmd, std::string &output)
+{
+  int exitStatus;
+  execCommand(cmd, output, exitStatus);
+  return exitStatus != -1;
+}
+
+// 同时返回命令的退出码（无法启动时为 -1，被信号终止时按 shell 惯例为 128 + 信号），退出码为 0 时返回 true
+bool OpenVPNManager::execCommand(const std::string &cmd, std::string &output, int &exitStatus)
 {
   // 打印命令
   std::cout << "Executing command: " << cmd << std::endl;
 
+  exitStatus = -1;
   std::array<char, 128> buffer;
-  std::unique_ptr<FILE, int (*)(FILE *)> pipe(popen(cmd.c_str(), "r"), pclose);
+  FILE *pipe = popen(cmd.c_str(), "r");
   if (!pipe)
     return false;
-  while (fgets(buffer.data(), buffer.size(), pipe.get()))
+  while (fgets(buffer.data(), buffer.size(), pipe))
   {
     output += buffer.data();
   }
+  const int status = pclose(pipe);
+  if (status != -1 && WIFEXITED(status))
+    exitStatus = WEXITSTATUS(status);
+  else if (status != -1 && WIFSIGNALED(status))
+    exitStatus = 128 + WTERMSIG(status);
   std::cout << "Executing command result: " << output << std::endl;
-  return true;
+  return exitStatus == 0;
 }
 
-// 服务列表
-std::vector<VPNService> OpenVPNManager::listServices()
+OpenVPNManager::OpenVPNManager()
 {
-  std::vector<VPNService> services;
-  fs::path ovpnDir(OVPN_DIR);
+  // 句柄创建时映射服务登记表，后续查询服务元数据不再扫描目录
+  registry().open();
+}
+
+// 服务登记表（登记文件位于 OVPN_DIR/ovpn-mana，以服务目录的修改时间判断是否过期）
+ServiceRegistry &OpenVPNManager::registry()
+{
+  // 监视 scanServices 实际读取的 OVPN_DIR/*-server.conf
+  static ServiceRegistry instance(OVPN_DIR + "/ovpn-mana/services.reg", OVPN_DIR, "-server.conf",
+                                  &OpenVPNManager::scanServices);
+  return instance;
+}
 
-  if (!fs::exists(ovpnDir))
-    return services;
+// 扫描 OVPN_DIR 下的服务端配置重建登记表（分片实例归并为一个逻辑服务）
+std::vector<ServiceRecord> OpenVPNManager::scanServices()
+{
+  std::vector<ServiceRecord> records;
+  std::map<std::string, bool> groups;
+  fs::path ovpnDir(OVPN_DIR);
+  std::error_code ec;
+  if (!fs::exists(ovpnDir, ec))
+    return records;
 
-  for (const auto &entry : fs::directory_iterator(ovpnDir))
+  for (const auto &entry : fs::directory_iterator(ovpnDir, ec))
   {
-    if (entry.is_regular_file() &&
-        entry.path().extension() == ".conf" &&
-        entry.path().filename().string().find("-server") != std::string::npos)
+    if (!entry.is_regular_file() ||
+        entry.path().extension() != ".conf" ||
+        entry.path().filename().string().find("-server") == std::string::npos)
+      continue;
+
+    std::string name = entry.path().stem().string();
+    name = name.substr(0, name.find("-server"));
+
+    // <分组>-<序号> 且分组存在分片信息时，归入分组
+    int shards = 1;
+    int basePort = 0;
+    size_t dash = name.rfind('-');
+    if (dash != std::string::npos && dash + 1 < name.size() &&
+        name.find_first_not_of("0123456789", dash + 1) == std::string::npos &&
+        readShardGroup(name.substr(0, dash), shards, basePort))
+    {
+      name = name.substr(0, dash);
+      if (groups.count(name))
+        continue;
+      groups[name] = true;
+    }
+    else
     {
+      shards = 1;
+    }
+
+    ServiceRecord record = {};
+    ServiceRegistry::setName(record, name);
+    record.shards = static_cast<uint8_t>(shards);
+    if (!readServiceRecord(getServiceConfigPath(shards > 1 ? name + "-0" : name), record))
+      continue;
+    records.push_back(record);
+  }
+  return records;
+}
 
-      std::string name = entry.path().stem().string();
-      name = name.substr(0, name.find("-server"));
+// 从服务端配置中恢复登记信息（首个实例的端口、协议、子网与档案）
+bool OpenVPNManager::readServiceRecord(const std::string &configPath, ServiceRecord &record)
+{
+  std::shared_ptr<const OpenVPNConfig> config = OpenVPNConfig::load(configPath);
+  if (!config)
+    return false;
 
-      VPNService service;
-      service.name = name;
-      service.configPath = entry.path().string();
-      service.isActive = isServiceActive(name);
-      service.isEnabled = isServiceEnabled(name);
-      services.push_back(service);
-    }
+  int shardBits = 0;
+  while ((1 << shardBits) < record.shards)
+    ++shardBits;
+  record.port = static_cast<uint16_t>(getListenPort(*config));
+  record.proto = config->get("proto", 0, "udp").rfind("tcp", 0) == 0 ? ServiceRecord::PROTO_TCP
+                                                                        : ServiceRecord::PROTO_UDP;
+  uint32_t mask = 0;
+  int prefixLength = 0;
+  if (!IpAllocator::parseAddress(config->get("server", 0), record.network) ||
+      !IpAllocator::parseAddress(config->get("server", 1), mask) ||
+      !servicePrefixLength(mask, shardBits, prefixLength))
+    return false;
+  record.prefixLength = static_cast<uint8_t>(prefixLength);
+
+  ConfigProfile profile = *ConfigProfile::find(ConfigProfile::DEFAULT_NAME);
+  for (const auto &comment : config->comments())
+  {
+    if (comment.rfind(ConfigProfile::MARKER, 0) == 0)
+      profile = ConfigProfile::fromServerConfig(comment);
   }
+  strncpy(record.profile, profile.name.c_str(), sizeof(record.profile) - 1);
+  record.dco = profile.dco;
+  record.dcoMode = static_cast<uint8_t>(config->has("disable-dco") ? DcoMode::Off : DcoMode::Auto);
+  record.keyAlgorithm =
+      static_cast<uint8_t>(KeySpec::fromServerConfig(config->comments(), config->get("ecdh-curve")).algorithm);
+  struct stat st;
+  record.createdAt = stat(configPath.c_str(), &st) == 0 ? st.st_mtime : 0;
+  return record.port != 0;
+}
+
+// 服务端监听端口：lport 优先于 port，均未配置时为 OpenVPN 默认端口
+int OpenVPNManager::getListenPort(const OpenVPNConfig &config)
+{
+  return config.getInt("lport", 0, config.getInt("port", 0, 1194));
+}
+
+int OpenVPNManager::maskToPrefix(uint32_t mask)
+{
+  int prefixLength = 0;
+  while (prefixLength < 32 && (mask & (0x80000000u >> prefixLength)))
+    ++prefixLength;
+  return prefixLength;
+}
+
+// 分片子网掩码还原为整个服务的前缀长度，配置被手工改动导致超出可分配范围时返回 false
+bool OpenVPNManager::servicePrefixLength(uint32_t shardMask, int shardBits, int &prefixLength)
+{
+  const int shardPrefix = maskToPrefix(shardMask);
+  if (shardPrefix < shardBits)
+    return false;
+  prefixLength = shardPrefix - shardBits;
+  return prefixLength >= IpAllocator::MIN_PREFIX_LENGTH && prefixLength <= IpAllocator::MAX_PREFIX_LENGTH;
+}
+
+// 解析服务（分片服务取首个分片）的服务端配置，子网按分片数还原为整个服务的子网
+bool OpenVPNManager::getServiceSettings(const std::string &name, ServiceSettings &settings)
+{
+  const std::vector<std::string> units = getServiceUnits(name);
+  std::shared_ptr<const OpenVPNConfig> config = OpenVPNConfig::load(getServiceConfigPath(units.front()));
+  if (!config)
+    return false;
+
+  int shardBits = 0;
+  while ((1u << shardBits) < units.size())
+    ++shardBits;
+  uint32_t network = 0;
+  uint32_t mask = 0;
+  int prefixLength = 0;
+  if (!IpAllocator::parseAddress(config->get("server", 0), network) ||
+      !IpAllocator::parseAddress(config->get("server", 1), mask) ||
+      !servicePrefixLength(mask, shardBits, prefixLength))
+    return false;
+
+  settings.port = getListenPort(*config);
+  settings.proto = config->get("proto", 0, "udp");
+  settings.subnet = IpAllocator::toString(network & IpAllocator::prefixToMask(prefixLength)) + "/" +
+                    std::to_string(prefixLength);
+  // data-ciphers 优先；只配置了旧版 cipher 时返回它；都没有时为 OpenVPN 2.6 的默认协商列表
+  settings.cipher = config->get("data-ciphers", 0, config->get("cipher", 0, "AES-256-GCM:AES-128-GCM:CHACHA20-POLY1305"));
+  // 登记表中记录了创建时的算法，未登记时从配置还原
+  ServiceRecord record;
+  if (registry().find(name, record))
+    settings.keyAlgorithm = static_cast<KeyAlgorithm>(record.keyAlgorithm);
+  else
+    settings.keyAlgorithm = KeySpec::fromServerConfig(config->comments(), config->get("ecdh-curve")).algorithm;
+  return true;
+}
+
+// 服务列表
+std::vector<VPNService> OpenVPNManager::listServices(unsigned fields)
+{
+  std::vector<VPNService> services;
+  visitServices(
+      [&](const VPNService &service)
+      {
+        services.push_back(service);
+        return true;
+      },
+      fields);
   return services;
 }
 
+// 逐个服务查询状态并回调，同一 VPNService 对象复用以减少分配
+void OpenVPNManager::visitServices(const std::function<bool(const VPNService &)> &visitor, unsigned fields)
+{
+  VPNService service;
+  for (const auto &record : registry().list())
+  {
+    describeService(record, fields, service);
+    if (!visitor(service))
+      break;
+  }
+}
+
+std::vector<ServiceRecord> OpenVPNManager::serviceRecords()
+{
+  return registry().list();
+}
+
+// systemd 状态需要调用 systemctl，只在调用方请求时查询
+void OpenVPNManager::describeService(const ServiceRecord &record, unsigned fields, VPNService &service)
+{
+  service.name = record.name;
+  service.shards = record.shards;
+  service.configPath = getServiceConfigPath(record.shards > 1 ? service.name + "-0" : service.name);
+  service.activeShards = 0;
+  service.isActive = false;
+  service.isEnabled = false;
+  service.dcoActive = false;
+  if (fields & (ServiceFields::STATE | ServiceFields::DCO))
+  {
+    service.activeShards = countActiveUnits(service.name);
+    service.isActive = service.activeShards == service.shards;
+  }
+  if (fields & ServiceFields::ENABLED)
+    service.isEnabled = isServiceEnabled(service.name);
+  if (fields & ServiceFields::DCO)
+    service.dcoActive = service.isActive && isDcoActive(service.name);
+}
+
 // 创建服务
-bool OpenVPNManager::createService(const std::string &name, const std::string& subnet, int port)
+bool OpenVPNManager::createService(const std::string &name, const std::string& subnet, int port, const ServiceOptions &options)
 {
+  // 解析子网与前缀长度
+  uint32_t network = 0;
+  int prefixLength = options.prefixLength;
+  if (!IpAllocator::parseSubnet(subnet, network, prefixLength))
+  {
+    std::cerr << "Invalid subnet " << subnet << ", prefix length must be between "
+              << IpAllocator::MIN_PREFIX_LENGTH << " and " << IpAllocator::MAX_PREFIX_LENGTH << std::endl;
+    return false;
+  }
+
+  // 分片数量须为2的幂，各分片平分子网
+  int shards = options.shards;
+  int shardBits = 0;
+  while ((1 << shardBits) < shards)
+    ++shardBits;
+  if (shards < 1 || shards > ServiceOptions::MAX_SHARDS || (1 << shardBits) != shards ||
+      prefixLength + shardBits > IpAllocator::MAX_PREFIX_LENGTH || port + shards - 1 > 65535)
+  {
+    std::cerr << "Invalid shard count " << shards << " for subnet " << subnet << std::endl;
+    return false;
+  }
+
+  // 性能档案
+  const ConfigProfile *profile = ConfigProfile::find(options.profile);
+  if (!profile)
+  {
+    std::cerr << "Unknown config profile " << options.profile << std::endl;
+    return false;
+  }
+
+  // 数据通道卸载：检测失败时按模式决定回退或报错
+  DcoStatus dcoStatus;
+  if (options.dco != DcoMode::Off)
+  {
+    dcoStatus = detectDco();
+  }
+  bool useDco = options.dco != DcoMode::Off && dcoStatus.available();
+  if (options.dco == DcoMode::Required && !useDco)
+  {
+    std::cerr << "DCO is required but not available (module loaded: " << dcoStatus.moduleLoaded
+              << ", openvpn support: " << dcoStatus.openvpnSupport << ")" << std::endl;
+    return false;
+  }
+  const ConfigProfile serviceProfile = useDco ? profile->forDco() : *profile;
+  std::cout << "Data channel offload: " << (useDco ? "enabled" : "disabled") << std::endl;
+
+  // 服务已存在（或与已有分片重名）时拒绝创建
+  ServiceRecord existing;
+  if (registry().find(name, existing) || fs::exists(getServiceConfigPath(name)) || fs::exists(getServiceDir(name)))
+  {
+    std::cerr << "Service " << name << " already exists" << std::endl;
+    return false;
+  }
+
   // 确保使用sudo权限运行
   if (getuid() != 0)
   {
@@ -81,7 +496,9 @@ bool OpenVPNManager::createService(const std::string &name, const std::string& s
   /// 生成服务证书
   /// ./easyrsa gen-req server nopass  # 生成服务器密钥对
   ///./easyrsa sign-req server server  # 用 CA 签发服务器证书
-  std::string cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa --batch gen-req " + name + "-server nopass";
+  const KeySpec &keySpec = KeySpec::of(options.keyAlgorithm);
+  std::string cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa --batch" + keySpec.easyrsaOptions() + "gen-req " + name +
+                    "-server nopass";
   std::string output;
   if (!execCommand(cmd, output))
     return false;
@@ -92,9 +509,8 @@ bool OpenVPNManager::createService(const std::string &name, const std::string& s
     return false;
   std::cout << "Signed request for " << name << std::endl;
 
-  // EASY_RSA_DIR/pki下是否存在dh.pem
-  // 不存在则生成一个
-  if (!fs::exists(EASY_RSA_DIR + "/pki/dh.pem"))
+  // RSA 服务使用 EASY_RSA_DIR/pki/dh.pem，不存在则生成一个；椭圆曲线服务以 dh none 只做 ECDHE
+  if (keySpec.usesDh() && !fs::exists(EASY_RSA_DIR + "/pki/dh.pem"))
   {
     std::cerr << "dh.pem not found, generating..." << std::endl;
     cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa gen-dh";
@@ -105,110 +521,316 @@ bool OpenVPNManager::createService(const std::string &name, const std::string& s
     }
   }
 
-  // 如果不存在目录OVPN_SERVER_CONF_DIR + "/" + name + "/ccd" 则创建一个
-  fs::path ccdDir(OVPN_SERVER_CONF_DIR + "/" + name + "/ccd");
-  if (!fs::exists(ccdDir))
+  // 配置以 crl-verify 引用 CRL，文件缺失时 OpenVPN 无法启动，先签发一份
+  const std::string crlPath = OVPN_DIR + "/crl.pem";
+  if (!fs::exists(crlPath) && !updateCrl("", 0))
+  {
+    std::cerr << "Failed to generate " << crlPath << std::endl;
+    return false;
+  }
+
+  // 整个服务树先在同一文件系统的暂存目录中构建，提交时一次落盘并依次发布，
+  // 失败时只需删除暂存目录，不会留下被 listServices 列出的半成品
+  StagingDir staging(OVPN_SERVER_CONF_DIR, name);
+  if (!staging.valid())
+  {
+    std::cerr << "Failed to create staging directory in " << OVPN_SERVER_CONF_DIR << std::endl;
+    return false;
+  }
+
+  // 服务目录存放证书与密钥，分片模式下各分片共用；配置内容引用最终路径
+  const std::string serviceDir = getServiceDir(name);
+  const std::string stagedServiceDir = staging.stagedPath("service");
+  try
+  {
+    fs::create_directories(stagedServiceDir);
+    fs::create_directories(staging.stagedPath("conf"));
+  }
+  catch (const fs::filesystem_error &e)
+  {
+    std::cerr << "Failed to create directory in " << staging.path() << ": " << e.what() << std::endl;
+    return false;
+  }
+
+  // 证书、TLS 密钥与配置文件登记到同一批次，全部暂存成功后统一原子落盘
+  // （暂存目录提交时统一 syncfs，此处不逐个 fsync）
+  FileInstaller installer;
+  installer.noReplace().durable(false);
+  const std::string prefix = EASY_RSA_DIR + "/pki/";
+  installer.copy(prefix + "ca.crt", stagedServiceDir + "/ca.crt", 0644)
+      .copy(prefix + "issued/" + name + "-server.crt", stagedServiceDir + "/server.crt", 0644)
+      .copy(prefix + "private/" + name + "-server.key", stagedServiceDir + "/server.key", 0600);
+  if (keySpec.usesDh())
+    installer.copy(prefix + "dh.pem", stagedServiceDir + "/dh.pem", 0644);
+
+  // 生成TLS密钥
+  std::string tlsKey;
+  if (!generateStaticKey(tlsKey))
+  {
+    std::cerr << "Failed to generate TLS key" << std::endl;
+    return false;
+  }
+  installer.write(tlsKey, stagedServiceDir + "/ta.key", 0600);
+
+  // 分片模式记录分组信息，createClient 据此生成多个 remote
+  if (shards > 1)
+  {
+    installer.write("shards " + std::to_string(shards) + "\nport " + std::to_string(port) + "\n",
+                    stagedServiceDir + "/shards", 0644);
+  }
+
+  // 3. 为每个实例生成配置文件，分片各自使用连续端口与不相交的子网段
+  int shardPrefixLength = prefixLength + shardBits;
+
+  // 各分片共用的模板取值只计算一次
+  std::ostringstream tuningStream;
+  serviceProfile.renderServer(tuningStream);
+  // 不使用 DCO 时显式关闭，避免 2.6 在条件满足时自动启用（旧版本不认识该指令）
+  if (!useDco && dcoStatus.supportsDcoOptions())
+  {
+    tuningStream << "disable-dco\n";
+  }
+  const std::string tuning = tuningStream.str();
+  const std::string marker = serviceProfile.marker();
+  const std::string keyExchange = keySpec.keyExchange(serviceDir + "/dh.pem");
+  const std::string netmask = IpAllocator::toString(IpAllocator::prefixToMask(shardPrefixLength));
+  const std::shared_ptr<const ConfigTemplate> serverTemplate = ConfigTemplate::server();
+  tmpl::SlotValues serverSlots{};
+  serverSlots[static_cast<size_t>(tmpl::Slot::Marker)] = marker;
+  serverSlots[static_cast<size_t>(tmpl::Slot::Proto)] = serviceProfile.proto;
+  serverSlots[static_cast<size_t>(tmpl::Slot::ServiceDir)] = serviceDir;
+  serverSlots[static_cast<size_t>(tmpl::Slot::Netmask)] = netmask;
+  serverSlots[static_cast<size_t>(tmpl::Slot::Pool)] = shards == 1 ? " nopool" : "";
+  serverSlots[static_cast<size_t>(tmpl::Slot::Crl)] = crlPath;
+  serverSlots[static_cast<size_t>(tmpl::Slot::KeyExchange)] = keyExchange;
+  std::string config;
+  std::vector<std::string> unitNames;
+  for (int k = 0; k < shards; ++k)
   {
+    const std::string unitName = shards > 1 ? name + "-" + std::to_string(k) : name;
+    const std::string runtimeDir = getServiceDir(unitName);
+    uint32_t shardNetwork = network + (static_cast<uint32_t>(k) << (32 - shardPrefixLength));
+
+    // 分片的运行目录单独发布，非分片服务与服务目录相同
+    const std::string stagedRuntimeDir = shards > 1 ? staging.stagedPath(unitName) : stagedServiceDir;
     try
     {
-      fs::create_directories(ccdDir);
+      fs::create_directories(stagedRuntimeDir + "/ccd");
     }
     catch (const fs::filesystem_error &e)
     {
-      std::cerr << "Failed to create directory " << ccdDir << ": " << e.what() << std::endl;
+      std::cerr << "Failed to create directory " << stagedRuntimeDir << "/ccd: " << e.what() << std::endl;
       return false;
     }
-  }
+    if (shards > 1)
+      staging.publish(unitName, runtimeDir);
 
-  // 定义带sudo拷贝函数
-  auto copyWithSudo = [](const std::string &src, const std::string &dest) -> bool
-  {
-    std::string cmd = "sudo cp " + src + " " + dest;
-    std::string output;
-    if (!execCommand(cmd, output))
+    // 单实例服务初始化静态地址位图，客户端地址由 createClient 通过 ccd 固定分配；
+    // 分片服务的客户端随机连接任一分片，使用各分片自己的动态地址池
+    if (shards == 1)
     {
-      std::cerr << "Failed to copy " << src << " to " << dest
-                << ": " << output << std::endl;
-      return false;
+      IpAllocator allocator(network, prefixLength);
+      if (!allocator.save(stagedRuntimeDir + "/ipp.bitmap"))
+        return false;
     }
 
-    // 设置正确的文件权限
-    cmd = "sudo chmod 644 " + dest;
-    return execCommand(cmd, output);
-  };
+    const std::string unitPort = std::to_string(port + k);
+    const std::string device = "tun" + unitPort;
+    const std::string shardAddress = IpAllocator::toString(shardNetwork);
+    serverSlots[static_cast<size_t>(tmpl::Slot::Port)] = unitPort;
+    serverSlots[static_cast<size_t>(tmpl::Slot::Dev)] = device;
+    serverSlots[static_cast<size_t>(tmpl::Slot::Network)] = shardAddress;
+    serverSlots[static_cast<size_t>(tmpl::Slot::RuntimeDir)] = runtimeDir;
+    serverTemplate->render(serverSlots, config);
+    installer.write(config, staging.stagedPath("conf/" + unitName), 0644);
+    unitNames.push_back(unitName);
+  }
 
-  // 证书文件拷贝（使用sudo）
-  std::string prefix = EASY_RSA_DIR + "/pki/";
-  if (!copyWithSudo(prefix + "ca.crt", OVPN_SERVER_CONF_DIR + "/" + name + "/ca.crt") ||
-      !copyWithSudo(prefix + "issued/" + name + "-server.crt", OVPN_SERVER_CONF_DIR + "/" + name + "/server.crt") ||
-      !copyWithSudo(prefix + "private/" + name + "-server.key", OVPN_SERVER_CONF_DIR + "/" + name + "/server.key") ||
-      !copyWithSudo(prefix + "dh.pem", OVPN_SERVER_CONF_DIR + "/" + name + "/dh.pem"))
+  std::string installError;
+  if (!installer.commit(installError))
   {
+    std::cerr << installError << std::endl;
     return false;
   }
 
-  // 生成TLS密钥（直接使用root权限）
-  cmd = "sudo " + OPENVPN_BIN + " --genkey secret " + OVPN_SERVER_CONF_DIR + "/" + name + "/ta.key";
-  if (!execCommand(cmd, output))
+  // 目录先于配置文件发布：配置文件出现即代表服务完整可用
+  staging.publish("service", serviceDir);
+  for (const auto &unitName : unitNames)
+    staging.publish("conf/" + unitName, getServiceConfigPath(unitName));
+  if (!staging.commit(installError))
+  {
+    std::cerr << installError << std::endl;
+    return false;
+  }
+
+  // 登记服务元数据
+  ServiceRecord record = {};
+  ServiceRegistry::setName(record, name);
+  strncpy(record.profile, serviceProfile.name.c_str(), sizeof(record.profile) - 1);
+  record.network = network;
+  record.port = static_cast<uint16_t>(port);
+  record.prefixLength = static_cast<uint8_t>(prefixLength);
+  record.shards = static_cast<uint8_t>(shards);
+  record.proto = serviceProfile.proto == "tcp" ? ServiceRecord::PROTO_TCP : ServiceRecord::PROTO_UDP;
+  record.dco = useDco;
+  record.dcoMode = static_cast<uint8_t>(options.dco);
+  record.keyAlgorithm = static_cast<uint8_t>(options.keyAlgorithm);
+  record.createdAt = time(nullptr);
+  if (!registry().put(record))
   {
-    std::cerr << "Failed to generate TLS key: " << output << std::endl;
-    return false;
-  }
-
-  // 3. 生成配置文件
-  std::ostringstream config;
-  config
-         << "topology subnet\n" 
-         << "port " << port << "\n"
-         << "proto udp\n"
-         << "dev tun\n"
-         << "ca " << OVPN_SERVER_CONF_DIR << "/" << name << "/ca.crt\n"
-         << "cert " << OVPN_SERVER_CONF_DIR << "/"<<  name << "/server.crt\n"
-         << "key " << OVPN_SERVER_CONF_DIR << "/"<<  name << "/server.key\n"
-         << "dh " << OVPN_SERVER_CONF_DIR << "/"<<  name << "/dh.pem\n"
-         << "tls-auth " << OVPN_SERVER_CONF_DIR << "/"<<  name << "/ta.key 0\n"
-         << "server " << subnet << " 255.255.255.0\n"
-         << "keepalive 10 120\n"
-         << "persist-key\n"
-         << "persist-tun\n"
-         << "ifconfig-pool-persist " << OVPN_SERVER_CONF_DIR << "/" << name << "/ipp.txt\n"
-         << "client-config-dir " << OVPN_SERVER_CONF_DIR << "/" << name << "/ccd\n"
-         << "status " << OVPN_SERVER_CONF_DIR << "/"<<  name << "/status.log\n"
-         << "verb 3\n";
-
-  std::ofstream confFile(OVPN_DIR + "/" + name + "-server.conf");
-  confFile << config.str();
-  confFile.close();
+    // 配置已安装，登记表的监视时间随之变化，下次查询时会从配置重新扫描出该服务
+    std::cerr << "Failed to register service " << name << ", the registry will be rebuilt from configs" << std::endl;
+  }
 
   // 4. 启动并启用服务
-  cmd = SYSTEMCTL_BIN + " start openvpn@" + name + "-server";
-  if (!execCommand(cmd, output))
+  for (const auto &unitName : unitNames)
+  {
+    cmd = SYSTEMCTL_BIN + " start openvpn@" + unitName + "-server";
+    if (!execCommand(cmd, output))
+      return false;
+
+    cmd = SYSTEMCTL_BIN + " enable openvpn@" + unitName + "-server";
+    if (!execCommand(cmd, output))
+      return false;
+  }
+  return true;
+}
+
+// 读取分片服务的分组信息，非分片服务返回 false
+bool OpenVPNManager::readShardGroup(const std::string &name, int &shards, int &basePort)
+{
+  std::ifstream groupFile(getServiceDir(name) + "/shards");
+  if (!groupFile.is_open())
     return false;
 
-  cmd = SYSTEMCTL_BIN + " enable openvpn@" + name + "-server";
-  return execCommand(cmd, output);
+  shards = 0;
+  basePort = 0;
+  std::string key;
+  int value;
+  while (groupFile >> key >> value)
+  {
+    if (key == "shards")
+      shards = value;
+    else if (key == "port")
+      basePort = value;
+  }
+  return shards > 1 && basePort > 0;
+}
+
+// 服务对应的 systemd 实例名（不含 openvpn@ 前缀与 -server 后缀）
+std::vector<std::string> OpenVPNManager::getServiceUnits(const std::string &name)
+{
+  ServiceRecord record;
+  if (!registry().find(name, record) || record.shards <= 1)
+    return {name};
+
+  std::vector<std::string> units;
+  for (int k = 0; k < record.shards; ++k)
+    units.push_back(name + "-" + std::to_string(k));
+  return units;
 }
 
-// 检查服务是否活跃
-bool OpenVPNManager::isServiceActive(const std::string &name)
+// 服务对应的全部 systemd 单元，以空格分隔，可直接作为 systemctl 参数
+std::string OpenVPNManager::getUnitList(const std::string &name)
+{
+  std::string units;
+  for (const auto &unit : getServiceUnits(name))
+  {
+    if (!units.empty())
+      units += " ";
+    units += "openvpn@" + unit + "-server";
+  }
+  return units;
+}
+
+// 统计处于活跃状态的单元数量
+int OpenVPNManager::countActiveUnits(const std::string &name)
+{
+  std::string cmd = SYSTEMCTL_BIN + " is-active " + getUnitList(name);
+  std::string output;
+  if (!execCommand(cmd, output))
+    return 0;
+
+  int active = 0;
+  std::istringstream iss(output);
+  std::string line;
+  while (std::getline(iss, line))
+  {
+    if (line == "active")
+      ++active;
+  }
+  return active;
+}
+
+// 检测 ovpn-dco 可用性
+DcoStatus OpenVPNManager::detectDco()
 {
-  std::string cmd = SYSTEMCTL_BIN + " is-active openvpn@" + name + "-server";
   std::string output;
-  return execCommand(cmd, output) && output.find("inactive") == std::string::npos;
+  execCommand(OPENVPN_BIN + " --version", output);
+  return DcoSupport::detect(output);
+}
+
+bool OpenVPNManager::configureKeyPool(KeyAlgorithm algorithm, const KeyPoolOptions &options)
+{
+  return KeyPool::instance().configure(algorithm, options);
+}
+
+bool OpenVPNManager::getKeyPoolStats(KeyAlgorithm algorithm, KeyPoolStats &stats)
+{
+  return KeyPool::instance().stats(algorithm, stats);
+}
+
+bool OpenVPNManager::fillKeyPool(KeyAlgorithm algorithm, int &generated)
+{
+  return KeyPool::instance().fill(algorithm, generated);
+}
+
+bool OpenVPNManager::drainKeyPool(KeyAlgorithm algorithm, int &destroyed)
+{
+  return KeyPool::instance().drain(algorithm, destroyed);
+}
+
+void OpenVPNManager::startKeyPoolWorker(int intervalSeconds)
+{
+  KeyPool::instance().start(intervalSeconds);
+}
+
+void OpenVPNManager::stopKeyPoolWorker()
+{
+  KeyPool::instance().stop();
+}
+
+// 服务的全部实例是否都运行在 DCO 接口上（依据配置中的 dev 指令定位接口）
+bool OpenVPNManager::isDcoActive(const std::string &name)
+{
+  for (const auto &unit : getServiceUnits(name))
+  {
+    std::shared_ptr<const OpenVPNConfig> config = OpenVPNConfig::load(getServiceConfigPath(unit));
+    if (!config || config->has("disable-dco") || !DcoSupport::isDeviceOffloaded(config->get("dev")))
+      return false;
+  }
+  return true;
+}
+
+// 检查服务是否活跃（分片服务要求全部分片活跃）
+bool OpenVPNManager::isServiceActive(const std::string &name)
+{
+  return countActiveUnits(name) == static_cast<int>(getServiceUnits(name).size());
 }
 
 // 检查服务是否启用
 bool OpenVPNManager::isServiceEnabled(const std::string &name)
 {
-  std::string cmd = SYSTEMCTL_BIN + " is-enabled openvpn@" + name + "-server";
+  std::string cmd = SYSTEMCTL_BIN + " is-enabled " + getUnitList(name);
   std::string output;
-  return execCommand(cmd, output) && output.find("enabled") != std::string::npos;
+  return execCommand(cmd, output) && output.find("enabled") != std::string::npos &&
+         output.find("disabled") == std::string::npos;
 }
 
 // 启动服务
 bool OpenVPNManager::startService(const std::string &name)
 {
-  std::string cmd = SYSTEMCTL_BIN + " start openvpn@" + name + "-server";
+  std::string cmd = SYSTEMCTL_BIN + " start " + getUnitList(name);
   std::string output;
   if (!execCommand(cmd, output))
   {
@@ -218,10 +840,30 @@ bool OpenVPNManager::startService(const std::string &name)
   return true;
 }
 
-// 停止服务
+// 各单元当前的主进程号（未运行的单元为 0），一次 systemctl 调用取得
+std::vector<pid_t> OpenVPNManager::getMainPids(const std::string &name)
+{
+  std::vector<pid_t> pids;
+  std::string cmd = SYSTEMCTL_BIN + " show -p MainPID --value " + getUnitList(name);
+  std::string output;
+  if (!execCommand(cmd, output))
+    return pids;
+
+  std::istringstream iss(output);
+  long pid;
+  while (iss >> pid)
+    pids.push_back(static_cast<pid_t>(pid));
+  return pids;
+}
+
+// 停止服务：先对各单元主进程打开 pidfd，再以 --no-block 下发停止任务，等待进程退出或超时
 bool OpenVPNManager::stopService(const std::string &name)
 {
-  std::string cmd = "sudo " + SYSTEMCTL_BIN + " stop openvpn@" + name + "-server";
+  ProcessWatch watch;
+  for (pid_t pid : getMainPids(name))
+    watch.add(pid);
+
+  std::string cmd = "sudo " + SYSTEMCTL_BIN + " stop --no-block " + getUnitList(name);
   std::string output;
   if (!execCommand(cmd, output))
   {
@@ -229,20 +871,18 @@ bool OpenVPNManager::stopService(const std::string &name)
     return false;
   }
 
-  // 确保服务已停止
-  int attempts = 0;
-  while (isServiceActive(name) && attempts++ < 5)
+  if (!watch.waitAll(STOP_TIMEOUT_MS))
   {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    std::cerr << "Timed out waiting for service " << name << " to stop" << std::endl;
+    return false;
   }
-
-  return !isServiceActive(name);
+  return true;
 }
 
 // 重启服务
 bool OpenVPNManager::restartService(const std::string &name)
 {
-  std::string cmd = SYSTEMCTL_BIN + " restart openvpn@" + name + "-server";
+  std::string cmd = SYSTEMCTL_BIN + " restart " + getUnitList(name);
   std::string output;
   if (!execCommand(cmd, output))
   {
@@ -252,101 +892,257 @@ bool OpenVPNManager::restartService(const std::string &name)
   return true;
 }
 
-// 删除服务
-bool OpenVPNManager::deleteService(const std::string &name)
+// 重载服务：SIGHUP 只发给各单元主进程，OpenVPN 重读配置而不退出
+bool OpenVPNManager::reloadService(const std::string &name)
 {
-  const std::string serverRootPath = OVPN_SERVER_CONF_DIR + "/" + name;
-  // 1. 停止服务
-  if (isServiceActive(name))
-  {
-    if (!stopService(name))
-    {
-      std::cerr << "Failed to stop service before deletion" << std::endl;
-      return false;
-    }
-  }
-
-  // 2. 禁用服务
-  std::string cmd = SYSTEMCTL_BIN + " disable openvpn@" + name + "-server";
+  std::string cmd = SYSTEMCTL_BIN + " kill --signal=SIGHUP --kill-who=main " + getUnitList(name);
   std::string output;
   if (!execCommand(cmd, output))
   {
-    std::cerr << "Failed to disable service: " << output << std::endl;
+    std::cerr << "Failed to reload service: " << output << std::endl;
     return false;
   }
+  return true;
+}
 
-  // 3. 删除配置文件
-  std::vector<std::string> filesToDelete = {
-    OVPN_DIR + "/" + name + "-server.conf",
-    serverRootPath + "/ca.crt",
-    serverRootPath + "/server.crt",
-    serverRootPath + "/server.key",
-    serverRootPath + "/dh.pem",
-    serverRootPath + "/ta.key",
-    serverRootPath + "/ipp.txt",
-    serverRootPath + "/status.log"};
+// 配置中的管理接口套接字路径，未开启或非 unix 套接字时返回空串
+std::string OpenVPNManager::getManagementSocket(const OpenVPNConfig &config)
+{
+  return config.get("management", 1) == "unix" ? config.get("management") : "";
+}
+
+// 按变更类型选择生效方式：吊销与 ccd 变更经管理接口只断开受影响的客户端，
+// 服务端指令变更发送 SIGHUP，仅监听参数变化时重启
+bool OpenVPNManager::applyServiceChange(const std::string &name, ServiceChange change, const std::string &commonName)
+{
+  switch (change)
+  {
+  case ServiceChange::Listen:
+    return restartService(name);
+  case ServiceChange::ServerOptions:
+    return reloadService(name);
+  case ServiceChange::Revocation:
+  case ServiceChange::ClientConfig:
+  case ServiceChange::Disconnect:
+    break;
+  }
+  if (commonName.empty())
+    return true;
+
+  std::vector<std::string> sockets;
+  bool legacy = false;
+  for (const auto &unit : getServiceUnits(name))
+  {
+    std::shared_ptr<const OpenVPNConfig> config = OpenVPNConfig::load(getServiceConfigPath(unit));
+    std::string socket = config ? getManagementSocket(*config) : "";
+    if (socket.empty() || (change == ServiceChange::Revocation && !config->has("crl-verify")))
+    {
+      legacy = true;
+      break;
+    }
+    sockets.push_back(socket);
+  }
+
+  // 早期创建的服务未开启管理接口或未校验 CRL：吊销只能重启生效，ccd 变更等待客户端重连
+  if (legacy)
+  {
+    if (change == ServiceChange::ClientConfig)
+      return true;
+    if (change == ServiceChange::Disconnect)
+    {
+      std::cerr << "Service " << name << " has no management interface, cannot disconnect " << commonName << std::endl;
+      return false;
+    }
+    std::cerr << "Service " << name << " has no management interface or crl-verify, restarting" << std::endl;
+    return restartService(name);
+  }
 
   bool success = true;
-  for (const auto &file : filesToDelete)
+  for (const auto &socket : sockets)
   {
-    if (fs::exists(file))
+    ManagementClient client;
+    if (!client.connect(socket))
     {
-      try
-      {
-        fs::remove(file);
-      }
-      catch (const fs::filesystem_error &e)
-      {
-        std::cerr << "Failed to delete file " << file << ": " << e.what() << std::endl;
-        success = false;
-      }
+      // 套接字不存在或拒绝连接说明实例未运行，没有需要断开的会话
+      if (errno == ENOENT || errno == ECONNREFUSED)
+        continue;
+      std::cerr << "Failed to connect management interface " << socket << std::endl;
+      success = false;
+      continue;
+    }
+    if (!client.killClient(commonName))
+    {
+      std::cerr << "Failed to disconnect client " << commonName << " via " << socket << std::endl;
+      success = false;
     }
   }
+  return success;
+}
 
-  // 删除目录及内所有文件 OVPN_SERVER_CONF_DIR + "/" + name以及子目录
-  try
+// 等待服务全部分片处于活跃状态
+bool OpenVPNManager::waitHealthy(const std::string &name, int timeoutMs)
+{
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (!isServiceActive(name))
   {
-    fs::remove_all(OVPN_SERVER_CONF_DIR + "/" + name);
+    if (std::chrono::steady_clock::now() >= deadline)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
   }
-  catch (const fs::filesystem_error &e)
+  return true;
+}
+
+// 批量操作：工作线程从共享下标领取服务，各服务的 systemctl 调用并发执行，
+// 总耗时接近最慢的单个服务；滚动模式限制并发为 maxUnavailable 并在每个服务恢复健康后继续，
+// 出现失败即停止领取新的服务
+std::vector<BulkResult> OpenVPNManager::bulkOperation(const std::string &pattern, BulkAction action,
+                                                      const BulkOptions &options)
+{
+  std::vector<BulkResult> results;
+  for (const auto &record : registry().list())
   {
-    std::cerr << "Failed to delete directory " << OVPN_SERVER_CONF_DIR + "/" + name << ": " << e.what() << std::endl;
-    success = false;
+    if (fnmatch(pattern.c_str(), record.name, 0) == 0)
+    {
+      BulkResult result;
+      result.name = record.name;
+      results.push_back(result);
+    }
   }
+  std::sort(results.begin(), results.end(),
+            [](const BulkResult &a, const BulkResult &b) { return a.name < b.name; });
+  if (results.empty())
+    return results;
+
+  const bool rolling = options.maxUnavailable > 0;
+  int workers = rolling ? options.maxUnavailable : options.concurrency;
+  workers = std::max(1, std::min(workers, static_cast<int>(results.size())));
+
+  std::atomic<size_t> next(0);
+  std::atomic<bool> halted(false);
+  auto worker = [&]()
+  {
+    for (size_t i = next++; i < results.size() && !halted; i = next++)
+    {
+      BulkResult &result = results[i];
+      bool ok = false;
+      switch (action)
+      {
+      case BulkAction::Start:
+        ok = startService(result.name);
+        break;
+      case BulkAction::Stop:
+        ok = stopService(result.name);
+        break;
+      case BulkAction::Restart:
+        ok = restartService(result.name);
+        break;
+      }
+      result.status = ok ? BulkStatus::Succeeded : BulkStatus::Failed;
+      if (ok && rolling && action != BulkAction::Stop && !waitHealthy(result.name, options.healthTimeoutMs))
+        result.status = BulkStatus::Unhealthy;
+      if (rolling && result.status != BulkStatus::Succeeded)
+        halted = true;
+    }
+  };
 
+  std::vector<std::thread> threads;
+  for (int i = 1; i < workers; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (auto &thread : threads)
+    thread.join();
+  return results;
+}
 
-  // 4. 从easy-rsa吊销服务器证书
-  cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa --batch revoke " + name + "-server";
-  if (!execCommand(cmd, output))
+// 删除服务
+bool OpenVPNManager::deleteService(const std::string &name)
+{
+  const std::vector<std::string> units = getServiceUnits(name);
+  // 1. 停止服务
+  if (countActiveUnits(name) > 0)
   {
-    std::cerr << "Failed to revoke server certificate: " << output << std::endl;
-    success = false;
+    if (!stopService(name))
+    {
+      std::cerr << "Failed to stop service before deletion" << std::endl;
+      return false;
+    }
   }
 
-  // 5. 生成新的CRL
-  cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa gen-crl";
+  // 2. 禁用服务
+  std::string cmd = SYSTEMCTL_BIN + " disable " + getUnitList(name);
+  std::string output;
   if (!execCommand(cmd, output))
   {
-    std::cerr << "Failed to generate new CRL: " << output << std::endl;
-    success = false;
+    std::cerr << "Failed to disable service: " << output << std::endl;
+    return false;
   }
 
-  // 6. 更新OpenVPN的CRL文件
-  if (fs::exists(EASY_RSA_DIR + "/pki/crl.pem"))
+  // 3. 删除各实例的配置文件与运行目录，最后删除服务目录（证书、密钥及分组信息）
+  std::vector<std::string> filesToDelete;
+  std::vector<std::string> dirsToDelete;
+  for (const auto &unit : units)
+  {
+    filesToDelete.push_back(getServiceConfigPath(unit));
+    dirsToDelete.push_back(getServiceDir(unit));
+  }
+  if (units.size() > 1)
+    dirsToDelete.push_back(getServiceDir(name));
+
+  bool success = true;
+  for (const auto &file : filesToDelete)
+  {
+    if (fs::exists(file))
+    {
+      try
+      {
+        fs::remove(file);
+      }
+      catch (const fs::filesystem_error &e)
+      {
+        std::cerr << "Failed to delete file " << file << ": " << e.what() << std::endl;
+        success = false;
+      }
+    }
+  }
+
+  // 删除目录及内所有文件以及子目录
+  for (const auto &dir : dirsToDelete)
   {
     try
     {
-      fs::copy(EASY_RSA_DIR + "/pki/crl.pem",
-               OVPN_DIR + "/crl.pem",
-               fs::copy_options::overwrite_existing);
+      fs::remove_all(dir);
     }
     catch (const fs::filesystem_error &e)
     {
-      std::cerr << "Failed to update CRL file: " << e.what() << std::endl;
+      std::cerr << "Failed to delete directory " << dir << ": " << e.what() << std::endl;
       success = false;
     }
   }
 
+
+  registry().remove(name);
+  {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    snapshotCache.erase(name);
+  }
+
+  // 4. 从easy-rsa吊销服务器证书（先记录序列号，revoke 会移走证书文件）
+  std::string serial;
+  time_t expiresAt = 0;
+  CrlManager::readCertificate(EASY_RSA_DIR + "/pki/issued/" + name + "-server.crt", serial, expiresAt);
+  cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa --batch revoke " + name + "-server";
+  int exitStatus = -1;
+  if (!execCommand(cmd, output, exitStatus))
+  {
+    std::cerr << "Failed to revoke server certificate (exit status " << exitStatus << "): " << output << std::endl;
+    success = false;
+    serial.clear();
+  }
+
+  // 5. 更新OpenVPN的CRL文件（吊销失败时 index.txt 仍标记为有效，只按其重新发布，不追加该序列号）
+  if (!updateCrl(serial, expiresAt))
+    success = false;
+
   return success;
 }
 
@@ -354,70 +1150,87 @@ bool OpenVPNManager::deleteService(const std::string &name)
 bool OpenVPNManager::createClient(const std::string &name, const std::string &serviceName, const std::string &wanip)
 {
 
-  // 读取指定服务的配置文件
-  std::string serviceConfigPath = getServiceConfigPath(serviceName);
-  if (!fs::exists(serviceConfigPath))
-  {
-    std::cerr << "Service config file not found: " << serviceConfigPath << std::endl;
-    return false;
-  }
-  std::ifstream configFile(serviceConfigPath);
-  if (!configFile.is_open())
+  // 端口、分片与档案取自服务登记表
+  ServiceRecord service;
+  if (!registry().find(serviceName, service))
   {
-    std::cerr << "Failed to open service config file: " << serviceConfigPath << std::endl;
+    std::cerr << "Service " << serviceName << " not found" << std::endl;
     return false;
   }
-  std::string configContent((std::istreambuf_iterator<char>(configFile)),
-                             std::istreambuf_iterator<char>());
-  configFile.close();
-
-  // 从配置文件里读取端口号
-  std::string portStr = configContent.substr(configContent.find("port ") + 5);
-  portStr = portStr.substr(0, portStr.find("\n"));
-  int port = std::stoi(portStr);
+  const std::vector<std::string> units = getServiceUnits(serviceName);
+  int port = service.port;
   std::cout << "Service port: " << port << std::endl;
 
-
-  std::string cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa --batch build-client-full " + name + " nopass";
-  std::string output;
-  if (!execCommand(cmd, output))
+  // 客户端证书与服务使用同一算法
+  // 私钥生成占签发的大部分时间：密钥池有可用密钥时只生成请求并签发，否则由 easy-rsa 完整生成
+  // 先分配固定地址：地址池已满时不签发证书，避免留下无法重新创建的证书与私钥
+  bool assigned = false;
+  if (!assignStaticAddress(name, serviceName, assigned))
     return false;
 
-  std::cout << "build-client-full done!" << std::endl;
-  std::cout << "Ready to build client configuration." << std::endl;
-  // 生成客户端配置文件
-  std::ostringstream config;
-  config << "client\n"
-         << "dev tun\n"
-         << "proto udp\n"
-         << "remote " << wanip << " " << port << "\n"
-         << "resolv-retry infinite\n"
-         << "nobind\n"
-         << "persist-key\n"
-         << "persist-tun\n"
-         << "remote-cert-tls server\n"
-         << "cipher AES-256-CBC\n"
-         << "verb 3\n";
-
-  // 添加证书内容
-  auto addSection = [&](const std::string &file, const std::string &tag)
-  {
-    // 打印日志
-    std::cout << "Adding section: " << tag << " from file: " << file << std::endl;
-    if (fs::exists(file))
+  const KeySpec &keySpec = KeySpec::of(static_cast<KeyAlgorithm>(service.keyAlgorithm));
+  if (issueFromKeyPool(name, keySpec.algorithm))
+  {
+    std::cout << "sign-req with pooled key done!" << std::endl;
+  }
+  else
+  {
+    std::string cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa --batch" + keySpec.easyrsaOptions() +
+                      "build-client-full " + name + " nopass";
+    std::string output;
+    if (!execCommand(cmd, output))
     {
-      config << "<" << tag << ">\n";
-      std::ifstream f(file);
-      config << f.rdbuf();
-      config << "</" << tag << ">\n";
+      // 只归还本次新分配的地址；同名客户端已存在时签发失败，其地址保持不变
+      if (assigned)
+        releaseStaticAddress(name, serviceName, false);
+      return false;
     }
-  };
 
-  addSection(EASY_RSA_DIR + "/pki/ca.crt", "ca");
-  addSection(EASY_RSA_DIR + "/pki/issued/" + name + ".crt", "cert");
-  addSection(EASY_RSA_DIR + "/pki/private/" + name + ".key", "key");
-  addSection(OVPN_SERVER_CONF_DIR + "/" + serviceName + "/ta.key", "tls-auth");
-  config << "key-direction 1\n";
+    std::cout << "build-client-full done!" << std::endl;
+  }
+
+  std::cout << "Ready to build client configuration." << std::endl;
+  // 生成客户端配置文件
+  const ConfigProfile *baseProfile = ConfigProfile::find(service.profile);
+  if (!baseProfile)
+    baseProfile = ConfigProfile::find(ConfigProfile::DEFAULT_NAME);
+  const ConfigProfile profile = service.dco ? baseProfile->forDco() : *baseProfile;
+  std::ostringstream tuning;
+  profile.renderClient(tuning);
+
+  // 分片服务列出全部分片地址，由客户端随机选择以分摊负载
+  std::string remotes;
+  for (size_t k = 0; k < units.size(); ++k)
+  {
+    remotes += "remote " + wanip + " " + std::to_string(port + k) + "\n";
+  }
+  if (units.size() > 1)
+  {
+    remotes += "remote-random\n";
+  }
+
+  // 添加证书内容：CA 与 tls-auth 密钥为服务共用，经缓存读取；客户端证书与私钥每次读取
+  std::shared_ptr<const std::string> ca = readCachedFile(EASY_RSA_DIR + "/pki/ca.crt");
+  std::shared_ptr<const std::string> tlsAuth = readCachedFile(getServiceDir(serviceName) + "/ta.key");
+  std::shared_ptr<const std::string> cert = readCachedFile(EASY_RSA_DIR + "/pki/issued/" + name + ".crt", false);
+  std::shared_ptr<const std::string> key = readCachedFile(EASY_RSA_DIR + "/pki/private/" + name + ".key", false);
+  if (!ca || !tlsAuth || !cert || !key)
+  {
+    std::cerr << "Missing certificate or key material for client " << name << std::endl;
+    return false;
+  }
+
+  const std::string tuningBlock = tuning.str();
+  tmpl::SlotValues slots{};
+  slots[static_cast<size_t>(tmpl::Slot::Proto)] = profile.proto;
+  slots[static_cast<size_t>(tmpl::Slot::Remotes)] = remotes;
+  slots[static_cast<size_t>(tmpl::Slot::Tuning)] = tuningBlock;
+  slots[static_cast<size_t>(tmpl::Slot::Ca)] = *ca;
+  slots[static_cast<size_t>(tmpl::Slot::Cert)] = *cert;
+  slots[static_cast<size_t>(tmpl::Slot::Key)] = *key;
+  slots[static_cast<size_t>(tmpl::Slot::TlsAuth)] = *tlsAuth;
+  std::string config;
+  ConfigTemplate::client()->render(slots, config);
 
   // 写入文件
   fs::path configPath = getClientConfigPath(name, serviceName);
@@ -425,7 +1238,7 @@ bool OpenVPNManager::createClient(const std::string &name, const std::string &se
   std::cout << "Writing client config to: " << configPath << std::endl;
   fs::create_directories(configPath.parent_path());
   std::ofstream out(configPath);
-  out << config.str();
+  out << config;
   std::cout << "Writing client config done!" << std::endl;
 
   return true;
@@ -433,47 +1246,34 @@ bool OpenVPNManager::createClient(const std::string &name, const std::string &se
 // 吊销客户端
 bool OpenVPNManager::revokeClient(const std::string &name, const std::string &serviceName)
 {
-  // 1. 吊销证书
+  // 1. 吊销证书（先记录序列号，revoke 会移走证书文件）
+  std::string serial;
+  time_t expiresAt = 0;
+  CrlManager::readCertificate(EASY_RSA_DIR + "/pki/issued/" + name + ".crt", serial, expiresAt);
   std::string cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa --batch revoke " + name;
   std::string output;
-  if (!execCommand(cmd, output))
+  int exitStatus = -1;
+  if (!execCommand(cmd, output, exitStatus))
   {
-    std::cerr << "Failed to revoke client certificate: " << output << std::endl;
+    std::cerr << "Failed to revoke client certificate (exit status " << exitStatus << "): " << output << std::endl;
     return false;
   }
 
-  // 2. 生成新的CRL
-  cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa gen-crl";
-  if (!execCommand(cmd, output))
-  {
-    std::cerr << "Failed to generate CRL: " << output << std::endl;
+  // 2~3. 更新OpenVPN的CRL文件（只在 easyrsa 已于 index.txt 标记吊销后追加，保持两者一致）
+  if (!updateCrl(serial, expiresAt))
     return false;
-  }
 
-  // 3. 更新OpenVPN的CRL文件
-  if (fs::exists(EASY_RSA_DIR + "/pki/crl.pem"))
+  // 4. 断开该客户端的现有会话，其他客户端不受影响（新的握手由 crl-verify 拒绝）
+  if (!applyServiceChange(serviceName, ServiceChange::Revocation, name))
   {
-    try
-    {
-      fs::copy(EASY_RSA_DIR + "/pki/crl.pem",
-               OVPN_DIR + "/crl.pem",
-               fs::copy_options::overwrite_existing);
-    }
-    catch (const fs::filesystem_error &e)
-    {
-      std::cerr << "Failed to update CRL file: " << e.what() << std::endl;
-      return false;
-    }
-  }
-
-  // 4. 重载OpenVPN服务
-  if (!restartService(serviceName))
-  {
-    std::cerr << "Failed to restart OpenVPN service" << std::endl;
+    std::cerr << "Failed to apply revocation to OpenVPN service" << std::endl;
     return false;
   }
 
-  // 5. 删除客户端文件
+  // 5. 释放固定地址
+  releaseStaticAddress(name, serviceName, true);
+
+  // 6. 删除客户端文件
   std::vector<std::string> filesToDelete = {
       EASY_RSA_DIR + "/pki/issued/" + name + ".crt",
       EASY_RSA_DIR + "/pki/private/" + name + ".key",
@@ -500,6 +1300,92 @@ bool OpenVPNManager::revokeClient(const std::string &name, const std::string &se
   return success;
 }
 
+// 以池中的密钥签发客户端证书：写入私钥，生成请求后经 easy-rsa 导入并签发
+// 池未启用、为空或客户端已有密钥材料时返回 false，由调用方回退到 build-client-full
+bool OpenVPNManager::issueFromKeyPool(const std::string &name, KeyAlgorithm algorithm)
+{
+  const std::string pki = EASY_RSA_DIR + "/pki";
+  const std::string keyPath = pki + "/private/" + name + ".key";
+  std::error_code ec;
+  if (fs::exists(keyPath, ec) || fs::exists(pki + "/reqs/" + name + ".req", ec) ||
+      fs::exists(pki + "/issued/" + name + ".crt", ec))
+    return false;
+
+  std::string keyPem;
+  if (!KeyPool::instance().take(algorithm, keyPem))
+    return false;
+  std::string request;
+  bool ok = KeyPool::buildRequest(keyPem, name, request);
+
+  int fd = ok ? open(keyPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600) : -1;
+  ok = fd >= 0 && write(fd, keyPem.data(), keyPem.size()) == static_cast<ssize_t>(keyPem.size()) && fsync(fd) == 0;
+  if (fd >= 0)
+    close(fd);
+  OPENSSL_cleanse(&keyPem[0], keyPem.size());
+
+  const std::string requestPath = pki + "/" + name + ".req.import";
+  if (ok)
+  {
+    std::ofstream out(requestPath, std::ios::trunc);
+    out << request;
+    ok = static_cast<bool>(out.flush());
+  }
+  // easy-rsa 出错时同样有输出，以退出码与签发出的证书判断是否成功
+  std::string output;
+  int exitStatus = -1;
+  const std::string certPath = pki + "/issued/" + name + ".crt";
+  ok = ok &&
+       execCommand("cd " + EASY_RSA_DIR + " && ./easyrsa --batch import-req " + requestPath + " " + name, output,
+                   exitStatus) &&
+       execCommand("cd " + EASY_RSA_DIR + " && ./easyrsa --batch sign-req client " + name, output, exitStatus) &&
+       fs::is_regular_file(certPath, ec) && fs::file_size(certPath, ec) > 0;
+  fs::remove(requestPath, ec);
+  if (!ok)
+  {
+    // 清除本次留下的文件，回退的 build-client-full 才不会因同名文件而失败
+    std::cerr << "Failed to issue client " << name << " from key pool (exit status " << exitStatus
+              << "), falling back" << std::endl;
+    fs::remove(keyPath, ec);
+    fs::remove(pki + "/reqs/" + name + ".req", ec);
+    fs::remove(certPath, ec);
+    KeyPool::instance().recordFailure(algorithm);
+  }
+  return ok;
+}
+
+// 更新CRL：优先原生增量签发，失败时回退到 easyrsa gen-crl 全量生成
+bool OpenVPNManager::updateCrl(const std::string &serial, time_t expiresAt)
+{
+  CrlManager &crl = CrlManager::instance();
+  if (serial.empty() ? crl.publish() : crl.revoke(serial, expiresAt))
+    return true;
+
+  std::cerr << "Native CRL update failed, falling back to easyrsa gen-crl" << std::endl;
+  std::string cmd = "cd " + EASY_RSA_DIR + " && ./easyrsa gen-crl";
+  std::string output;
+  if (!execCommand(cmd, output))
+  {
+    std::cerr << "Failed to generate CRL: " << output << std::endl;
+    return false;
+  }
+
+  if (fs::exists(EASY_RSA_DIR + "/pki/crl.pem"))
+  {
+    try
+    {
+      fs::copy(EASY_RSA_DIR + "/pki/crl.pem",
+               OVPN_DIR + "/crl.pem",
+               fs::copy_options::overwrite_existing);
+    }
+    catch (const fs::filesystem_error &e)
+    {
+      std::cerr << "Failed to update CRL file: " << e.what() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
 std::string OpenVPNManager::getOVPNFileContent(const std::string &name, const std::string &serviceName)
 {
 
@@ -521,115 +1407,415 @@ std::string OpenVPNManager::getOVPNFileContent(const std::string &name, const st
   return content;
 }
 
-// 获取在线客户端列表
-std::vector<VPNClient> OpenVPNManager::getOnlineClients(const std::string &serviceName)
+// 在线客户端快照（分片服务合并全部分片的 status.log）
+// OpenVPN 按 status 间隔（默认 60 秒）重写状态文件，SNAPSHOT_CHECK_MS 内的重复查询直接复用缓存，
+// 不做任何系统调用；超过后逐个 stat 状态文件，未变化时仍复用
+std::shared_ptr<const ClientSnapshot> OpenVPNManager::getClientSnapshot(const std::string &serviceName)
 {
-  std::vector<VPNClient> clients;
-  std::string statusFile = OVPN_SERVER_CONF_DIR + "/" + serviceName + "/status.log";
+  uint64_t version;
+  return getClientSnapshot(serviceName, version);
+}
 
-  // 检查文件是否存在
-  std::ifstream file(statusFile);
-  if (!file.is_open()) {
-      std::cerr << "[ERROR] Cannot open status file: " << statusFile << std::endl;
-      return clients;
+std::shared_ptr<const ClientSnapshot> OpenVPNManager::getClientSnapshot(const std::string &serviceName, uint64_t &version)
+{
+  const auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(snapshotMutex);
+  auto found = snapshotCache.find(serviceName);
+  if (found == snapshotCache.end())
+  {
+    // 只缓存登记表中存在的服务，任意名称的查询不会使缓存无限增长；未登记的名称每次现场读取
+    ServiceRecord record;
+    if (!registry().find(serviceName, record))
+    {
+      std::vector<std::string> statusFiles;
+      for (const auto &unit : getServiceUnits(serviceName))
+        statusFiles.push_back(getStatusFilePath(unit));
+      version = 0;
+      return ClientSnapshot::load(statusFiles);
+    }
+    found = snapshotCache.emplace(serviceName, CachedSnapshot()).first;
+  }
+  CachedSnapshot &entry = found->second;
+  if (entry.snapshot && now - entry.checkedAt < std::chrono::milliseconds(SNAPSHOT_CHECK_MS))
+  {
+    version = entry.version;
+    return entry.snapshot;
   }
 
-  std::string line;
-  bool inClientSection = false;
-  bool inRoutingSection = false;
-  std::map<std::string, VPNClient> clientMap;
-
-  // 调试：打印文件内容（可选）
-  // std::cout << "--- File Content ---\n";
-  // while (std::getline(file, line)) std::cout << line << "\n";
-  // file.clear();
-  // file.seekg(0);
-
-  while (std::getline(file, line)) {
-      // 移除行尾换行符
-      line.erase(std::remove_if(line.begin(), line.end(), 
-                 [](char c) { return c == '\r' || c == '\n'; }), 
-                 line.end());
-
-      if (line.empty()) continue;
-
-      // 检测区块
-      if (line.find("OpenVPN CLIENT LIST") != std::string::npos) {
-          inClientSection = true;
-          inRoutingSection = false;
-          continue;
-      } else if (line.find("ROUTING TABLE") != std::string::npos) {
-          inClientSection = false;
-          inRoutingSection = true;
-          continue;
-      } else if (line.find("GLOBAL STATS") != std::string::npos) {
-          break;  // 结束解析
+  // 服务可能被删除后以不同的分片数重建，状态文件列表随检查一并刷新
+  std::vector<std::string> statusFiles;
+  for (const auto &unit : getServiceUnits(serviceName))
+    statusFiles.push_back(getStatusFilePath(unit));
+  std::vector<std::pair<struct timespec, off_t>> stamps = statStatusFiles(statusFiles);
+  if (!entry.snapshot || statusFiles != entry.statusFiles || !sameStamps(stamps, entry.stamps))
+  {
+    entry.snapshot = ClientSnapshot::load(statusFiles);
+    entry.statusFiles = std::move(statusFiles);
+    entry.stamps = std::move(stamps);
+    entry.version = nextSnapshotVersion();
+    entry.history.emplace_back(entry.version, entry.snapshot);
+    if (entry.history.size() > SNAPSHOT_HISTORY)
+      entry.history.pop_front();
+  }
+  entry.checkedAt = now;
+  version = entry.version;
+  return entry.snapshot;
+}
+
+// 与历史中的快照比较得到变化，按名称哈希查找，O(n)
+ClientDelta OpenVPNManager::getClientDelta(const std::string &serviceName, uint64_t sinceVersion)
+{
+  ClientDelta delta;
+  delta.snapshot = getClientSnapshot(serviceName, delta.version);
+  if (sinceVersion != 0)
+  {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    auto found = snapshotCache.find(serviceName);
+    if (found != snapshotCache.end())
+    {
+      for (const auto &item : found->second.history)
+      {
+        if (item.first == sinceVersion)
+        {
+          delta.base = item.second;
+          break;
+        }
       }
+    }
+  }
+  delta.compute();
+  return delta;
+}
 
-      // 解析客户端列表
-      if (inClientSection) {
-          // 跳过表头（例如 "Common Name,Real Address,Bytes Received,Bytes Sent,Connected Since"）
-          if (line.find("Common Name") != std::string::npos) continue;
-
-          std::istringstream iss(line);
-          std::vector<std::string> tokens;
-          std::string token;
-
-          // 按逗号分割
-          while (std::getline(iss, token, ',')) {
-              tokens.push_back(token);
-          }
-
-          if (tokens.size() >= 5) {
-              VPNClient client;
-              client.name = tokens[0];
-              client.realIp = tokens[1];
-              try {
-                  client.bytesReceived = std::stoull(tokens[2]);
-                  client.bytesSent = std::stoull(tokens[3]);
-              } catch (...) {
-                  client.bytesReceived = 0;
-                  client.bytesSent = 0;
-              }
-              client.since = tokens[4];
-              clientMap[client.name] = client;
-          }
+// 发布端按服务保留，首次发布时创建共享内存段
+bool OpenVPNManager::publishClients(const std::string &serviceName, uint64_t &version)
+{
+  struct Published
+  {
+    SharedClientPublisher publisher;
+    uint64_t version = 0;
+  };
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::unique_ptr<Published>> publishers;
+
+  std::shared_ptr<const ClientSnapshot> snapshot = getClientSnapshot(serviceName, version);
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unique_ptr<Published> &entry = publishers[serviceName];
+  if (!entry)
+    entry.reset(new Published());
+  if (!entry->publisher.isOpen() && !entry->publisher.open(serviceName))
+    return false;
+  if (entry->version == version)
+    return true;
+  if (!entry->publisher.publish(*snapshot, version))
+    return false;
+  entry->version = version;
+  return true;
+}
+
+// 写入端与上次比较的快照按服务保留；会话结束时间取检测到变化的时间，字节数取最后一次看到的值
+bool OpenVPNManager::recordSessions(const std::string &serviceName, int &recorded)
+{
+  struct Recorder
+  {
+    std::unique_ptr<SessionLog> log;
+    std::shared_ptr<const ClientSnapshot> last;
+  };
+  static std::mutex mutex;
+  static std::unordered_map<std::string, Recorder> recorders;
+
+  recorded = 0;
+  uint64_t version;
+  std::shared_ptr<const ClientSnapshot> snapshot = getClientSnapshot(serviceName, version);
+  std::lock_guard<std::mutex> lock(mutex);
+  Recorder &recorder = recorders[serviceName];
+  if (!recorder.log)
+    recorder.log.reset(new SessionLog(getSessionLogPath(serviceName)));
+  if (!recorder.log->openForAppend())
+    return false;
+  if (!recorder.last || recorder.last == snapshot)
+  {
+    recorder.last = snapshot;
+    return true;
+  }
+
+  ClientDelta delta;
+  delta.base = recorder.last;
+  delta.snapshot = snapshot;
+  delta.compute();
+
+  const int64_t now = static_cast<int64_t>(time(nullptr));
+  std::vector<SessionRecord> ended;
+  auto addEnded = [&](const OnlineClient &client)
+  {
+    SessionRecord record = {};
+    SessionLog::setCommonName(record, ClientSnapshot::name(client));
+    record.realFamily = client.realFamily;
+    record.realPort = client.realPort;
+    record.vpnIpv4 = client.vpnIpv4;
+    memcpy(record.realAddr, client.realAddr, sizeof(record.realAddr));
+    record.start = client.connectedSince;
+    record.end = now;
+    record.bytesReceived = client.bytesReceived;
+    record.bytesSent = client.bytesSent;
+    ended.push_back(record);
+  };
+  for (uint32_t i : delta.removed)
+    addEnded((*delta.base)[i]);
+  // 连接时间变化或计数回退说明两次检查之间重新连接过
+  for (uint32_t i : delta.updated)
+  {
+    const OnlineClient &current = (*snapshot)[i];
+    const OnlineClient *previous = delta.base->find(ClientSnapshot::name(current));
+    if (previous && (previous->connectedSince != current.connectedSince ||
+                     current.bytesReceived < previous->bytesReceived || current.bytesSent < previous->bytesSent))
+      addEnded(*previous);
+  }
+  if (!recorder.log->append(ended))
+    return false;
+  recorder.last = snapshot;
+  recorded = static_cast<int>(ended.size());
+  return true;
+}
+
+bool OpenVPNManager::querySessions(const std::string &serviceName, const std::string &commonName, int64_t from,
+                                   int64_t to, size_t limit, std::vector<SessionRecord> &sessions)
+{
+  return SessionLog(getSessionLogPath(serviceName)).query(commonName, from, to, limit, sessions);
+}
+
+bool OpenVPNManager::aggregateSessions(const std::string &serviceName, const std::string &commonName, int64_t from,
+                                       int64_t to, SessionTotals &totals)
+{
+  return SessionLog(getSessionLogPath(serviceName)).aggregate(commonName, from, to, totals);
+}
+
+// 计数器按服务常驻内存，每次调用只在快照上评估一次；动作在释放锁前执行，避免同一客户端被重复处理
+bool OpenVPNManager::enforcePolicy(const std::string &serviceName, const UsagePolicy &policy,
+                                   std::vector<PolicyDecision> &decisions)
+{
+  struct Enforcer
+  {
+    std::unique_ptr<UsageTracker> tracker;
+    int64_t savedAt = 0;
+  };
+  static std::mutex mutex;
+  static std::unordered_map<std::string, Enforcer> enforcers;
+
+  decisions.clear();
+  std::shared_ptr<const ClientSnapshot> snapshot = getClientSnapshot(serviceName);
+  std::lock_guard<std::mutex> lock(mutex);
+  Enforcer &enforcer = enforcers[serviceName];
+  if (!enforcer.tracker)
+  {
+    enforcer.tracker.reset(new UsageTracker(getUsagePath(serviceName)));
+    enforcer.tracker->load();
+  }
+
+  const int64_t now = static_cast<int64_t>(time(nullptr));
+  enforcer.tracker->evaluate(*snapshot, policy, now, decisions);
+
+  // 未生效的动作撤销计数器上的标记，下次评估重新给出
+  bool success = true;
+  for (auto &decision : decisions)
+  {
+    switch (decision.action)
+    {
+    case PolicyAction::Disable:
+      if (!updateClientConfig(serviceName, decision.commonName, "disable", "disable"))
+      {
+        enforcer.tracker->unmark(decision.commonName, UsageCounter::DISABLED | UsageCounter::KICKED);
+        decision.applied = false;
+      }
+      else if (!applyServiceChange(serviceName, ServiceChange::Disconnect, decision.commonName))
+      {
+        enforcer.tracker->unmark(decision.commonName, UsageCounter::KICKED);
+        decision.applied = false;
       }
-      // 解析路由表
-      else if (inRoutingSection) {
-          // 跳过表头（例如 "Virtual Address,Common Name,Real Address,Last Ref"）
-          if (line.find("Virtual Address") != std::string::npos) continue;
-
-          std::istringstream iss(line);
-          std::vector<std::string> tokens;
-          std::string token;
-
-          while (std::getline(iss, token, ',')) {
-              tokens.push_back(token);
-          }
-
-          if (tokens.size() >= 2) {
-              std::string vpnIp = tokens[0];
-              std::string name = tokens[1];
-
-              if (clientMap.count(name)) {
-                  clientMap[name].vpnIp = vpnIp;
-              }
-          }
+      break;
+    case PolicyAction::Kick:
+      if (!applyServiceChange(serviceName, ServiceChange::Disconnect, decision.commonName))
+      {
+        enforcer.tracker->unmark(decision.commonName, UsageCounter::KICKED);
+        decision.applied = false;
+      }
+      break;
+    case PolicyAction::Enable:
+      decision.applied = updateClientConfig(serviceName, decision.commonName, "disable", "");
+      break;
+    }
+    success = decision.applied && success;
+  }
+
+  if (!decisions.empty() || now - enforcer.savedAt >= USAGE_SAVE_SECONDS)
+  {
+    if (!enforcer.tracker->save())
+      return false;
+    enforcer.savedAt = now;
+  }
+  return success;
+}
+
+bool OpenVPNManager::getClientUsage(const std::string &serviceName, const std::string &commonName, uint64_t &bytes)
+{
+  UsageTracker tracker(getUsagePath(serviceName));
+  return tracker.load() && tracker.usage(commonName, bytes);
+}
+
+bool OpenVPNManager::setServiceRate(const std::string &name, const RateLimit &limit)
+{
+  bool success = true;
+  for (const auto &unit : getServiceUnits(name))
+    success = replaceConfigLine(getServiceConfigPath(unit), TrafficShaper::MARKER, TrafficShaper::marker(limit)) && success;
+  return success;
+}
+
+bool OpenVPNManager::setClientRate(const std::string &serviceName, const std::string &commonName, const RateLimit &limit)
+{
+  return updateClientConfig(serviceName, commonName, TrafficShaper::MARKER, TrafficShaper::marker(limit));
+}
+
+// 限速取自服务端配置与 ccd 中的注释；有固定地址（ifconfig-push）的客户端按该地址限速，
+// 动态地址池中的客户端（分片服务）按当前在线地址限速，重新连接后须再次应用
+bool OpenVPNManager::buildShaping(const std::string &name, std::vector<std::pair<std::string, std::string>> &scripts)
+{
+  scripts.clear();
+  const std::vector<std::string> units = getServiceUnits(name);
+  std::shared_ptr<const ClientSnapshot> snapshot;
+  for (const auto &unit : units)
+  {
+    std::shared_ptr<const OpenVPNConfig> config = OpenVPNConfig::load(getServiceConfigPath(unit));
+    uint32_t network = 0;
+    uint32_t mask = 0;
+    if (!config || !IpAllocator::parseAddress(config->get("server", 0), network) ||
+        !IpAllocator::parseAddress(config->get("server", 1), mask))
+    {
+      std::cerr << "Failed to read subnet of " << unit << std::endl;
+      return false;
+    }
+    RateLimit serviceLimit;
+    for (const auto &comment : config->comments())
+      TrafficShaper::parseMarker(comment, serviceLimit);
+    serviceLimit.download /= units.size();
+    serviceLimit.upload /= units.size();
+
+    std::vector<ShapedClient> clients;
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(getServiceDir(unit) + "/ccd", ec))
+    {
+      std::shared_ptr<const OpenVPNConfig> ccd = entry.is_regular_file(ec) ? OpenVPNConfig::load(entry.path().string()) : nullptr;
+      if (!ccd)
+        continue;
+      ShapedClient client;
+      bool limited = false;
+      for (const auto &comment : ccd->comments())
+        limited = TrafficShaper::parseMarker(comment, client.limit) || limited;
+      if (!limited)
+        continue;
+      if (!IpAllocator::parseAddress(ccd->get("ifconfig-push"), client.vpnIpv4))
+      {
+        if (!snapshot)
+          snapshot = getClientSnapshot(name);
+        const OnlineClient *online = snapshot->find(entry.path().filename().string());
+        if (!online || online->vpnIpv4 == 0)
+          continue;
+        client.vpnIpv4 = online->vpnIpv4;
       }
+      clients.push_back(client);
+    }
+
+    std::string script;
+    TrafficShaper::buildBatch(config->get("dev"), network, maskToPrefix(mask), serviceLimit, std::move(clients), script);
+    scripts.emplace_back(config->get("dev"), std::move(script));
   }
+  return true;
+}
+
+// 每个设备一次 tc -force -batch：开头删除已有 qdisc 的行在首次应用时失败，忽略；其余行失败视为应用失败。
+// 脚本保存在实例目录的 shaping.tc 中，便于与离线生成的结果比对
+bool OpenVPNManager::applyShaping(const std::string &name)
+{
+  std::vector<std::pair<std::string, std::string>> scripts;
+  if (!buildShaping(name, scripts))
+    return false;
 
-  // 转换为 vector
-  for (const auto &pair : clientMap) {
-      clients.push_back(pair.second);
+  const std::vector<std::string> units = getServiceUnits(name);
+  bool success = true;
+  for (size_t k = 0; k < scripts.size(); ++k)
+  {
+    const std::string &device = scripts[k].first;
+    std::error_code ec;
+    if (device.empty() || !fs::exists("/sys/class/net/" + device, ec))
+      continue;
+
+    const std::string scriptPath = getServiceDir(units[k]) + "/shaping.tc";
+    std::ofstream file(scriptPath, std::ios::trunc);
+    file << scripts[k].second;
+    file.close();
+    std::string output;
+    if (!file || !execCommand(TC_BIN + " -force -batch " + scriptPath + " 2>&1", output))
+    {
+      std::cerr << "Failed to apply traffic shaping on " << device << std::endl;
+      success = false;
+      continue;
+    }
+    const std::string failed = "Command failed " + scriptPath + ":";
+    for (size_t pos = output.find(failed); pos != std::string::npos; pos = output.find(failed, pos + 1))
+    {
+      if (atoi(output.c_str() + pos + failed.size()) > TrafficShaper::RESET_LINES)
+      {
+        std::cerr << "Failed to apply traffic shaping on " << device << std::endl;
+        success = false;
+        break;
+      }
+    }
   }
+  return success;
+}
 
-  // 按连接时间排序
-  std::sort(clients.begin(), clients.end(),
-            [](const VPNClient &a, const VPNClient &b) {
-                return a.since < b.since;
-            });
+// 在服务的快照中按名称查找在线客户端
+const OnlineClient *OpenVPNManager::findOnlineClient(const std::string &serviceName, const std::string &name,
+                                                     std::shared_ptr<const ClientSnapshot> &snapshot)
+{
+  snapshot = getClientSnapshot(serviceName);
+  return snapshot->find(name);
+}
 
+// 在全部服务中查找在线客户端，返回所在服务
+const OnlineClient *OpenVPNManager::locateOnlineClient(const std::string &name, std::string &serviceName,
+                                                       std::shared_ptr<const ClientSnapshot> &snapshot)
+{
+  for (const auto &record : registry().list())
+  {
+    const OnlineClient *client = findOnlineClient(record.name, name, snapshot);
+    if (client)
+    {
+      serviceName = record.name;
+      return client;
+    }
+  }
+  snapshot.reset();
+  return nullptr;
+}
+
+// 获取在线客户端列表，按连接时间排序
+std::vector<VPNClient> OpenVPNManager::getOnlineClients(const std::string &serviceName)
+{
+  std::shared_ptr<const ClientSnapshot> snapshot = getClientSnapshot(serviceName);
+  std::vector<VPNClient> clients;
+  clients.reserve(snapshot->size());
+  for (const auto &record : snapshot->records())
+  {
+    VPNClient client;
+    client.name = std::string(snapshot->name(record));
+    client.vpnIp = record.vpnIpv4 ? IpAllocator::toString(record.vpnIpv4) : "";
+    client.realIp = ClientSnapshot::formatEndpoint(record);
+    client.since = std::string(ClientSnapshot::since(record));
+    client.connectedSince = record.connectedSince;
+    client.bytesReceived = record.bytesReceived;
+    client.bytesSent = record.bytesSent;
+    clients.push_back(std::move(client));
+  }
   return clients;
 }
 
@@ -658,6 +1844,179 @@ std::string OpenVPNManager::getClientConfigPath(const std::string &name, const s
   return OVPN_DIR + "/client-configs/" + serviceName + "/" + name + ".ovpn";
 }
 
+std::string OpenVPNManager::getStatusFilePath(const std::string &serviceName)
+{
+  return getServiceDir(serviceName) + "/status.log";
+}
+
+// 会话日志不放在服务目录中，删除服务后仍保留用于计费
+std::string OpenVPNManager::getSessionLogPath(const std::string &serviceName)
+{
+  return OVPN_DIR + "/ovpn-mana/sessions/" + serviceName + ".log";
+}
+
+std::string OpenVPNManager::getUsagePath(const std::string &serviceName)
+{
+  return OVPN_DIR + "/ovpn-mana/usage/" + serviceName + ".usage";
+}
+
+// 在服务各实例的 ccd/<client> 中替换以 key 开头的行
+bool OpenVPNManager::updateClientConfig(const std::string &serviceName, const std::string &commonName,
+                                        const std::string &key, const std::string &line)
+{
+  if (commonName.empty() || commonName.find('/') != std::string::npos || commonName.find("..") != std::string::npos)
+  {
+    std::cerr << "Invalid client name " << commonName << std::endl;
+    return false;
+  }
+
+  bool success = true;
+  for (const auto &unit : getServiceUnits(serviceName))
+    success = replaceConfigLine(getServiceDir(unit) + "/ccd/" + commonName, key, line) && success;
+  return success;
+}
+
+// 删除以 key 开头的行（key 之后须为行尾或空白），line 非空时追加到末尾，保留其他行；
+// 内容不变时不写入，结果为空时删除文件。新内容写入同目录的临时文件并 fsync 后 rename 替换，
+// 保留原文件的权限与属主，OpenVPN 在写入中途读取或进程崩溃时只会看到完整的旧文件或新文件
+bool OpenVPNManager::replaceConfigLine(const std::string &path, const std::string &key, const std::string &line)
+{
+  std::vector<std::string> lines;
+  bool changed = false;
+  bool kept = false;
+  std::ifstream existing(path);
+  std::string current;
+  while (std::getline(existing, current))
+  {
+    bool matches = current.rfind(key, 0) == 0 &&
+                   (current.size() == key.size() || key.back() == ' ' || isspace(static_cast<unsigned char>(current[key.size()])));
+    if (!matches)
+      lines.push_back(current);
+    else if (current == line && !kept)
+    {
+      lines.push_back(current);
+      kept = true;
+    }
+    else
+      changed = true;
+  }
+  existing.close();
+  if (!line.empty() && !kept)
+  {
+    lines.push_back(line);
+    changed = true;
+  }
+  if (!changed)
+    return true;
+
+  std::error_code ec;
+  if (lines.empty())
+  {
+    fs::remove(path, ec);
+    return true;
+  }
+  std::string content;
+  for (const auto &kept : lines)
+    content += kept + "\n";
+  FileInstaller installer;
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0)
+    installer.write(content, path, st.st_mode & 07777, st.st_uid, st.st_gid);
+  else
+    installer.write(content, path, 0644);
+  std::string error;
+  if (!installer.commit(error))
+  {
+    std::cerr << "Failed to update " << path << ": " << error << std::endl;
+    return false;
+  }
+  return true;
+}
+
+std::string OpenVPNManager::getServiceDir(const std::string &name)
+{
+  return OVPN_SERVER_CONF_DIR + "/" + name;
+}
+
+// 从位图中为客户端分配地址并写入 ccd/<client> 的 ifconfig-push 行，未启用位图的旧服务沿用动态地址池；
+// assigned 表示本次是否新分配了地址
+bool OpenVPNManager::assignStaticAddress(const std::string &name, const std::string &serviceName, bool &assigned)
+{
+  assigned = false;
+  std::string bitmapPath = getServiceDir(serviceName) + "/ipp.bitmap";
+  if (!fs::exists(bitmapPath))
+    return true;
+
+  BitmapLock lock(bitmapPath + ".lock");
+  IpAllocator allocator;
+  if (!allocator.load(bitmapPath))
+    return false;
+
+  // 已存在固定地址时保持不变
+  fs::path ccdPath = getServiceDir(serviceName) + "/ccd/" + name;
+  std::ifstream existing(ccdPath);
+  std::string directive, ip;
+  uint32_t addr = 0;
+  while (existing >> directive)
+  {
+    if (directive == "ifconfig-push" && existing >> ip && IpAllocator::parseAddress(ip, addr) &&
+        allocator.isAllocated(addr))
+      return true;
+  }
+
+  if (!allocator.allocate(addr))
+  {
+    std::cerr << "No free address left in service " << serviceName << std::endl;
+    return false;
+  }
+
+  existing.close();
+
+  // 只替换 ifconfig-push 行，保留 ccd 中的其他指令（disable、限速标记等）
+  const std::string line = "ifconfig-push " + IpAllocator::toString(addr) + " " +
+                           IpAllocator::toString(IpAllocator::prefixToMask(allocator.getPrefixLength()));
+  if (!replaceConfigLine(ccdPath.string(), "ifconfig-push", line) || !allocator.save(bitmapPath))
+  {
+    std::cerr << "Failed to assign static address for " << name << std::endl;
+    replaceConfigLine(ccdPath.string(), "ifconfig-push", "");
+    return false;
+  }
+  assigned = true;
+  std::cout << "Assigned static address " << IpAllocator::toString(addr) << " to " << name << std::endl;
+  return true;
+}
+
+// 释放客户端的固定地址；removeConfig 为 true 时删除整个 ccd/<client>（吊销），否则只删除 ifconfig-push 行
+bool OpenVPNManager::releaseStaticAddress(const std::string &name, const std::string &serviceName, bool removeConfig)
+{
+  std::string bitmapPath = getServiceDir(serviceName) + "/ipp.bitmap";
+  fs::path ccdPath = getServiceDir(serviceName) + "/ccd/" + name;
+  if (!fs::exists(bitmapPath) || !fs::exists(ccdPath))
+    return true;
+
+  BitmapLock lock(bitmapPath + ".lock");
+  IpAllocator allocator;
+  if (!allocator.load(bitmapPath))
+    return false;
+
+  std::ifstream ccd(ccdPath);
+  std::string directive, ip;
+  uint32_t addr = 0;
+  while (ccd >> directive)
+  {
+    if (directive == "ifconfig-push" && ccd >> ip && IpAllocator::parseAddress(ip, addr))
+      allocator.release(addr);
+  }
+  ccd.close();
+
+  std::error_code ec;
+  if (removeConfig)
+    fs::remove(ccdPath, ec);
+  else if (!replaceConfigLine(ccdPath.string(), "ifconfig-push", ""))
+    return false;
+  return allocator.save(bitmapPath);
+}
+
 std::string OpenVPNManager::getServiceConfigPath(const std::string &name)
 {
   return OVPN_DIR + "/" + name + "-server.conf";
@@ -0,0 +1,88 @@
+#include "ProcessWatch.hpp"
+#include <cerrno>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace
+{
+  int openPidfd(pid_t pid)
+  {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+  }
+
+  bool isAlive(pid_t pid)
+  {
+    return kill(pid, 0) == 0 || errno == EPERM;
+  }
+}
+
+ProcessWatch::~ProcessWatch()
+{
+  for (const auto &item : watched)
+  {
+    if (item.fd >= 0)
+      close(item.fd);
+  }
+}
+
+void ProcessWatch::add(pid_t pid)
+{
+  if (pid <= 0)
+    return;
+  int fd = openPidfd(pid);
+  if (fd < 0 && errno == ESRCH)
+    return;
+  watched.push_back(Watched{pid, fd});
+}
+
+bool ProcessWatch::waitAll(int timeoutMs)
+{
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+
+  std::vector<Watched> pending = watched;
+  while (!pending.empty())
+  {
+    std::vector<struct pollfd> fds;
+    bool fallback = false;
+    for (const auto &item : pending)
+    {
+      if (item.fd >= 0)
+        fds.push_back(pollfd{item.fd, POLLIN, 0});
+      else
+        fallback = true;
+    }
+
+    int remaining = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count());
+    if (remaining <= 0)
+      return false;
+    // 存在无 pidfd 的进程时以短间隔唤醒探测
+    int timeout = fallback ? std::min(remaining, 50) : remaining;
+    if (fds.empty())
+      std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+    else if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR)
+      return false;
+
+    std::vector<Watched> still;
+    size_t next = 0;
+    for (const auto &item : pending)
+    {
+      bool exited = item.fd >= 0 ? (fds[next++].revents & (POLLIN | POLLHUP)) != 0 : !isAlive(item.pid);
+      if (!exited)
+        still.push_back(item);
+    }
+    pending.swap(still);
+  }
+  return true;
+}
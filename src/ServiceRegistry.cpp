@@ -0,0 +1,306 @@
+#include "ServiceRegistry.hpp"
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <type_traits>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+static_assert(std::is_trivially_copyable<ServiceRecord>::value, "ServiceRecord must be trivially copyable");
+static_assert(sizeof(ServiceRecord) == 120, "ServiceRecord layout changed, bump the registry version");
+
+struct ServiceRegistry::Header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint32_t count;
+  uint32_t reserved;
+  int64_t watchSec; // 登记时被监视目录及其中配置文件的最新修改时间
+  int64_t watchNsec;
+};
+
+namespace
+{
+  const char MAGIC[8] = {'O', 'V', 'P', 'N', 'R', 'E', 'G', '\0'};
+  const uint32_t VERSION = 2;
+
+  // 登记文件的进程间写锁
+  class RegistryLock
+  {
+  public:
+    explicit RegistryLock(const std::string &path)
+        : fd(::open((path + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600))
+    {
+      if (fd >= 0)
+        flock(fd, LOCK_EX);
+    }
+    ~RegistryLock()
+    {
+      if (fd >= 0)
+        close(fd);
+    }
+
+  private:
+    int fd;
+  };
+}
+
+ServiceRegistry::ServiceRegistry(const std::string &path, const std::string &watchDir, const std::string &watchSuffix,
+                                 Scanner scanner)
+    : path(path), watchDir(watchDir), watchSuffix(watchSuffix), scanner(std::move(scanner))
+{
+}
+
+ServiceRegistry::~ServiceRegistry()
+{
+  unmapLocked();
+}
+
+void ServiceRegistry::setName(ServiceRecord &record, const std::string &name)
+{
+  memset(record.name, 0, sizeof(record.name));
+  memcpy(record.name, name.data(), std::min(name.size(), sizeof(record.name) - 1));
+}
+
+bool ServiceRegistry::open()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return ensureFreshLocked();
+}
+
+bool ServiceRegistry::find(const std::string &name, ServiceRecord &record)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!ensureFreshLocked())
+  {
+    // 登记文件不可写（如非 root 运行）时直接使用扫描结果
+    for (const auto &item : scanner())
+    {
+      if (strncmp(item.name, name.c_str(), sizeof(item.name)) == 0)
+      {
+        record = item;
+        return true;
+      }
+    }
+    return false;
+  }
+  const ServiceRecord *items = records();
+  for (uint32_t i = 0; i < count(); ++i)
+  {
+    if (strncmp(items[i].name, name.c_str(), sizeof(items[i].name)) == 0)
+    {
+      record = items[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<ServiceRecord> ServiceRegistry::list()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!ensureFreshLocked())
+    return scanner();
+  return std::vector<ServiceRecord>(records(), records() + count());
+}
+
+// 修改由本进程刚完成的目录变更引起，不重新扫描：以当前映射为基础修改后按最新目录时间登记
+bool ServiceRegistry::put(const ServiceRecord &record)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  RegistryLock fileLock(path);
+  std::vector<ServiceRecord> items = currentLocked();
+  bool replaced = false;
+  for (auto &item : items)
+  {
+    if (strncmp(item.name, record.name, sizeof(item.name)) == 0)
+    {
+      item = record;
+      replaced = true;
+    }
+  }
+  if (!replaced)
+    items.push_back(record);
+  struct timespec mtime;
+  readWatchMtime(mtime);
+  return writeLocked(items, mtime);
+}
+
+bool ServiceRegistry::remove(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  RegistryLock fileLock(path);
+  std::vector<ServiceRecord> items;
+  for (const auto &item : currentLocked())
+  {
+    if (strncmp(item.name, name.c_str(), sizeof(item.name)) != 0)
+      items.push_back(item);
+  }
+  struct timespec mtime;
+  readWatchMtime(mtime);
+  return writeLocked(items, mtime);
+}
+
+// 登记文件缺失或损坏时退回扫描
+std::vector<ServiceRecord> ServiceRegistry::currentLocked()
+{
+  if (mapLocked())
+    return std::vector<ServiceRecord>(records(), records() + count());
+  return scanner();
+}
+
+// 目录本身的修改时间反映文件的增删与改名，逐个 stat 后缀匹配的文件以发现原地编辑，取其中最新者
+bool ServiceRegistry::readWatchMtime(struct timespec &mtime) const
+{
+  struct stat st;
+  DIR *dir = stat(watchDir.c_str(), &st) == 0 ? opendir(watchDir.c_str()) : nullptr;
+  if (!dir)
+  {
+    mtime = {0, 0};
+    return false;
+  }
+  mtime = st.st_mtim;
+  auto newer = [](const struct timespec &a, const struct timespec &b)
+  { return a.tv_sec != b.tv_sec ? a.tv_sec > b.tv_sec : a.tv_nsec > b.tv_nsec; };
+  while (struct dirent *entry = readdir(dir))
+  {
+    const size_t length = strlen(entry->d_name);
+    if (length < watchSuffix.size() ||
+        watchSuffix.compare(0, std::string::npos, entry->d_name + length - watchSuffix.size()) != 0)
+      continue;
+    if (fstatat(dirfd(dir), entry->d_name, &st, 0) == 0 && newer(st.st_mtim, mtime))
+      mtime = st.st_mtim;
+  }
+  closedir(dir);
+  return true;
+}
+
+bool ServiceRegistry::ensureFreshLocked()
+{
+  struct timespec mtime;
+  readWatchMtime(mtime);
+  auto fresh = [&]()
+  {
+    const Header *header = static_cast<const Header *>(data);
+    return header && header->watchSec == mtime.tv_sec && header->watchNsec == mtime.tv_nsec;
+  };
+
+  // 其他进程可能已替换登记文件
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0 && st.st_ino != inode)
+    mapLocked();
+  if (fresh())
+    return true;
+
+  RegistryLock fileLock(path);
+  if (mapLocked() && fresh())
+    return true;
+  // 先取目录时间再扫描，扫描期间目录发生变化时下次查询会再次重建
+  return writeLocked(scanner(), mtime);
+}
+
+bool ServiceRegistry::mapLocked()
+{
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    unmapLocked();
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header))
+  {
+    close(fd);
+    unmapLocked();
+    return false;
+  }
+  if (data && st.st_ino == inode)
+  {
+    close(fd);
+    return true;
+  }
+
+  void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED)
+  {
+    unmapLocked();
+    return false;
+  }
+
+  const Header *header = static_cast<const Header *>(mapped);
+  if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+      header->recordSize != sizeof(ServiceRecord) ||
+      sizeof(Header) + static_cast<size_t>(header->count) * sizeof(ServiceRecord) > static_cast<size_t>(st.st_size))
+  {
+    munmap(mapped, st.st_size);
+    unmapLocked();
+    return false;
+  }
+
+  unmapLocked();
+  data = mapped;
+  size = st.st_size;
+  inode = st.st_ino;
+  return true;
+}
+
+void ServiceRegistry::unmapLocked()
+{
+  if (data)
+    munmap(data, size);
+  data = nullptr;
+  size = 0;
+  inode = 0;
+}
+
+// 写入临时文件后 rename 替换，已有的只读映射仍指向旧文件，随后重新映射
+bool ServiceRegistry::writeLocked(const std::vector<ServiceRecord> &items, const struct timespec &mtime)
+{
+  Header header = {};
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.recordSize = sizeof(ServiceRecord);
+  header.count = static_cast<uint32_t>(items.size());
+  header.watchSec = mtime.tv_sec;
+  header.watchNsec = mtime.tv_nsec;
+
+  std::error_code ec;
+  fs::create_directories(fs::path(path).parent_path(), ec);
+  std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+  int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    std::cerr << "Failed to write service registry " << path << std::endl;
+    return false;
+  }
+  size_t bytes = items.size() * sizeof(ServiceRecord);
+  bool ok = ::write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header)) &&
+            (bytes == 0 || ::write(fd, items.data(), bytes) == static_cast<ssize_t>(bytes));
+  close(fd);
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+  {
+    unlink(tmpPath.c_str());
+    std::cerr << "Failed to write service registry " << path << std::endl;
+    return false;
+  }
+  return mapLocked();
+}
+
+const ServiceRecord *ServiceRegistry::records() const
+{
+  return data ? reinterpret_cast<const ServiceRecord *>(static_cast<const char *>(data) + sizeof(Header)) : nullptr;
+}
+
+uint32_t ServiceRegistry::count() const
+{
+  return data ? static_cast<const Header *>(data)->count : 0;
+}
@@ -0,0 +1,449 @@
+#include "SessionLog.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+static_assert(std::is_trivially_copyable<SessionRecord>::value, "SessionRecord must be trivially copyable");
+static_assert(sizeof(SessionRecord) == 120, "SessionRecord layout changed, bump the session log version");
+
+namespace
+{
+  const char DATA_MAGIC[8] = {'O', 'V', 'P', 'N', 'S', 'E', 'S', '\0'};
+  const char INDEX_MAGIC[8] = {'O', 'V', 'P', 'N', 'S', 'I', 'X', '\0'};
+  const uint32_t VERSION = 1;
+  const size_t BLOOM_BYTES = 256; // 每块 256 个名称、3 个哈希时误判率约 3%
+
+  struct FileHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize; // 记录或索引项的大小
+    uint32_t blockRecords;
+    uint32_t reserved[3];
+  };
+
+  uint64_t hashName(std::string_view name)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : name)
+    {
+      hash ^= c;
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  // 双重哈希取 3 位
+  template <typename F>
+  void forEachBloomBit(std::string_view name, F f)
+  {
+    const uint64_t hash = hashName(name);
+    const uint32_t h1 = static_cast<uint32_t>(hash);
+    const uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+    for (uint32_t i = 0; i < 3; ++i)
+      f((h1 + i * h2) % (BLOOM_BYTES * 8));
+  }
+
+  std::string_view commonName(const SessionRecord &record)
+  {
+    return std::string_view(record.commonName, strnlen(record.commonName, sizeof(record.commonName)));
+  }
+
+  // 记录中保存的形式：与 setCommonName 一样截断，超长名称的查询才能匹配并命中布隆过滤器
+  std::string_view storedName(std::string_view name)
+  {
+    return name.substr(0, std::min(name.size(), sizeof(SessionRecord::commonName) - 1));
+  }
+
+  bool overlaps(const SessionRecord &record, int64_t from, int64_t to)
+  {
+    return record.start < to && record.end >= from;
+  }
+
+  bool writeAll(int fd, const void *data, size_t size)
+  {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0)
+    {
+      ssize_t n = ::write(fd, p, size);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return false;
+      p += n;
+      size -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  bool validHeader(const FileHeader &header, const char magic[8], uint32_t entrySize)
+  {
+    return memcmp(header.magic, magic, sizeof(header.magic)) == 0 && header.version == VERSION &&
+           header.entrySize == entrySize && header.blockRecords == SessionLog::BLOCK_RECORDS;
+  }
+
+  FileHeader makeHeader(const char magic[8], uint32_t entrySize)
+  {
+    FileHeader header = {};
+    memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = VERSION;
+    header.entrySize = entrySize;
+    header.blockRecords = SessionLog::BLOCK_RECORDS;
+    return header;
+  }
+}
+
+struct SessionLog::IndexEntry
+{
+  int64_t minStart;
+  int64_t maxStart;
+  int64_t minEnd;
+  int64_t maxEnd;
+  SessionTotals totals;
+  uint8_t bloom[BLOOM_BYTES];
+
+  void build(const SessionRecord *records, size_t n)
+  {
+    *this = IndexEntry{};
+    minStart = minEnd = INT64_MAX;
+    maxStart = maxEnd = INT64_MIN;
+    for (size_t i = 0; i < n; ++i)
+    {
+      const SessionRecord &record = records[i];
+      minStart = std::min(minStart, record.start);
+      maxStart = std::max(maxStart, record.start);
+      minEnd = std::min(minEnd, record.end);
+      maxEnd = std::max(maxEnd, record.end);
+      totals.add(record);
+      forEachBloomBit(commonName(record), [&](uint32_t bit)
+                      { bloom[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8)); });
+    }
+  }
+
+  bool mayContain(std::string_view name) const
+  {
+    bool found = true;
+    forEachBloomBit(name, [&](uint32_t bit)
+                    { found = found && (bloom[bit / 8] & (1u << (bit % 8))); });
+    return found;
+  }
+
+  bool mayOverlap(int64_t from, int64_t to) const { return minStart < to && maxEnd >= from; }
+  // 块内每个会话都与范围有交集
+  bool within(int64_t from, int64_t to) const { return maxStart < to && minEnd >= from; }
+};
+
+static_assert(std::is_trivially_copyable<SessionTotals>::value, "SessionTotals must be trivially copyable");
+
+void SessionTotals::add(const SessionRecord &record)
+{
+  ++sessions;
+  duration += record.end > record.start ? static_cast<uint64_t>(record.end - record.start) : 0;
+  bytesReceived += record.bytesReceived;
+  bytesSent += record.bytesSent;
+}
+
+void SessionTotals::add(const SessionTotals &other)
+{
+  sessions += other.sessions;
+  duration += other.duration;
+  bytesReceived += other.bytesReceived;
+  bytesSent += other.bytesSent;
+}
+
+// 数据与索引文件的只读映射，只使用完整的记录与完整块的索引项
+class SessionLog::MappedLog
+{
+public:
+  MappedLog(const std::string &path, const std::string &indexPath)
+  {
+    data = map(path, dataSize);
+    index = map(indexPath, indexSize);
+    if (data && dataSize >= sizeof(FileHeader))
+    {
+      const FileHeader *header = static_cast<const FileHeader *>(data);
+      valid = validHeader(*header, DATA_MAGIC, sizeof(SessionRecord));
+      count = (dataSize - sizeof(FileHeader)) / sizeof(SessionRecord);
+    }
+    else
+    {
+      // 日志尚不存在
+      valid = data == nullptr;
+    }
+    if (valid && index && indexSize >= sizeof(FileHeader) &&
+        validHeader(*static_cast<const FileHeader *>(index), INDEX_MAGIC, sizeof(IndexEntry)))
+    {
+      blocks = std::min<uint64_t>((indexSize - sizeof(FileHeader)) / sizeof(IndexEntry), count / BLOCK_RECORDS);
+    }
+  }
+
+  ~MappedLog()
+  {
+    if (data)
+      munmap(data, dataSize);
+    if (index)
+      munmap(index, indexSize);
+  }
+
+  MappedLog(const MappedLog &) = delete;
+  MappedLog &operator=(const MappedLog &) = delete;
+
+  const SessionRecord *records() const
+  {
+    return reinterpret_cast<const SessionRecord *>(static_cast<const char *>(data) + sizeof(FileHeader));
+  }
+  const IndexEntry *entries() const
+  {
+    return reinterpret_cast<const IndexEntry *>(static_cast<const char *>(index) + sizeof(FileHeader));
+  }
+
+  bool valid = false;
+  uint64_t count = 0;
+  uint64_t blocks = 0; // 有索引的块数，其后的记录逐条扫描
+
+private:
+  static void *map(const std::string &path, size_t &size)
+  {
+    size = 0;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return nullptr;
+    struct stat st;
+    void *mapped = nullptr;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (mapped == MAP_FAILED)
+        mapped = nullptr;
+      else
+        size = st.st_size;
+    }
+    close(fd);
+    return mapped;
+  }
+
+  void *data = nullptr;
+  size_t dataSize = 0;
+  void *index = nullptr;
+  size_t indexSize = 0;
+};
+
+SessionLog::SessionLog(const std::string &path) : path(path), indexPath(path + ".idx")
+{
+}
+
+SessionLog::~SessionLog()
+{
+  if (fd >= 0)
+    close(fd);
+  if (indexFd >= 0)
+    close(indexFd);
+}
+
+void SessionLog::setCommonName(SessionRecord &record, std::string_view name)
+{
+  memset(record.commonName, 0, sizeof(record.commonName));
+  memcpy(record.commonName, name.data(), std::min(name.size(), sizeof(record.commonName) - 1));
+}
+
+bool SessionLog::openForAppend()
+{
+  if (fd >= 0)
+    return true;
+  std::error_code ec;
+  fs::create_directories(fs::path(path).parent_path(), ec);
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    std::cerr << "Failed to open session log " << path << ": " << strerror(errno) << std::endl;
+    return false;
+  }
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+  {
+    std::cerr << "Session log " << path << " is being written by another process" << std::endl;
+    close(fd);
+    fd = -1;
+    return false;
+  }
+
+  struct stat st;
+  FileHeader header;
+  bool ok = fstat(fd, &st) == 0;
+  if (ok && st.st_size == 0)
+  {
+    header = makeHeader(DATA_MAGIC, sizeof(SessionRecord));
+    ok = writeAll(fd, &header, sizeof(header));
+    st.st_size = sizeof(header);
+  }
+  else if (ok)
+  {
+    ok = pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+         validHeader(header, DATA_MAGIC, sizeof(SessionRecord));
+  }
+  if (!ok)
+  {
+    std::cerr << "Session log " << path << " is corrupt" << std::endl;
+    close(fd);
+    fd = -1;
+    return false;
+  }
+
+  // 上次写入中途退出时截去不完整的尾部记录
+  count = (static_cast<uint64_t>(st.st_size) - sizeof(FileHeader)) / sizeof(SessionRecord);
+  const off_t end = static_cast<off_t>(sizeof(FileHeader) + count * sizeof(SessionRecord));
+  if (end != st.st_size && ftruncate(fd, end) != 0)
+  {
+    close(fd);
+    fd = -1;
+    return false;
+  }
+  lseek(fd, end, SEEK_SET);
+  if (!repairIndexLocked())
+  {
+    std::cerr << "Failed to rebuild session log index " << indexPath << std::endl;
+    close(fd);
+    fd = -1;
+    if (indexFd >= 0)
+      close(indexFd);
+    indexFd = -1;
+    return false;
+  }
+  return true;
+}
+
+// 索引项数应为完整块数；头部无效、尾部不完整或多于块数时重建，缺少的块补建
+bool SessionLog::repairIndexLocked()
+{
+  indexFd = ::open(indexPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (indexFd < 0)
+    return false;
+  struct stat st;
+  FileHeader header;
+  const uint64_t blocks = count / BLOCK_RECORDS;
+  bool reuse = fstat(indexFd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(FileHeader) &&
+               pread(indexFd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+               validHeader(header, INDEX_MAGIC, sizeof(IndexEntry)) &&
+               (st.st_size - sizeof(FileHeader)) % sizeof(IndexEntry) == 0 &&
+               (st.st_size - sizeof(FileHeader)) / sizeof(IndexEntry) <= blocks;
+  if (reuse)
+  {
+    indexed = (st.st_size - sizeof(FileHeader)) / sizeof(IndexEntry);
+  }
+  else
+  {
+    header = makeHeader(INDEX_MAGIC, sizeof(IndexEntry));
+    if (ftruncate(indexFd, 0) != 0 || pwrite(indexFd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+      return false;
+    indexed = 0;
+  }
+  while (indexed < blocks)
+  {
+    if (!appendIndexLocked(indexed))
+      return false;
+  }
+  return true;
+}
+
+bool SessionLog::appendIndexLocked(uint64_t block)
+{
+  std::vector<SessionRecord> records(BLOCK_RECORDS);
+  const size_t bytes = BLOCK_RECORDS * sizeof(SessionRecord);
+  const off_t offset = static_cast<off_t>(sizeof(FileHeader) + block * bytes);
+  if (pread(fd, records.data(), bytes, offset) != static_cast<ssize_t>(bytes))
+    return false;
+  IndexEntry entry;
+  entry.build(records.data(), records.size());
+  const off_t indexOffset = static_cast<off_t>(sizeof(FileHeader) + block * sizeof(IndexEntry));
+  if (pwrite(indexFd, &entry, sizeof(entry), indexOffset) != static_cast<ssize_t>(sizeof(entry)))
+    return false;
+  indexed = block + 1;
+  return true;
+}
+
+bool SessionLog::append(const std::vector<SessionRecord> &records)
+{
+  if (fd < 0)
+    return false;
+  if (records.empty())
+    return true;
+  if (!writeAll(fd, records.data(), records.size() * sizeof(SessionRecord)))
+  {
+    std::cerr << "Failed to append to session log " << path << ": " << strerror(errno) << std::endl;
+    return false;
+  }
+  count += records.size();
+  while (indexed < count / BLOCK_RECORDS)
+  {
+    if (!appendIndexLocked(indexed))
+      return false;
+  }
+  return true;
+}
+
+bool SessionLog::query(std::string_view name, int64_t from, int64_t to, size_t limit,
+                       std::vector<SessionRecord> &sessions) const
+{
+  sessions.clear();
+  name = storedName(name);
+  MappedLog log(path, indexPath);
+  if (!log.valid)
+    return false;
+
+  auto scan = [&](uint64_t begin, uint64_t end)
+  {
+    for (uint64_t i = begin; i < end && (limit == 0 || sessions.size() < limit); ++i)
+    {
+      const SessionRecord &record = log.records()[i];
+      if (overlaps(record, from, to) && (name.empty() || commonName(record) == name))
+        sessions.push_back(record);
+    }
+  };
+  for (uint64_t block = 0; block < log.blocks; ++block)
+  {
+    const IndexEntry &entry = log.entries()[block];
+    if (entry.mayOverlap(from, to) && (name.empty() || entry.mayContain(name)))
+      scan(block * BLOCK_RECORDS, (block + 1) * BLOCK_RECORDS);
+  }
+  scan(log.blocks * BLOCK_RECORDS, log.count);
+  return true;
+}
+
+bool SessionLog::aggregate(std::string_view name, int64_t from, int64_t to, SessionTotals &totals) const
+{
+  totals = SessionTotals();
+  name = storedName(name);
+  MappedLog log(path, indexPath);
+  if (!log.valid)
+    return false;
+
+  auto scan = [&](uint64_t begin, uint64_t end)
+  {
+    for (uint64_t i = begin; i < end; ++i)
+    {
+      const SessionRecord &record = log.records()[i];
+      if (overlaps(record, from, to) && (name.empty() || commonName(record) == name))
+        totals.add(record);
+    }
+  };
+  for (uint64_t block = 0; block < log.blocks; ++block)
+  {
+    const IndexEntry &entry = log.entries()[block];
+    if (!entry.mayOverlap(from, to) || (!name.empty() && !entry.mayContain(name)))
+      continue;
+    if (name.empty() && entry.within(from, to))
+      totals.add(entry.totals);
+    else
+      scan(block * BLOCK_RECORDS, (block + 1) * BLOCK_RECORDS);
+  }
+  scan(log.blocks * BLOCK_RECORDS, log.count);
+  return true;
+}
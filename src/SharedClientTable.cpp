@@ -0,0 +1,372 @@
+#include "SharedClientTable.hpp"
+#include "ClientSnapshot.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static_assert(std::is_trivially_copyable<SharedClientRecord>::value, "SharedClientRecord must be trivially copyable");
+static_assert(sizeof(SharedClientRecord) == 72, "SharedClientRecord layout changed, bump the segment version");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory sequence must be lock-free");
+
+namespace
+{
+  const char MAGIC[8] = {'O', 'V', 'P', 'N', 'S', 'H', 'M', '\0'};
+  const uint32_t VERSION = 1;
+  const size_t HEADER_SIZE = 4096;    // 段头独占一页，数据区从页边界开始
+  const size_t MIN_REGION = 64 * 1024;
+  const int READ_ATTEMPTS = 64;
+
+  struct SegmentHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    std::atomic<uint64_t> sequence; // 开始写入非活动区与切换活动区时各加一
+    std::atomic<uint32_t> active;   // 活动数据区 0/1
+    uint32_t reserved;
+    std::atomic<uint64_t> regionOffset[2];
+    std::atomic<uint64_t> regionCapacity[2]; // 0 表示尚未写入
+  };
+
+  struct RegionHeader
+  {
+    uint64_t version;
+    int64_t publishedAt;
+    uint32_t count;
+    uint32_t stringsSize;
+  };
+
+  static_assert(sizeof(SegmentHeader) <= HEADER_SIZE, "segment header must fit in its page");
+
+  size_t alignUp(size_t value, size_t alignment)
+  {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  // 读端在 s1 时读取活动区，该区最早在 s1 之后的第一次切换后才会被再次写入：
+  // s1 为偶数时写入始于 s1 + 3，为奇数时始于 s1 + 2
+  bool stillConsistent(uint64_t before, uint64_t after)
+  {
+    return after <= (before | 1) + 1;
+  }
+}
+
+std::string SharedClientPublisher::segmentName(const std::string &serviceName)
+{
+  if (serviceName.empty() || serviceName.size() > 200 || serviceName.find('/') != std::string::npos)
+    return "";
+  return "/ovpn-mana." + serviceName;
+}
+
+SharedClientPublisher::~SharedClientPublisher()
+{
+  close();
+}
+
+bool SharedClientPublisher::open(const std::string &serviceName)
+{
+  close();
+  const std::string name = segmentName(serviceName);
+  if (name.empty())
+    return false;
+  fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    std::cerr << "Failed to open shared memory " << name << ": " << strerror(errno) << std::endl;
+    return false;
+  }
+  // /dev/shm 对所有用户可写，其他用户预先创建的同名段不能接管，否则对方可以改写读端看到的客户端表
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_uid != geteuid())
+  {
+    std::cerr << "Shared memory " << name << " is owned by another user" << std::endl;
+    close();
+    return false;
+  }
+  // 非特权的读进程需要读权限，不受 umask 影响
+  fchmod(fd, 0644);
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+  {
+    std::cerr << "Online clients of " << serviceName << " are already published by another process" << std::endl;
+    close();
+    return false;
+  }
+  segment = name;
+
+  if (fstat(fd, &st) != 0 || (static_cast<size_t>(st.st_size) < HEADER_SIZE && ftruncate(fd, HEADER_SIZE) != 0))
+  {
+    close();
+    return false;
+  }
+  size = std::max(static_cast<size_t>(st.st_size), HEADER_SIZE);
+  data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED)
+  {
+    data = nullptr;
+    close();
+    return false;
+  }
+
+  SegmentHeader *header = static_cast<SegmentHeader *>(data);
+  if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 && header->version == VERSION &&
+      header->recordSize == sizeof(SharedClientRecord))
+  {
+    // 接管上一个发布进程的段；其在写入中途退出时活动区仍然完整，只需让序号回到偶数
+    uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+    if (sequence & 1)
+      header->sequence.store(sequence + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 新段或版本不符：数据区清空后最后写入 magic，读端在此之前不会接受该段
+  memset(header->magic, 0, sizeof(header->magic));
+  std::atomic_thread_fence(std::memory_order_release);
+  header->version = VERSION;
+  header->recordSize = sizeof(SharedClientRecord);
+  header->sequence.store(0, std::memory_order_relaxed);
+  header->active.store(0, std::memory_order_relaxed);
+  for (int i = 0; i < 2; ++i)
+  {
+    header->regionOffset[i].store(0, std::memory_order_relaxed);
+    header->regionCapacity[i].store(0, std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(header->magic, MAGIC, sizeof(MAGIC));
+  return true;
+}
+
+// 正常退出时删除段名，之后的读端回退到读取状态文件；持有锁时删除，不会删掉其他发布进程的段。
+// 已打开的读端仍映射着旧段，由 publisherAlive 发现发布进程已退出
+void SharedClientPublisher::close()
+{
+  if (!segment.empty())
+    shm_unlink(segment.c_str());
+  segment.clear();
+  if (data)
+    munmap(data, size);
+  data = nullptr;
+  size = 0;
+  if (fd >= 0)
+    ::close(fd);
+  fd = -1;
+}
+
+// 段只增长：已有的读端映射仍然有效，发布端重新映射
+bool SharedClientPublisher::growLocked(size_t required)
+{
+  if (required <= size)
+    return true;
+  if (ftruncate(fd, static_cast<off_t>(required)) != 0)
+  {
+    std::cerr << "Failed to grow shared client table: " << strerror(errno) << std::endl;
+    return false;
+  }
+  void *mapped = mremap(data, size, required, MREMAP_MAYMOVE);
+  if (mapped == MAP_FAILED)
+    return false;
+  data = mapped;
+  size = required;
+  return true;
+}
+
+bool SharedClientPublisher::publish(const ClientSnapshot &snapshot, uint64_t version)
+{
+  if (!data)
+    return false;
+
+  size_t stringsSize = 0;
+  for (const OnlineClient &client : snapshot.records())
+    stringsSize += client.nameLength + 1;
+  const size_t required = sizeof(RegionHeader) + snapshot.size() * sizeof(SharedClientRecord) + stringsSize;
+
+  SegmentHeader *header = static_cast<SegmentHeader *>(data);
+  const uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+  const uint32_t target = 1 - header->active.load(std::memory_order_relaxed);
+  header->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  // 非活动区不够时在段尾另开一块，旧位置废弃
+  if (header->regionCapacity[target].load(std::memory_order_relaxed) < required)
+  {
+    const size_t offset = alignUp(size, 4096);
+    const size_t capacity = alignUp(std::max(required * 2, MIN_REGION), 4096);
+    if (!growLocked(offset + capacity))
+    {
+      header = static_cast<SegmentHeader *>(data);
+      header->sequence.store(sequence + 2, std::memory_order_release);
+      return false;
+    }
+    header = static_cast<SegmentHeader *>(data);
+    header->regionOffset[target].store(offset, std::memory_order_relaxed);
+    header->regionCapacity[target].store(capacity, std::memory_order_relaxed);
+  }
+
+  char *region = static_cast<char *>(data) + header->regionOffset[target].load(std::memory_order_relaxed);
+  RegionHeader *regionHeader = reinterpret_cast<RegionHeader *>(region);
+  SharedClientRecord *records = reinterpret_cast<SharedClientRecord *>(region + sizeof(RegionHeader));
+  char *strings = region + sizeof(RegionHeader) + snapshot.size() * sizeof(SharedClientRecord);
+  uint32_t stringOffset = 0;
+  for (size_t i = 0; i < snapshot.size(); ++i)
+  {
+    const OnlineClient &client = snapshot[i];
+    SharedClientRecord &record = records[i];
+    record.nameOffset = stringOffset;
+    record.nameLength = static_cast<uint16_t>(std::min<uint32_t>(client.nameLength, UINT16_MAX));
+    record.realFamily = client.realFamily;
+    record.hasVpnIpv6 = client.hasVpnIpv6;
+    record.realPort = client.realPort;
+    record.reserved = 0;
+    record.vpnIpv4 = client.vpnIpv4;
+    memcpy(record.realAddr, client.realAddr, sizeof(record.realAddr));
+    memcpy(record.vpnIpv6, client.vpnIpv6, sizeof(record.vpnIpv6));
+    record.connectedSince = client.connectedSince;
+    record.bytesReceived = client.bytesReceived;
+    record.bytesSent = client.bytesSent;
+    memcpy(strings + stringOffset, client.name, record.nameLength);
+    stringOffset += record.nameLength;
+    strings[stringOffset++] = '\0';
+  }
+  regionHeader->version = version;
+  regionHeader->publishedAt = static_cast<int64_t>(time(nullptr));
+  regionHeader->count = static_cast<uint32_t>(snapshot.size());
+  regionHeader->stringsSize = stringOffset;
+
+  header->active.store(target, std::memory_order_release);
+  header->sequence.store(sequence + 2, std::memory_order_release);
+  return true;
+}
+
+SharedClientReader::~SharedClientReader()
+{
+  close();
+}
+
+bool SharedClientReader::open(const std::string &serviceName)
+{
+  close();
+  const std::string name = SharedClientPublisher::segmentName(serviceName);
+  if (name.empty())
+    return false;
+  fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0)
+    return false;
+  if (!remap())
+  {
+    close();
+    return false;
+  }
+  const SegmentHeader *header = static_cast<const SegmentHeader *>(data);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+      header->recordSize != sizeof(SharedClientRecord) || !publisherAlive())
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+// 发布进程在段的整个生命周期内持有排他锁，能取得共享锁说明它已退出（异常退出时段名仍在），表已过期
+bool SharedClientReader::publisherAlive() const
+{
+  if (fd < 0)
+    return false;
+  if (flock(fd, LOCK_SH | LOCK_NB) != 0)
+    return errno == EWOULDBLOCK;
+  flock(fd, LOCK_UN);
+  return false;
+}
+
+void SharedClientReader::close()
+{
+  if (data)
+    munmap(const_cast<void *>(data), size);
+  data = nullptr;
+  size = 0;
+  if (fd >= 0)
+    ::close(fd);
+  fd = -1;
+}
+
+// 发布端扩展了段，按当前大小重新映射
+bool SharedClientReader::remap()
+{
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_SIZE)
+    return false;
+  void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED)
+    return false;
+  if (data)
+    munmap(const_cast<void *>(data), size);
+  data = mapped;
+  size = st.st_size;
+  return true;
+}
+
+bool SharedClientReader::visit(Visitor visitor, void *context)
+{
+  if (!data)
+    return false;
+  for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt)
+  {
+    const SegmentHeader *header = static_cast<const SegmentHeader *>(data);
+    const uint64_t before = header->sequence.load(std::memory_order_acquire);
+    const uint32_t active = header->active.load(std::memory_order_acquire) & 1;
+    const uint64_t offset = header->regionOffset[active].load(std::memory_order_relaxed);
+    const uint64_t capacity = header->regionCapacity[active].load(std::memory_order_relaxed);
+    if (capacity == 0)
+    {
+      // 尚未发布
+      if (stillConsistent(before, header->sequence.load(std::memory_order_acquire)))
+        return false;
+      continue;
+    }
+    if (offset + capacity > size)
+    {
+      if (!remap())
+        return false;
+      continue;
+    }
+
+    const char *region = static_cast<const char *>(data) + offset;
+    RegionHeader regionHeader;
+    memcpy(&regionHeader, region, sizeof(regionHeader));
+    const size_t recordsSize = static_cast<size_t>(regionHeader.count) * sizeof(SharedClientRecord);
+    if (sizeof(RegionHeader) + recordsSize + regionHeader.stringsSize <= capacity)
+    {
+      visitor(context, regionHeader.version, regionHeader.publishedAt,
+              reinterpret_cast<const SharedClientRecord *>(region + sizeof(RegionHeader)), regionHeader.count,
+              region + sizeof(RegionHeader) + recordsSize, regionHeader.stringsSize);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (stillConsistent(before, header->sequence.load(std::memory_order_relaxed)) &&
+        sizeof(RegionHeader) + recordsSize + regionHeader.stringsSize <= capacity)
+      return true;
+  }
+  return false;
+}
+
+bool SharedClientReader::read(View &view)
+{
+  return visit(
+      [](void *context, uint64_t version, int64_t publishedAt, const SharedClientRecord *records, uint32_t count,
+         const char *strings, uint32_t stringsSize)
+      {
+        View &out = *static_cast<View *>(context);
+        out.version = version;
+        out.publishedAt = publishedAt;
+        out.records.assign(records, records + count);
+        out.strings.assign(strings, stringsSize);
+      },
+      &view);
+}
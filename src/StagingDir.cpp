@@ -0,0 +1,122 @@
+#include "StagingDir.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  // 不覆盖已存在目标的原子重命名；文件系统不支持该标志时先检查再 rename
+  bool renameNoReplace(const std::string &from, const std::string &to)
+  {
+    if (renameat2(AT_FDCWD, from.c_str(), AT_FDCWD, to.c_str(), RENAME_NOREPLACE) == 0)
+      return true;
+    if (errno != EINVAL && errno != ENOSYS)
+      return false;
+    std::error_code ec;
+    if (fs::exists(to, ec))
+    {
+      errno = EEXIST;
+      return false;
+    }
+    return rename(from.c_str(), to.c_str()) == 0;
+  }
+
+  void syncDir(const std::string &dir)
+  {
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+      fsync(fd);
+      close(fd);
+    }
+  }
+}
+
+StagingDir::StagingDir(const std::string &parent, const std::string &tag)
+{
+  std::error_code ec;
+  fs::create_directories(parent, ec);
+  std::string tmpl = parent + "/.staging-" + tag + "-XXXXXX";
+  if (mkdtemp(&tmpl[0]) != nullptr)
+    root = tmpl;
+}
+
+StagingDir::~StagingDir()
+{
+  rollback();
+}
+
+std::string StagingDir::stagedPath(const std::string &relative) const
+{
+  return root + "/" + relative;
+}
+
+void StagingDir::publish(const std::string &relative, const std::string &dest)
+{
+  publications.push_back(Publication{stagedPath(relative), dest});
+}
+
+bool StagingDir::commit(std::string &error)
+{
+  if (!valid())
+  {
+    error = "Staging directory is not available";
+    return false;
+  }
+
+  // 暂存区内全部文件与目录一次性落盘
+  int fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0 || syncfs(fd) != 0)
+  {
+    error = "Failed to sync staging directory " + root + ": " + strerror(errno);
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
+  close(fd);
+
+  size_t published = 0;
+  for (; published < publications.size(); ++published)
+  {
+    const Publication &item = publications[published];
+    if (!renameNoReplace(item.staged, item.dest))
+    {
+      error = "Failed to publish " + item.dest + ": " + strerror(errno);
+      break;
+    }
+  }
+
+  if (published < publications.size())
+  {
+    // 逆序撤回已发布的条目，随后由 rollback 清理暂存区
+    while (published-- > 0)
+      rename(publications[published].dest.c_str(), publications[published].staged.c_str());
+    return false;
+  }
+
+  std::set<std::string> parents;
+  for (const auto &item : publications)
+    parents.insert(fs::path(item.dest).parent_path().string());
+  for (const auto &dir : parents)
+    syncDir(dir);
+
+  publications.clear();
+  rollback();
+  return true;
+}
+
+void StagingDir::rollback()
+{
+  if (root.empty())
+    return;
+  std::error_code ec;
+  fs::remove_all(root, ec);
+  root.clear();
+  publications.clear();
+}
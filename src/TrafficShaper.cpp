@@ -0,0 +1,153 @@
+#include "TrafficShaper.hpp"
+#include "IpAllocator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+const std::string TrafficShaper::MARKER = "# ovpn-mana rate ";
+
+namespace
+{
+  const uint32_t ROOT_CLASS = 0x1;
+  const uint32_t DEFAULT_CLASS = 0xffff;
+  const uint64_t MIN_BURST = 16000;   // 字节
+  const char *QUANTUM = " quantum 1600"; // 不随速率放大，避免 HTB 以 rate/r2q 得到过大的量子
+
+  std::string hex(uint32_t value)
+  {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%x", value);
+    return buffer;
+  }
+
+  std::string rate(uint64_t bps)
+  {
+    return std::to_string(bps) + "bit";
+  }
+
+  // 约 100ms 的流量，至少容纳若干个整包
+  std::string burst(uint64_t bps)
+  {
+    return std::to_string(std::max<uint64_t>(bps / 8 / 10, MIN_BURST));
+  }
+
+  // 以地址末字节为键的 u32 哈希过滤器：ht 800 中匹配整个子网并跳转到 256 个桶的哈希表
+  void addHashTable(std::string &script, const std::string &prefix, uint32_t table, uint32_t network,
+                    int prefixLength, int offset)
+  {
+    script += prefix + " prio 1 handle " + hex(table) + ": protocol ip u32 divisor 256\n";
+    script += prefix + " prio 1 protocol ip u32 ht 800:: match ip " + (offset == 16 ? "dst " : "src ") +
+              IpAllocator::toString(network) + "/" + std::to_string(prefixLength) +
+              " hashkey mask 0x000000ff at " + std::to_string(offset) + " link " + hex(table) + ":\n";
+  }
+}
+
+void TrafficShaper::buildBatch(const std::string &device, uint32_t network, int prefixLength,
+                               const RateLimit &serviceLimit, std::vector<ShapedClient> clients, std::string &script)
+{
+  script.clear();
+  script += "qdisc del dev " + device + " root\n";
+  script += "qdisc del dev " + device + " ingress\n";
+
+  // 只保留子网内、类号可用的客户端，按地址排序使输出稳定
+  const uint32_t mask = IpAllocator::prefixToMask(prefixLength);
+  network &= mask;
+  clients.erase(std::remove_if(clients.begin(), clients.end(),
+                               [&](const ShapedClient &client)
+                               {
+                                 uint32_t minor = client.vpnIpv4 & 0xffff;
+                                 return (client.vpnIpv4 & mask) != network || client.limit.empty() || minor == 0 ||
+                                        minor == ROOT_CLASS || minor == DEFAULT_CLASS;
+                               }),
+                clients.end());
+  std::sort(clients.begin(), clients.end(),
+            [](const ShapedClient &a, const ShapedClient &b) { return a.vpnIpv4 < b.vpnIpv4; });
+  clients.erase(std::unique(clients.begin(), clients.end(),
+                            [](const ShapedClient &a, const ShapedClient &b) { return a.vpnIpv4 == b.vpnIpv4; }),
+                clients.end());
+
+  const std::string dev = " dev " + device;
+  const bool shapeDownload = serviceLimit.download > 0 ||
+                             std::any_of(clients.begin(), clients.end(),
+                                         [](const ShapedClient &client) { return client.limit.download > 0; });
+  const bool shapeUpload = serviceLimit.upload > 0 ||
+                           std::any_of(clients.begin(), clients.end(),
+                                       [](const ShapedClient &client) { return client.limit.upload > 0; });
+
+  if (shapeDownload)
+  {
+    // 服务不限速时未分类的流量直接发送（default 0），客户端类挂在根下
+    std::string parent = "1:";
+    if (serviceLimit.download > 0)
+    {
+      const std::string total = rate(serviceLimit.download);
+      script += "qdisc add" + dev + " root handle 1: htb default " + hex(DEFAULT_CLASS) + "\n";
+      script += "class add" + dev + " parent 1: classid 1:" + hex(ROOT_CLASS) + " htb rate " + total + " ceil " +
+                total + QUANTUM + "\n";
+      script += "class add" + dev + " parent 1:" + hex(ROOT_CLASS) + " classid 1:" + hex(DEFAULT_CLASS) +
+                " htb rate " + total + " ceil " + total + QUANTUM + "\n";
+      parent = "1:" + hex(ROOT_CLASS);
+    }
+    else
+    {
+      script += "qdisc add" + dev + " root handle 1: htb default 0\n";
+    }
+    for (const auto &client : clients)
+    {
+      if (client.limit.download == 0)
+        continue;
+      const std::string limit = rate(client.limit.download);
+      script += "class add" + dev + " parent " + parent + " classid 1:" + hex(client.vpnIpv4 & 0xffff) + " htb rate " +
+                limit + " ceil " + limit + QUANTUM + "\n";
+    }
+    const std::string filter = "filter add" + dev + " parent 1:";
+    addHashTable(script, filter, 2, network, prefixLength, 16);
+    for (const auto &client : clients)
+    {
+      if (client.limit.download == 0)
+        continue;
+      script += filter + " prio 1 protocol ip u32 ht 2:" + hex(client.vpnIpv4 & 0xff) + ": match ip dst " +
+                IpAllocator::toString(client.vpnIpv4) + "/32 flowid 1:" + hex(client.vpnIpv4 & 0xffff) + "\n";
+    }
+  }
+
+  if (shapeUpload)
+  {
+    script += "qdisc add" + dev + " handle ffff: ingress\n";
+    const std::string filter = "filter add" + dev + " parent ffff:";
+    addHashTable(script, filter, 3, network, prefixLength, 12);
+    for (const auto &client : clients)
+    {
+      if (client.limit.upload == 0)
+        continue;
+      // 未超速时 continue，继续匹配服务的汇总限速
+      script += filter + " prio 1 protocol ip u32 ht 3:" + hex(client.vpnIpv4 & 0xff) + ": match ip src " +
+                IpAllocator::toString(client.vpnIpv4) + "/32 police rate " + rate(client.limit.upload) + " burst " +
+                burst(client.limit.upload) + " conform-exceed drop/continue\n";
+    }
+    if (serviceLimit.upload > 0)
+    {
+      script += filter + " prio 2 protocol ip u32 match u32 0 0 police rate " + rate(serviceLimit.upload) +
+                " burst " + burst(serviceLimit.upload) + " drop\n";
+    }
+  }
+}
+
+bool TrafficShaper::parseMarker(const std::string &comment, RateLimit &limit)
+{
+  if (comment.rfind(MARKER, 0) != 0)
+    return false;
+  std::istringstream fields(comment.substr(MARKER.size()));
+  RateLimit parsed;
+  if (!(fields >> parsed.download >> parsed.upload))
+    return false;
+  limit = parsed;
+  return true;
+}
+
+std::string TrafficShaper::marker(const RateLimit &limit)
+{
+  if (limit.empty())
+    return "";
+  return MARKER + std::to_string(limit.download) + " " + std::to_string(limit.upload);
+}
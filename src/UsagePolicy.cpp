@@ -0,0 +1,249 @@
+#include "UsagePolicy.hpp"
+#include "ClientSnapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static_assert(std::is_trivially_copyable<UsageCounter>::value, "UsageCounter must be trivially copyable");
+static_assert(sizeof(UsageCounter) == 120, "UsageCounter layout changed, bump the usage file version");
+
+namespace
+{
+  const char MAGIC[8] = {'O', 'V', 'P', 'N', 'U', 'S', 'E', '\0'};
+  const uint32_t VERSION = 1;
+
+  struct FileHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t count;
+    uint32_t reserved;
+  };
+
+  std::string_view nameOf(const UsageCounter &counter)
+  {
+    return std::string_view(counter.commonName, strnlen(counter.commonName, sizeof(counter.commonName)));
+  }
+
+  // 计数器中保存的形式：超长名称截断，查找时同样截断才能找到已有计数器
+  std::string_view storedName(std::string_view name)
+  {
+    return name.substr(0, std::min(name.size(), sizeof(UsageCounter::commonName) - 1));
+  }
+}
+
+UsageTracker::UsageTracker(const std::string &path) : path(path)
+{
+}
+
+uint32_t UsageTracker::monthOf(int64_t epoch)
+{
+  time_t value = static_cast<time_t>(epoch);
+  struct tm tm = {};
+  localtime_r(&value, &tm);
+  return static_cast<uint32_t>((tm.tm_year + 1900) * 12 + tm.tm_mon);
+}
+
+bool UsageTracker::load()
+{
+  counters.clear();
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+  {
+    rebuildIndex();
+    return true;
+  }
+  FileHeader header = {};
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!file || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+      header.recordSize != sizeof(UsageCounter))
+  {
+    std::cerr << "Ignoring invalid usage file " << path << std::endl;
+    rebuildIndex();
+    return false;
+  }
+  counters.resize(header.count);
+  file.read(reinterpret_cast<char *>(counters.data()), header.count * sizeof(UsageCounter));
+  if (!file)
+  {
+    counters.clear();
+    rebuildIndex();
+    return false;
+  }
+  rebuildIndex();
+  return true;
+}
+
+bool UsageTracker::save() const
+{
+  FileHeader header = {};
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.recordSize = sizeof(UsageCounter);
+  header.count = static_cast<uint32_t>(counters.size());
+
+  std::error_code ec;
+  fs::create_directories(fs::path(path).parent_path(), ec);
+  const std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+  std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(counters.data()), counters.size() * sizeof(UsageCounter));
+  file.close();
+  if (!file || rename(tmpPath.c_str(), path.c_str()) != 0)
+  {
+    fs::remove(tmpPath, ec);
+    std::cerr << "Failed to write usage file " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void UsageTracker::rebuildIndex()
+{
+  index.clear();
+  index.reserve(counters.capacity());
+  for (uint32_t i = 0; i < counters.size(); ++i)
+    index.emplace(nameOf(counters[i]), i);
+  seen.resize(counters.size(), 0);
+}
+
+uint32_t UsageTracker::counterFor(std::string_view commonName, uint32_t month, bool &created)
+{
+  commonName = storedName(commonName);
+  auto it = index.find(commonName);
+  if (it != index.end())
+  {
+    created = false;
+    return it->second;
+  }
+  created = true;
+  UsageCounter counter = {};
+  memcpy(counter.commonName, commonName.data(), commonName.size());
+  counter.month = month;
+  const bool reallocate = counters.size() == counters.capacity();
+  counters.push_back(counter);
+  seen.push_back(0);
+  if (reallocate)
+    rebuildIndex();
+  else
+    index.emplace(nameOf(counters.back()), static_cast<uint32_t>(counters.size() - 1));
+  return static_cast<uint32_t>(counters.size() - 1);
+}
+
+void UsageTracker::evaluate(const ClientSnapshot &snapshot, const UsagePolicy &policy, int64_t now,
+                            std::vector<PolicyDecision> &decisions)
+{
+  ++tick;
+  const uint32_t month = monthOf(now);
+
+  // 跨月：之前的流量不再计入，解除本引擎的拒绝，移除已离线且无标记的计数器
+  bool prune = false;
+  for (UsageCounter &counter : counters)
+  {
+    if (counter.month == month)
+      continue;
+    if (counter.flags & UsageCounter::DISABLED)
+    {
+      decisions.push_back({std::string(nameOf(counter)), PolicyAction::Enable, PolicyReason::NewMonth, counter.usage()});
+      counter.flags &= ~UsageCounter::DISABLED;
+    }
+    counter.month = month;
+    counter.monthBytes = 0;
+    counter.sessionBase = counter.sessionBytes;
+    prune = prune || counter.flags == 0;
+  }
+  if (prune)
+  {
+    counters.erase(std::remove_if(counters.begin(), counters.end(), [](const UsageCounter &counter)
+                                  { return counter.flags == 0; }),
+                   counters.end());
+    seen.assign(counters.size(), 0);
+    rebuildIndex();
+  }
+
+  for (const OnlineClient &client : snapshot.records())
+  {
+    bool created = false;
+    const uint32_t slot = counterFor(ClientSnapshot::name(client), month, created);
+    UsageCounter &counter = counters[slot];
+    seen[slot] = tick;
+    const uint64_t total = client.bytesReceived + client.bytesSent;
+
+    // 新会话：两次评估之间发生的重新连接先结清上一会话
+    if (created || !(counter.flags & UsageCounter::ONLINE) || counter.sessionStart != client.connectedSince ||
+        total < counter.sessionBytes)
+    {
+      if (counter.flags & UsageCounter::ONLINE)
+        counter.monthBytes += counter.sessionBytes - counter.sessionBase;
+      counter.sessionStart = client.connectedSince;
+      counter.sessionBase = 0;
+      counter.activityMark = total;
+      counter.lastActivity = now;
+      counter.flags = (counter.flags | UsageCounter::ONLINE) & ~UsageCounter::KICKED;
+    }
+    counter.sessionBytes = total;
+    if (total - counter.activityMark > policy.idleBytes)
+    {
+      counter.activityMark = total;
+      counter.lastActivity = now;
+    }
+
+    const uint64_t usage = counter.usage();
+    if (policy.monthlyQuotaBytes > 0 && usage > policy.monthlyQuotaBytes)
+    {
+      if (policy.denyOverQuota && !(counter.flags & UsageCounter::DISABLED))
+      {
+        decisions.push_back({std::string(ClientSnapshot::name(client)), PolicyAction::Disable, PolicyReason::Quota, usage});
+        counter.flags |= UsageCounter::DISABLED | UsageCounter::KICKED;
+      }
+      else if (!(counter.flags & UsageCounter::KICKED))
+      {
+        decisions.push_back({std::string(ClientSnapshot::name(client)), PolicyAction::Kick, PolicyReason::Quota, usage});
+        counter.flags |= UsageCounter::KICKED;
+      }
+    }
+    else if (policy.idleSeconds > 0 && now - counter.lastActivity >= policy.idleSeconds &&
+             !(counter.flags & UsageCounter::KICKED))
+    {
+      decisions.push_back({std::string(ClientSnapshot::name(client)), PolicyAction::Kick, PolicyReason::Idle, usage});
+      counter.flags |= UsageCounter::KICKED;
+    }
+  }
+
+  // 本次不在快照中的客户端已下线，结清当前会话
+  for (uint32_t i = 0; i < counters.size(); ++i)
+  {
+    UsageCounter &counter = counters[i];
+    if ((counter.flags & UsageCounter::ONLINE) && seen[i] != tick)
+    {
+      counter.monthBytes += counter.sessionBytes - counter.sessionBase;
+      counter.sessionBytes = 0;
+      counter.sessionBase = 0;
+      counter.flags &= ~(UsageCounter::ONLINE | UsageCounter::KICKED);
+    }
+  }
+}
+
+void UsageTracker::unmark(std::string_view commonName, uint32_t flags)
+{
+  auto it = index.find(storedName(commonName));
+  if (it != index.end())
+    counters[it->second].flags &= ~flags;
+}
+
+bool UsageTracker::usage(std::string_view commonName, uint64_t &bytes) const
+{
+  auto it = index.find(storedName(commonName));
+  if (it == index.end())
+    return false;
+  bytes = counters[it->second].usage();
+  return true;
+}
@@ -5,14 +5,23 @@
  * @date 2023-10-01
  * @version 1.0
  * @note  用法： ./ovpn-mana service -l  列出服务
- * @note  用法： ./ovpn-mana service -c xxxx,1194,10.1.0.0  创建服务
+ * @note  用法： ./ovpn-mana service -c xxxx,1194,10.1.0.0[/16] [--shards 4] [--profile throughput] [--dco auto] [--key p256]  创建服务
  * @note  用法： ./ovpn-mana service -d xxxx 删除服务
  * @note  用法： ./ovpn-mana service -start xxxx 启动服务
  * @note  用法： ./ovpn-mana service -stop xxxx 停止服务
  * @note  用法： ./ovpn-mana service -restart xxxx 重启服务
+ * @note  用法： ./ovpn-mana service -reload xxxx 重载服务配置（SIGHUP，不重启进程）
+ * @note  用法： ./ovpn-mana service -publish xxxx [--interval 1000] [--quota 10737418240] [--idle 1800] [--deny] 持续发布在线客户端表、记录会话历史并执行流量配额与空闲规则
+ * @note  用法： ./ovpn-mana service -rate xxxx 100mbit 50mbit 设置服务下行/上行汇总限速并应用（0 不限）
+ * @note  用法： ./ovpn-mana service -shape xxxx [--dump] 按已设置的限速重建 tc 规则，--dump 只输出批处理脚本
+ * @note  用法： ./ovpn-mana service -restart-all ['edge-*'] [--parallel 8] [--rolling 2] 批量重启服务（另有 -start-all / -stop-all）
  * @note  用法： ./ovpn-mana client -c xxxx,client1 创建客户端
  * @note  用法： ./ovpn-mana client -d xxxx,client1 吊销客户端
  * @note  用法： ./ovpn-mana client -l xxxx 列出在线客户端
+ * @note  用法： ./ovpn-mana client -l xxxx --sort total --desc --top 20 [--prefix p] [--real cidr] [--vpn cidr] [--min-bytes n] [--since t] 按条件查询
+ * @note  用法： ./ovpn-mana client -sessions xxxx [--name client1] [--from t] [--to t] 查询历史会话及汇总
+ * @note  用法： ./ovpn-mana client -rate xxxx,client1 10mbit 2mbit 设置客户端下行/上行限速并应用（0 不限）
+ * @note  用法： ./ovpn-mana client -keypool p256 [--size 64] [--low 16] [--max-age 604800] [--no-shred] [--drain] [--fill] [--watch 60] 设置、补充预生成私钥池并查看命中统计
  * @note  用法： ./ovpn-mana client -conf xxxx,client1 获取客户端配置文件
  */
 
@@ -21,7 +30,9 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <cstring>
+#include <ctime>
 #include "ovpn-mana.hpp"
 
 #if defined(__WIN32__) || defined(_WIN32) || defined(_WIN32_WCE) || defined(WIN)
@@ -37,34 +48,42 @@
 /// @param handle 句柄
 void print_services(ovpn_mana_handle_t handle)
 {
-  ovpn_service_t services[10];
-  int service_count = 0;
-  ovpn_err_t err = ovpn_mana_list_services(handle, services, service_count);
-  if (err != OVPN_ERR_SUCCESS)
+  ovpn_service_iter_t iter = nullptr;
+  if (ovpn_mana_services_begin(handle, OVPN_SERVICE_FIELD_ALL, &iter) != OVPN_ERR_SUCCESS)
   {
     std::cerr << "Failed to list OpenVPN services" << std::endl;
     return;
   }
   std::cout << "OpenVPN Services:" << std::endl;
-  for (int i = 0; i < service_count; ++i)
+  ovpn_service_info_t service;
+  while (ovpn_mana_services_next(iter, &service) == OVPN_ERR_SUCCESS)
   {
 
     std::cout 
-    << "  Name: " << services[i].name 
-    << (services[i].is_activated ? " (ACT:Yes, " : " (ACT:No, ") 
-    << (services[i].is_enabled ? " ENA:Yes)" : " ENA:No)");
+    << "  Name: " << service.name 
+    << (service.is_activated ? " (ACT:Yes, " : " (ACT:No, ") 
+    << (service.is_enabled ? " ENA:Yes)" : " ENA:No)");
+    if (service.dco_active)
+    {
+      std::cout << " [DCO]";
+    }
+    if (service.shard_count > 1)
+    {
+      std::cout << " [shards: " << service.active_shards << "/" << service.shard_count << " active]";
+    }
     std::cout << std::endl;
   }
+  ovpn_mana_services_end(iter);
 }
 
-void create_service(ovpn_mana_handle_t handle, const char *name, const  char* subnet, int port)
+void create_service(ovpn_mana_handle_t handle, const char *name, const  char* subnet, int port, const ovpn_service_options_t &options)
 {
   if (port <= 0 || port > 65535)
   {
     std::cerr << "Invalid port number. Use a number between 1 and 65535" << std::endl;
     return;
   }
-  ovpn_err_t err = ovpn_mana_create_service(handle, name, subnet, port);
+  ovpn_err_t err = ovpn_mana_create_service_ex(handle, name, subnet, port, &options);
   if (err != OVPN_ERR_SUCCESS)
   {
     std::cerr << "Failed to create OpenVPN service" << std::endl;
@@ -117,6 +136,141 @@ void restart_service(ovpn_mana_handle_t handle, const char *name)
   std::cout << "OpenVPN service restarted successfully" << std::endl;
 }
 
+void reload_service(ovpn_mana_handle_t handle, const char *name)
+{
+  ovpn_err_t err = ovpn_mana_reload_service(handle, name);
+  if (err != OVPN_ERR_SUCCESS)
+  {
+    std::cerr << "Failed to reload OpenVPN service" << std::endl;
+    return;
+  }
+  std::cout << "OpenVPN service reloaded successfully" << std::endl;
+}
+
+/// @brief 持续发布服务的在线客户端表到共享内存并记录已结束的会话，直到进程被终止
+/// @param handle 句柄
+/// @param name 服务名称
+/// @param interval_ms 检查间隔（毫秒）
+/// @param policy 流量配额与空闲规则，为 NULL 时不执行
+void publish_clients(ovpn_mana_handle_t handle, const char *name, int interval_ms, const ovpn_usage_policy_t *policy)
+{
+  static const char *ACTION_NAMES[] = {"Kicked", "Disabled", "Enabled"};
+  static const char *REASON_NAMES[] = {"quota", "idle", "new month"};
+  std::vector<ovpn_policy_action_t> actions(256);
+  unsigned long long published = 0;
+  std::cout << "Publishing online clients of '" << name << "' to shared memory, interval " << interval_ms << " ms" << std::endl;
+  while (true)
+  {
+    unsigned long long version = 0;
+    if (ovpn_mana_publish_clients(handle, name, &version) != OVPN_ERR_SUCCESS)
+    {
+      std::cerr << "Failed to publish online clients of '" << name << "'" << std::endl;
+      return;
+    }
+    if (version != published)
+    {
+      published = version;
+      std::cout << "Published version " << version << std::endl;
+    }
+    // 同一进程顺带记录已结束的会话
+    int recorded = 0;
+    if (ovpn_mana_record_sessions(handle, name, &recorded) != OVPN_ERR_SUCCESS)
+    {
+      std::cerr << "Failed to record sessions of '" << name << "'" << std::endl;
+    }
+    else if (recorded > 0)
+    {
+      std::cout << "Recorded " << recorded << " ended sessions" << std::endl;
+    }
+    if (policy != nullptr)
+    {
+      int action_count = 0;
+      if (ovpn_mana_enforce_policy(handle, name, policy, actions.data(), actions.size(), action_count) != OVPN_ERR_SUCCESS)
+      {
+        std::cerr << "Failed to enforce usage policy of '" << name << "'" << std::endl;
+      }
+      for (int i = 0; i < std::min<int>(action_count, actions.size()); ++i)
+      {
+        std::cout << ACTION_NAMES[actions[i].action] << " " << actions[i].common_name << " (" << REASON_NAMES[actions[i].reason]
+                  << ", " << actions[i].usage << " bytes this month)" << (actions[i].applied ? "" : " not applied")
+                  << std::endl;
+      }
+    }
+    usleep(static_cast<useconds_t>(interval_ms) * 1000);
+  }
+}
+
+/// @brief 应用服务的限速，dump 时只输出批处理脚本
+/// @param handle 句柄
+/// @param name 服务名称
+/// @param dump 是否只输出脚本
+void apply_shaping(ovpn_mana_handle_t handle, const char *name, bool dump)
+{
+  if (dump)
+  {
+    int length = 0;
+    ovpn_mana_build_shaping(handle, name, nullptr, 0, length);
+    std::vector<char> script(length + 1);
+    if (ovpn_mana_build_shaping(handle, name, script.data(), script.size(), length) != OVPN_ERR_SUCCESS)
+    {
+      std::cerr << "Failed to build traffic shaping of '" << name << "'" << std::endl;
+      return;
+    }
+    std::cout << script.data();
+    return;
+  }
+  if (ovpn_mana_apply_shaping(handle, name) != OVPN_ERR_SUCCESS)
+  {
+    std::cerr << "Failed to apply traffic shaping of '" << name << "'" << std::endl;
+    return;
+  }
+  std::cout << "Traffic shaping of '" << name << "' applied successfully" << std::endl;
+}
+
+void bulk_service_op(ovpn_mana_handle_t handle, const char *pattern, int action, const ovpn_bulk_options_t &options)
+{
+  static const char *STATUS_NAMES[] = {"ok", "failed", "unhealthy", "skipped"};
+  // 匹配的服务不会多于已有服务，按服务总数分配结果缓冲区（只枚举名称，不调用 systemctl）
+  int service_count = 0;
+  ovpn_mana_visit_services(
+      handle, OVPN_SERVICE_FIELD_NAME,
+      [](const ovpn_service_info_t *, void *user_data)
+      {
+        ++*static_cast<int *>(user_data);
+        return 0;
+      },
+      &service_count);
+  std::vector<ovpn_bulk_result_t> results(std::max(service_count, 1));
+  int result_count = 0;
+  ovpn_err_t err = ovpn_mana_bulk_service_op(handle, pattern, action, &options, results.data(), results.size(), result_count);
+  for (int i = 0; i < result_count && i < static_cast<int>(results.size()); ++i)
+  {
+    const int status = results[i].status;
+    const bool known = status >= 0 && status < static_cast<int>(sizeof(STATUS_NAMES) / sizeof(STATUS_NAMES[0]));
+    std::cout << std::left << std::setw(32) << results[i].name;
+    if (known)
+      std::cout << STATUS_NAMES[status] << std::endl;
+    else
+      std::cout << "unknown (" << status << ")" << std::endl;
+  }
+  // 枚举之后新建的服务已执行但结果未返回，只提示数量
+  if (result_count > static_cast<int>(results.size()))
+  {
+    std::cout << "(" << result_count - results.size() << " more services not listed)" << std::endl;
+  }
+  if (result_count == 0)
+  {
+    std::cerr << "No service matches " << pattern << std::endl;
+    return;
+  }
+  if (err != OVPN_ERR_SUCCESS)
+  {
+    std::cerr << "Bulk operation finished with failures" << std::endl;
+    return;
+  }
+  std::cout << "Bulk operation finished successfully" << std::endl;
+}
+
 /** 客户端相关命令处理函数 */
 
 void create_client(ovpn_mana_handle_t handle, const char *service_name, const char *name, const char* wanip)
@@ -141,29 +295,77 @@ void revoke_client(ovpn_mana_handle_t handle, const char *service_name, const ch
   std::cout << "OpenVPN client revoked successfully" << std::endl;
 }
 
-void list_online_clients(ovpn_mana_handle_t handle, const char *service_name)
+/// @brief 输出预生成私钥池的统计
+void print_key_pool_stats(ovpn_mana_handle_t handle, const char *algo_name, int key_algo)
 {
-  ovpn_client_t *clients = nullptr;
-  int client_count = 0;
-  ovpn_err_t err = ovpn_mana_get_online_clients(handle, service_name, nullptr, client_count);
-  if (err != OVPN_ERR_SUCCESS || client_count == 0)
+  ovpn_key_pool_stats_t stats = {};
+  if (ovpn_mana_key_pool_stats(handle, key_algo, &stats) != OVPN_ERR_SUCCESS)
   {
-    std::cerr << "Failed to get online OpenVPN clients count" << std::endl;
+    std::cerr << "Failed to get key pool stats of '" << algo_name << "'" << std::endl;
     return;
   }
-  
-  clients = new ovpn_client_t[client_count];
-  err = ovpn_mana_get_online_clients(handle, service_name, clients, client_count);
-  if (err != OVPN_ERR_SUCCESS)
+  unsigned long long taken = stats.hits + stats.misses;
+  std::cout << "Key pool '" << algo_name << "': " << stats.available << " available, " << stats.hits << " hits, "
+            << stats.misses << " misses";
+  if (taken > 0)
   {
-    std::cerr << "Failed to get online OpenVPN clients" << std::endl;
-    delete[] clients;
-    return;
+    std::cout << " (" << std::fixed << std::setprecision(1) << 100.0 * stats.hits / taken << "% hit rate)";
+  }
+  std::cout << ", " << stats.generated << " generated, " << stats.destroyed << " destroyed" << std::endl;
+}
+
+/// @brief 从发布进程的共享内存读取全部在线客户端
+/// @return 没有发布进程或读取失败时返回 false
+bool read_shared_clients(const char *service_name, std::vector<ovpn_client_t> &clients, int &client_count)
+{
+  ovpn_shared_clients_t reader = nullptr;
+  if (ovpn_mana_shared_clients_open(service_name, &reader) != OVPN_ERR_SUCCESS)
+  {
+    return false;
+  }
+  ovpn_err_t err = ovpn_mana_shared_clients_read(reader, nullptr, 0, client_count, nullptr);
+  if (err == OVPN_ERR_SUCCESS)
+  {
+    clients.resize(client_count);
+    err = ovpn_mana_shared_clients_read(reader, clients.data(), client_count, client_count, nullptr);
+  }
+  ovpn_mana_shared_clients_close(reader);
+  return err == OVPN_ERR_SUCCESS;
+}
+
+void list_online_clients(ovpn_mana_handle_t handle, const char *service_name, const ovpn_client_query_t &query)
+{
+  static const ovpn_client_query_t no_filter = {};
+  int client_count = 0;
+  std::vector<ovpn_client_t> clients;
+
+  // 不带条件时优先读取共享内存中已发布的表
+  if (memcmp(&query, &no_filter, sizeof(query)) != 0 || !read_shared_clients(service_name, clients, client_count))
+  {
+    ovpn_err_t err = ovpn_mana_query_online_clients(handle, service_name, &query, nullptr, 0, client_count);
+    if (err != OVPN_ERR_SUCCESS)
+    {
+      std::cerr << "Failed to query online OpenVPN clients" << std::endl;
+      return;
+    }
+
+    clients.resize(client_count);
+    err = ovpn_mana_query_online_clients(handle, service_name, &query, clients.data(), client_count, client_count);
+    if (err != OVPN_ERR_SUCCESS)
+    {
+      std::cerr << "Failed to get online OpenVPN clients" << std::endl;
+      return;
+    }
+  }
+  // 两次查询之间可能有客户端上下线
+  if (client_count > static_cast<int>(clients.size()))
+  {
+    client_count = static_cast<int>(clients.size());
   }
 
   // 获取总客户端数量
   int total_count = 0;
-  err = ovpn_mana_get_total_clients_count(handle, service_name, total_count);
+  ovpn_err_t err = ovpn_mana_get_total_clients_count(handle, service_name, total_count);
   if (err != OVPN_ERR_SUCCESS)
   {
     std::cerr << "Failed to get total clients count" << std::endl;
@@ -187,8 +389,114 @@ void list_online_clients(ovpn_mana_handle_t handle, const char *service_name)
     << ", Bytes Sent: " << clients[i].bytes_sent;
     std::cout << std::endl;
   }
-  
-  delete[] clients;
+}
+
+/// @brief 列出历史会话及汇总
+/// @param handle 句柄
+/// @param service_name 服务名称
+/// @param common_name 客户端名称，空串表示全部
+/// @param from 起始时间
+/// @param to 结束时间
+void list_sessions(ovpn_mana_handle_t handle, const char *service_name, const char *common_name, long long from, long long to)
+{
+  int session_count = 0;
+  if (ovpn_mana_query_sessions(handle, service_name, common_name, from, to, nullptr, 0, session_count) != OVPN_ERR_SUCCESS)
+  {
+    std::cerr << "Failed to query sessions" << std::endl;
+    return;
+  }
+  std::vector<ovpn_session_t> sessions(session_count);
+  ovpn_mana_query_sessions(handle, service_name, common_name, from, to, sessions.data(), session_count, session_count);
+  if (session_count > static_cast<int>(sessions.size()))
+  {
+    session_count = static_cast<int>(sessions.size());
+  }
+
+  std::cout << "Sessions for service '" << service_name << "':" << std::endl;
+  for (int i = 0; i < session_count; ++i)
+  {
+    char start[32] = "", end[32] = "";
+    time_t value = static_cast<time_t>(sessions[i].start);
+    strftime(start, sizeof(start), "%Y-%m-%d %H:%M:%S", localtime(&value));
+    value = static_cast<time_t>(sessions[i].end);
+    strftime(end, sizeof(end), "%Y-%m-%d %H:%M:%S", localtime(&value));
+    std::cout
+    << "  Name: " << sessions[i].common_name
+    << ", Private IP: " << sessions[i].private_ipv4
+    << ", Public IP: " << sessions[i].public_ipv4
+    << ", Start: " << start
+    << ", End: " << end
+    << ", Bytes Received: " << sessions[i].bytes_received
+    << ", Bytes Sent: " << sessions[i].bytes_sent << std::endl;
+  }
+
+  ovpn_session_totals_t totals = {};
+  if (ovpn_mana_aggregate_sessions(handle, service_name, common_name, from, to, &totals) == OVPN_ERR_SUCCESS)
+  {
+    std::cout << "Total: " << totals.sessions << " sessions, " << totals.duration << " seconds, "
+              << totals.bytes_received << " bytes received, " << totals.bytes_sent << " bytes sent" << std::endl;
+  }
+}
+
+/// @brief 解析 epoch 秒或本地时间 "YYYY-MM-DD HH:MM:SS"
+bool parse_time_option(const char *text, long long &epoch)
+{
+  char *end = nullptr;
+  long long value = strtoll(text, &end, 10);
+  if (end != text && *end == '\0')
+  {
+    epoch = value;
+    return true;
+  }
+  struct tm tm = {};
+  end = strptime(text, "%Y-%m-%d %H:%M:%S", &tm);
+  if (end == nullptr || *end != '\0')
+  {
+    return false;
+  }
+  tm.tm_isdst = -1;
+  epoch = mktime(&tm);
+  return true;
+}
+
+
+/// @brief 解析密钥算法名称：rsa、p256、p384、ed25519
+bool parse_key_algo(const std::string &name, int &key_algo)
+{
+  static const char *NAMES[] = {"rsa", "p256", "p384", "ed25519"};
+  for (int algo = OVPN_KEY_RSA; algo <= OVPN_KEY_ED25519; ++algo)
+  {
+    if (name == NAMES[algo])
+    {
+      key_algo = algo;
+      return true;
+    }
+  }
+  return false;
+}
+
+/// @brief 解析速率：bit/s，可带 k/m/g 后缀（1000 进制），可再跟 "bit"，如 512k、10mbit
+bool parse_rate_option(const char *text, unsigned long long &bps)
+{
+  char *end = nullptr;
+  unsigned long long value = strtoull(text, &end, 10);
+  if (end == text)
+  {
+    return false;
+  }
+  std::string suffix = end;
+  unsigned long long scale = 1;
+  if (!suffix.empty() && (suffix[0] == 'k' || suffix[0] == 'm' || suffix[0] == 'g'))
+  {
+    scale = suffix[0] == 'k' ? 1000ULL : suffix[0] == 'm' ? 1000000ULL : 1000000000ULL;
+    suffix.erase(0, 1);
+  }
+  if (!suffix.empty() && suffix != "bit")
+  {
+    return false;
+  }
+  bps = value * scale;
+  return true;
 }
 
 
@@ -225,14 +533,37 @@ int main(int argc, char *argv[])
     std::cerr << "Usage: " << argv[0] << " <command> [options]" << std::endl;
     std::cerr << "Commands:" << std::endl;
     std::cerr << "  service -l                                  List OpenVPN services" << std::endl;
-    std::cerr << "  service -c <name>,<port>,<subnet>          Create OpenVPN service" << std::endl;
+    std::cerr << "  service -c <name>,<port>,<subnet>[/prefix] Create OpenVPN service" << std::endl;
+    std::cerr << "             [--shards <n>]                   Split into n processes on consecutive ports" << std::endl;
+    std::cerr << "             [--profile <name>]               default|throughput|latency|low-power-clients" << std::endl;
+    std::cerr << "             [--dco auto|off|required]        Kernel data channel offload" << std::endl;
+    std::cerr << "             [--key rsa|p256|p384|ed25519]    Key algorithm for server and client certificates" << std::endl;
     std::cerr << "  service -d <name>                           Delete OpenVPN service" << std::endl;
     std::cerr << "  service -start <name>                       Start OpenVPN service" << std::endl;
     std::cerr << "  service -stop <name>                        Stop OpenVPN service" << std::endl;
     std::cerr << "  service -restart <name>                     Restart OpenVPN service" << std::endl;
+    std::cerr << "  service -reload <name>                      Reload OpenVPN service configuration" << std::endl;
+    std::cerr << "  service -publish <name> [--interval <ms>]   Publish online clients and record sessions" << std::endl;
+    std::cerr << "             [--quota <bytes>] [--deny]       Kick (or deny until next month) over monthly quota" << std::endl;
+    std::cerr << "             [--idle <seconds>]               Kick clients idle for this long" << std::endl;
+    std::cerr << "  service -rate <name> <down> <up>            Set service rate limit (e.g. 100mbit, 0 = none)" << std::endl;
+    std::cerr << "  service -shape <name> [--dump]              Apply traffic shaping, or print the tc batch" << std::endl;
+    std::cerr << "  service -start-all|-stop-all|-restart-all [pattern]" << std::endl;
+    std::cerr << "             [--parallel <n>]                 Operate on matching services concurrently" << std::endl;
+    std::cerr << "             [--rolling <n>]                  At most n down at once, wait for healthy" << std::endl;
     std::cerr << "  client  -c <service_name>,<name>,<wanip>    Create OpenVPN client" << std::endl;
     std::cerr << "  client  -d <service_name>,<name>            Revoke OpenVPN client" << std::endl;
+    std::cerr << "  client  -rate <service_name>,<name> <down> <up>  Set client rate limit" << std::endl;
     std::cerr << "  client  -l <service_name>                   List online OpenVPN clients" << std::endl;
+    std::cerr << "             [--prefix <name>] [--real <cidr>] [--vpn <cidr>]" << std::endl;
+    std::cerr << "             [--min-bytes <n>] [--since <epoch|YYYY-MM-DD HH:MM:SS>]" << std::endl;
+    std::cerr << "             [--sort since|name|rx|tx|total] [--desc] [--top <k>]" << std::endl;
+    std::cerr << "  client  -sessions <service_name>            List ended sessions and totals" << std::endl;
+    std::cerr << "             [--name <name>] [--from <time>] [--to <time>]" << std::endl;
+    std::cerr << "  client  -keypool rsa|p256|p384|ed25519      Show pre-generated key pool stats" << std::endl;
+    std::cerr << "             [--size <n>] [--low <n>]         Pool size (0 = off) and refill low water mark" << std::endl;
+    std::cerr << "             [--max-age <s>] [--no-shred]     Expire unused keys, skip overwriting on destroy" << std::endl;
+    std::cerr << "             [--drain] [--fill] [--watch <s>] Destroy, refill now, or keep refilling" << std::endl;
     return -1;
   }
   
@@ -258,7 +589,7 @@ int main(int argc, char *argv[])
     {
       if (argc < 4)
       {
-        std::cerr << "Usage: " << argv[0] << " service -c <name>,<port>,<subnet>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " service -c <name>,<port>,<subnet>[/prefix] [--shards <n>] [--profile <name>] [--dco auto|off|required]" << std::endl;
         ovpn_mana_destroy(handle);
         return -1;
       }
@@ -278,8 +609,54 @@ int main(int argc, char *argv[])
       std::string subnet = service_info.substr(comma_pos2 + 1);
       int port = std::stoi(port_str);
 
+      // 可选参数
+      ovpn_service_options_t options;
+      memset(&options, 0, sizeof(options));
+      for (int i = 4; i + 1 < argc; i += 2)
+      {
+        std::string option = argv[i];
+        if (option == "--shards")
+        {
+          options.shards = std::stoi(argv[i + 1]);
+        }
+        else if (option == "--profile")
+        {
+          snprintf(options.profile, sizeof(options.profile), "%s", argv[i + 1]);
+        }
+        else if (option == "--dco")
+        {
+          std::string mode = argv[i + 1];
+          if (mode == "auto")
+            options.dco_mode = OVPN_DCO_AUTO;
+          else if (mode == "off")
+            options.dco_mode = OVPN_DCO_OFF;
+          else if (mode == "required")
+            options.dco_mode = OVPN_DCO_REQUIRED;
+          else
+          {
+            std::cerr << "Unknown DCO mode: " << mode << std::endl;
+            ovpn_mana_destroy(handle);
+            return -1;
+          }
+        }
+        else if (option == "--key")
+        {
+          if (!parse_key_algo(argv[i + 1], options.key_algo))
+          {
+            std::cerr << "Unknown key algorithm: " << argv[i + 1] << std::endl;
+            ovpn_mana_destroy(handle);
+            return -1;
+          }
+        }
+        else
+        {
+          std::cerr << "Unknown option: " << option << std::endl;
+          ovpn_mana_destroy(handle);
+          return -1;
+        }
+      }
 
-      create_service(handle, name.c_str(), subnet.c_str(), port);
+      create_service(handle, name.c_str(), subnet.c_str(), port, options);
       ovpn_mana_destroy(handle);
       return 0;
     }
@@ -335,6 +712,113 @@ int main(int argc, char *argv[])
       ovpn_mana_destroy(handle);
       return 0;
     }
+    else if (sub_command == "-reload")
+    {
+      if (argc < 4)
+      {
+        std::cerr << "Usage: " << argv[0] << " service -reload <name>" << std::endl;
+        ovpn_mana_destroy(handle);
+        return -1;
+      }
+      const char *name = argv[3];
+      reload_service(handle, name);
+      ovpn_mana_destroy(handle);
+      return 0;
+    }
+    else if (sub_command == "-publish")
+    {
+      bool valid = argc >= 4;
+      int interval_ms = 1000;
+      ovpn_usage_policy_t policy = {};
+      for (int i = 4; valid && i < argc; ++i)
+      {
+        std::string option = argv[i];
+        bool has_value = i + 1 < argc;
+        if (option == "--interval" && has_value)
+          interval_ms = std::stoi(argv[++i]);
+        else if (option == "--quota" && has_value)
+          policy.monthly_quota_bytes = std::stoull(argv[++i]);
+        else if (option == "--idle" && has_value)
+          policy.idle_seconds = std::stoi(argv[++i]);
+        else if (option == "--deny")
+          policy.deny_over_quota = 1;
+        else
+          valid = false;
+      }
+      if (!valid || interval_ms <= 0 || policy.idle_seconds < 0 || (policy.deny_over_quota && policy.monthly_quota_bytes == 0))
+      {
+        std::cerr << "Usage: " << argv[0] << " service -publish <name> [--interval <ms>] [--quota <bytes>] [--idle <seconds>] [--deny]" << std::endl;
+        ovpn_mana_destroy(handle);
+        return -1;
+      }
+      bool enforce = policy.monthly_quota_bytes > 0 || policy.idle_seconds > 0;
+      publish_clients(handle, argv[3], interval_ms, enforce ? &policy : nullptr);
+      ovpn_mana_destroy(handle);
+      return 0;
+    }
+    else if (sub_command == "-rate")
+    {
+      ovpn_rate_limit_t limit = {};
+      if (argc != 6 || !parse_rate_option(argv[4], limit.download_bps) || !parse_rate_option(argv[5], limit.upload_bps))
+      {
+        std::cerr << "Usage: " << argv[0] << " service -rate <name> <download> <upload>" << std::endl;
+        ovpn_mana_destroy(handle);
+        return -1;
+      }
+      if (ovpn_mana_set_service_rate(handle, argv[3], &limit) != OVPN_ERR_SUCCESS)
+      {
+        std::cerr << "Failed to set rate limit of '" << argv[3] << "'" << std::endl;
+        ovpn_mana_destroy(handle);
+        return -1;
+      }
+      apply_shaping(handle, argv[3], false);
+      ovpn_mana_destroy(handle);
+      return 0;
+    }
+    else if (sub_command == "-shape")
+    {
+      bool valid = argc == 4 || (argc == 5 && std::string(argv[4]) == "--dump");
+      if (!valid)
+      {
+        std::cerr << "Usage: " << argv[0] << " service -shape <name> [--dump]" << std::endl;
+        ovpn_mana_destroy(handle);
+        return -1;
+      }
+      apply_shaping(handle, argv[3], argc == 5);
+      ovpn_mana_destroy(handle);
+      return 0;
+    }
+    else if (sub_command == "-start-all" || sub_command == "-stop-all" || sub_command == "-restart-all")
+    {
+      int action = sub_command == "-start-all" ? OVPN_BULK_START : sub_command == "-stop-all" ? OVPN_BULK_STOP : OVPN_BULK_RESTART;
+      const char *pattern = "*";
+      ovpn_bulk_options_t options = {};
+      for (int i = 3; i < argc; ++i)
+      {
+        std::string option = argv[i];
+        if (option == "--parallel" && i + 1 < argc)
+        {
+          options.concurrency = std::stoi(argv[++i]);
+        }
+        else if (option == "--rolling" && i + 1 < argc)
+        {
+          options.max_unavailable = std::stoi(argv[++i]);
+        }
+        else if (option.rfind("--", 0) != 0)
+        {
+          pattern = argv[i];
+        }
+        else
+        {
+          std::cerr << "Usage: " << argv[0] << " service " << sub_command << " [pattern] [--parallel <n>] [--rolling <n>]" << std::endl;
+          ovpn_mana_destroy(handle);
+          return -1;
+        }
+      }
+      bulk_service_op(handle, pattern, action, options);
+      ovpn_mana_destroy(handle);
+      return 0;
+    }
   }
 
   // 如果是client命令
@@ -395,6 +879,97 @@ int main(int argc, char *argv[])
       ovpn_mana_destroy(handle);
       return 0;
     }
+    else if (sub_command == "-rate")
+    {
+      ovpn_rate_limit_t limit = {};
+      std::string client_info = argc == 6 ? argv[3] : "";
+      size_t comma_pos = client_info.find(',');
+      if (comma_pos == std::string::npos || !parse_rate_option(argv[4], limit.download_bps) ||
+          !parse_rate_option(argv[5], limit.upload_bps))
+      {
+        std::cerr << "Usage: " << argv[0] << " client -rate <service_name>,<name> <download> <upload>" << std::endl;
+        ovpn_mana_destroy(handle);
+        return -1;
+      }
+      std::string service_name = client_info.substr(0, comma_pos);
+      std::string name = client_info.substr(comma_pos + 1);
+      if (ovpn_mana_set_client_rate(handle, service_name.c_str(), name.c_str(), &limit) != OVPN_ERR_SUCCESS)
+      {
+        std::cerr << "Failed to set rate limit of '" << name << "'" << std::endl;
+        ovpn_mana_destroy(handle);
+        return -1;
+      }
+      apply_shaping(handle, service_name.c_str(), false);
+      ovpn_mana_destroy(handle);
+      return 0;
+    }
+    else if (sub_command == "-keypool")
+    {
+      int key_algo = OVPN_KEY_RSA;
+      bool valid = argc >= 4 && parse_key_algo(argv[3], key_algo);
+      bool configure = false, drain = false, fill = false;
+      int watch_seconds = 0;
+      ovpn_key_pool_options_t options = {};
+      options.max_age_seconds = 7 * 86400;
+      options.shred = 1;
+      for (int i = 4; valid && i < argc; ++i)
+      {
+        std::string option = argv[i];
+        bool has_value = i + 1 < argc;
+        if (option == "--size" && has_value)
+        {
+          options.size = std::stoul(argv[++i]);
+          configure = true;
+        }
+        else if (option == "--low" && has_value)
+          options.low_water = std::stoul(argv[++i]);
+        else if (option == "--max-age" && has_value)
+          options.max_age_seconds = std::stoul(argv[++i]);
+        else if (option == "--no-shred")
+          options.shred = 0;
+        else if (option == "--drain")
+          drain = true;
+        else if (option == "--fill")
+          fill = true;
+        else if (option == "--watch" && has_value)
+          watch_seconds = std::stoi(argv[++i]);
+        else
+          valid = false;
+      }
+      // --low、--max-age、--no-shred 与 --size 一同给出，整体替换池设置
+      if (!valid || watch_seconds < 0 || options.low_water > options.size ||
+          (!configure && (options.low_water != 0 || options.max_age_seconds != 7 * 86400 || !options.shred)))
+      {
+        std::cerr << "Usage: " << argv[0] << " client -keypool rsa|p256|p384|ed25519 [--size <n> [--low <n>] [--max-age <s>] [--no-shred]] [--drain] [--fill] [--watch <s>]" << std::endl;
+        ovpn_mana_destroy(handle);
+        return -1;
+      }
+      const char *algo_name = argv[3];
+      if (configure && ovpn_mana_key_pool_configure(handle, key_algo, &options) != OVPN_ERR_SUCCESS)
+      {
+        std::cerr << "Failed to configure key pool '" << algo_name << "'" << std::endl;
+        ovpn_mana_destroy(handle);
+        return -1;
+      }
+      int count = 0;
+      if (drain && ovpn_mana_key_pool_drain(handle, key_algo, count) == OVPN_ERR_SUCCESS)
+        std::cout << "Destroyed " << count << " pooled keys" << std::endl;
+      if (fill && ovpn_mana_key_pool_fill(handle, key_algo, count) == OVPN_ERR_SUCCESS)
+        std::cout << "Generated " << count << " pooled keys" << std::endl;
+      print_key_pool_stats(handle, algo_name, key_algo);
+      if (watch_seconds > 0)
+      {
+        // 常驻补充：后台线程在低于低水位时补充，前台定时输出统计
+        ovpn_mana_key_pool_start(handle, watch_seconds);
+        while (true)
+        {
+          sleep(watch_seconds);
+          print_key_pool_stats(handle, algo_name, key_algo);
+        }
+      }
+      ovpn_mana_destroy(handle);
+      return 0;
+    }
     else if (sub_command == "-l")
     {
       if (argc < 4)
@@ -404,7 +979,107 @@ int main(int argc, char *argv[])
         return -1;
       }
       const char *service_name = argv[3];
-      list_online_clients(handle, service_name);
+      ovpn_client_query_t query = {};
+      for (int i = 4; i < argc; ++i)
+      {
+        std::string option = argv[i];
+        bool has_value = i + 1 < argc;
+        if (option == "--prefix" && has_value)
+        {
+          query.name_prefix = argv[++i];
+        }
+        else if (option == "--real" && has_value)
+        {
+          query.real_cidr = argv[++i];
+        }
+        else if (option == "--vpn" && has_value)
+        {
+          query.vpn_cidr = argv[++i];
+        }
+        else if (option == "--min-bytes" && has_value)
+        {
+          query.min_bytes = std::stoull(argv[++i]);
+        }
+        else if (option == "--since" && has_value)
+        {
+          if (!parse_time_option(argv[++i], query.connected_after))
+          {
+            std::cerr << "Invalid time: " << argv[i] << std::endl;
+            ovpn_mana_destroy(handle);
+            return -1;
+          }
+        }
+        else if (option == "--sort" && has_value)
+        {
+          std::string key = argv[++i];
+          if (key == "since")
+            query.sort_by = OVPN_CLIENT_SORT_SINCE;
+          else if (key == "name")
+            query.sort_by = OVPN_CLIENT_SORT_NAME;
+          else if (key == "rx")
+            query.sort_by = OVPN_CLIENT_SORT_BYTES_RECEIVED;
+          else if (key == "tx")
+            query.sort_by = OVPN_CLIENT_SORT_BYTES_SENT;
+          else if (key == "total")
+            query.sort_by = OVPN_CLIENT_SORT_BYTES_TOTAL;
+          else
+          {
+            std::cerr << "Invalid sort key: " << key << std::endl;
+            ovpn_mana_destroy(handle);
+            return -1;
+          }
+        }
+        else if (option == "--desc")
+        {
+          query.descending = 1;
+        }
+        else if (option == "--top" && has_value)
+        {
+          query.limit = std::stoi(argv[++i]);
+        }
+        else
+        {
+          std::cerr << "Unknown option: " << option << std::endl;
+          ovpn_mana_destroy(handle);
+          return -1;
+        }
+      }
+      list_online_clients(handle, service_name, query);
+      ovpn_mana_destroy(handle);
+      return 0;
+    }
+    else if (sub_command == "-sessions")
+    {
+      if (argc < 4)
+      {
+        std::cerr << "Usage: " << argv[0] << " client -sessions <service_name> [--name <name>] [--from <time>] [--to <time>]" << std::endl;
+        ovpn_mana_destroy(handle);
+        return -1;
+      }
+      const char *service_name = argv[3];
+      const char *common_name = "";
+      long long from = 0;
+      long long to = static_cast<long long>(time(nullptr)) + 1;
+      for (int i = 4; i + 1 < argc; i += 2)
+      {
+        std::string option = argv[i];
+        bool valid = true;
+        if (option == "--name")
+          common_name = argv[i + 1];
+        else if (option == "--from")
+          valid = parse_time_option(argv[i + 1], from);
+        else if (option == "--to")
+          valid = parse_time_option(argv[i + 1], to);
+        else
+          valid = false;
+        if (!valid)
+        {
+          std::cerr << "Invalid option: " << option << " " << argv[i + 1] << std::endl;
+          ovpn_mana_destroy(handle);
+          return -1;
+        }
+      }
+      list_sessions(handle, service_name, common_name, from, to);
       ovpn_mana_destroy(handle);
       return 0;
     }
@@ -7,13 +7,24 @@
 
 #include "ovpn-mana.hpp"
 #include "OpenVPNManager.hpp"
+#include "ServiceRegistry.hpp"
+#include "ClientSnapshot.hpp"
+#include "ClientQuery.hpp"
+#include "SharedClientTable.hpp"
+#include "SessionLog.hpp"
+#include "UsagePolicy.hpp"
+#include "TrafficShaper.hpp"
+#include "KeyPool.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <cstring>
+#include <cstdio>
 #include <cstdlib>
 #include <stdexcept>
 #include <memory>
+#include <algorithm>
+#include <arpa/inet.h>
 
 /// @brief  创建OpenVPN管理器实例并返回句柄
 /// @return  句柄
@@ -84,6 +95,124 @@ LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_list_services(ovpn_mana_handle_t handl
   }
 }
 
+namespace
+{
+  // 服务迭代器：持有登记记录快照，每次 next 只查询一个服务的状态
+  struct ServiceIterator
+  {
+    std::vector<ServiceRecord> records;
+    size_t next = 0;
+    unsigned int fields = 0;
+    VPNService current; // ovpn_service_info_t 中的字符串指向此处
+  };
+
+  void fillServiceInfo(const VPNService &service, ovpn_service_info_t *info)
+  {
+    info->name = service.name.c_str();
+    info->config_path = service.configPath.c_str();
+    info->shard_count = service.shards;
+    info->is_activated = service.isActive;
+    info->active_shards = service.activeShards;
+    info->is_enabled = service.isEnabled;
+    info->dco_active = service.dcoActive;
+  }
+}
+
+/// @brief  开始枚举服务
+/// @param  handle  句柄
+/// @param  fields  需要查询的字段 OVPN_SERVICE_FIELD_*
+/// @param  iter  迭代器
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_services_begin(ovpn_mana_handle_t handle, unsigned int fields, ovpn_service_iter_t *iter)
+{
+  if (iter == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  *iter = nullptr;
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    std::unique_ptr<ServiceIterator> state(new ServiceIterator());
+    state->records = manager->serviceRecords();
+    state->fields = fields;
+    *iter = reinterpret_cast<ovpn_service_iter_t>(state.release());
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to enumerate OpenVPN services: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  取下一个服务
+/// @param  iter  迭代器
+/// @param  service  服务信息
+/// @return  错误码，没有更多服务时返回 OVPN_ERR_NOT_FOUND
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_services_next(ovpn_service_iter_t iter, ovpn_service_info_t *service)
+{
+  if (iter == nullptr || service == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    ServiceIterator *state = reinterpret_cast<ServiceIterator *>(iter);
+    if (state->next >= state->records.size())
+    {
+      return OVPN_ERR_NOT_FOUND;
+    }
+    OpenVPNManager::describeService(state->records[state->next++], state->fields, state->current);
+    fillServiceInfo(state->current, service);
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to enumerate OpenVPN services: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  结束枚举并释放迭代器
+/// @param  iter  迭代器
+LIB_API void LIB_API_CALL ovpn_mana_services_end(ovpn_service_iter_t iter)
+{
+  delete reinterpret_cast<ServiceIterator *>(iter);
+}
+
+/// @brief  以回调方式枚举服务
+/// @param  handle  句柄
+/// @param  fields  需要查询的字段 OVPN_SERVICE_FIELD_*
+/// @param  visitor  回调，返回非 0 时停止枚举
+/// @param  user_data  透传给回调的指针
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_visit_services(ovpn_mana_handle_t handle, unsigned int fields, ovpn_service_visitor_t visitor, void *user_data)
+{
+  if (visitor == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    ovpn_service_info_t info;
+    manager->visitServices(
+        [&](const VPNService &service)
+        {
+          fillServiceInfo(service, &info);
+          return visitor(&info, user_data) == 0;
+        },
+        fields);
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to enumerate OpenVPN services: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
 /// @brief  创建OpenVPN服务
 /// @param  handle  句柄
 /// @param  name  服务名称
@@ -112,6 +241,62 @@ LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_create_service(ovpn_mana_handle_t hand
   }
 }
 
+/// @brief  按参数创建OpenVPN服务
+/// @param  handle  句柄
+/// @param  name  服务名称
+/// @param  subnet  子网，可写作 10.8.0.0 或 10.8.0.0/20
+/// @param  port  服务端口
+/// @param  options  创建参数（可为nullptr，使用默认值）
+/// @return  错误码
+/// @note    客户端地址由服务内的地址位图固定分配，每个服务最大支持 /16 子网。
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_create_service_ex(ovpn_mana_handle_t handle, const char *name, const char *subnet, int port, const ovpn_service_options_t *options)
+{
+
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    ServiceOptions serviceOptions;
+    if (options != nullptr && options->prefix_length > 0)
+    {
+      serviceOptions.prefixLength = options->prefix_length;
+    }
+    if (options != nullptr && options->shards > 0)
+    {
+      serviceOptions.shards = options->shards;
+    }
+    if (options != nullptr && options->profile[0] != '\0')
+    {
+      serviceOptions.profile = std::string(options->profile, strnlen(options->profile, sizeof(options->profile)));
+    }
+    if (options != nullptr)
+    {
+      if (options->dco_mode < OVPN_DCO_AUTO || options->dco_mode > OVPN_DCO_REQUIRED)
+      {
+        return OVPN_ERR_INVALID_PARAM;
+      }
+      serviceOptions.dco = static_cast<DcoMode>(options->dco_mode);
+      if (options->key_algo < OVPN_KEY_RSA || options->key_algo > OVPN_KEY_ED25519)
+      {
+        return OVPN_ERR_INVALID_PARAM;
+      }
+      serviceOptions.keyAlgorithm = static_cast<KeyAlgorithm>(options->key_algo);
+    }
+    if (manager->createService(name, subnet, port, serviceOptions))
+    {
+      return OVPN_ERR_SUCCESS; // 成功
+    }
+    else
+    {
+      return -1; // 错误
+    }
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to create OpenVPN service: " << e.what() << std::endl;
+    return -1; // 错误
+  }
+}
+
 /// @brief  启动OpenVPN服务
 /// @param  handle  句柄
 /// @param  name  服务名称
@@ -193,6 +378,25 @@ LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_restart_service(ovpn_mana_handle_t han
   }
 }
 
+/// @brief  重载OpenVPN服务
+/// @param  handle  句柄
+/// @param  name  服务名称
+/// @return  错误码
+/// @note    向服务各实例发送 SIGHUP 重读配置，进程不退出。
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_reload_service(ovpn_mana_handle_t handle, const char *name)
+{
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    return manager->reloadService(name) ? OVPN_ERR_SUCCESS : OVPN_ERR_FAILURE;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to reload OpenVPN service: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
 /// @brief  删除OpenVPN服务
 /// @param  handle  句柄
 /// @param  name  服务名称
@@ -220,6 +424,177 @@ LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_delete_service(ovpn_mana_handle_t hand
   }
 }
 
+/// @brief  批量启动/停止/重启服务
+/// @param  handle  句柄
+/// @param  pattern  服务名通配模式
+/// @param  action  OVPN_BULK_*
+/// @param  options  执行参数（可为nullptr）
+/// @param  results  各服务结果
+/// @param  results_capacity  results 可容纳的条数
+/// @param  result_count  匹配的服务数量
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_bulk_service_op(ovpn_mana_handle_t handle, const char *pattern, int action, const ovpn_bulk_options_t *options, ovpn_bulk_result_t *results, int results_capacity, int &result_count)
+{
+
+  try
+  {
+    if (pattern == nullptr || action < OVPN_BULK_START || action > OVPN_BULK_RESTART ||
+        (results == nullptr && results_capacity > 0))
+    {
+      return OVPN_ERR_INVALID_PARAM;
+    }
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    BulkOptions bulkOptions;
+    if (options != nullptr && options->concurrency > 0)
+    {
+      bulkOptions.concurrency = options->concurrency;
+    }
+    if (options != nullptr && options->max_unavailable > 0)
+    {
+      bulkOptions.maxUnavailable = options->max_unavailable;
+    }
+    if (options != nullptr && options->health_timeout_ms > 0)
+    {
+      bulkOptions.healthTimeoutMs = options->health_timeout_ms;
+    }
+
+    std::vector<BulkResult> outcome = manager->bulkOperation(pattern, static_cast<BulkAction>(action), bulkOptions);
+    result_count = outcome.size();
+    bool allSucceeded = true;
+    for (size_t i = 0; i < outcome.size(); ++i)
+    {
+      allSucceeded = allSucceeded && outcome[i].status == BulkStatus::Succeeded;
+      if (static_cast<int>(i) < results_capacity)
+      {
+        snprintf(results[i].name, sizeof(results[i].name), "%s", outcome[i].name.c_str());
+        results[i].status = static_cast<int>(outcome[i].status);
+      }
+    }
+    return allSucceeded ? OVPN_ERR_SUCCESS : OVPN_ERR_FAILURE;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to run bulk service operation: " << e.what() << std::endl;
+    return -1; // 错误
+  }
+}
+
+namespace
+{
+  // 读取服务参数并把其中一项复制到调用方缓冲区
+  ovpn_err_t copyServiceSetting(ovpn_mana_handle_t handle, const char *name, char *buffer, int buffer_size,
+                                std::string ServiceSettings::*field)
+  {
+    if (name == nullptr || buffer == nullptr || buffer_size <= 0)
+    {
+      return OVPN_ERR_INVALID_PARAM;
+    }
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    ServiceSettings settings;
+    if (!manager->getServiceSettings(name, settings))
+    {
+      return OVPN_ERR_NOT_FOUND;
+    }
+    const std::string &value = settings.*field;
+    if (value.size() >= static_cast<size_t>(buffer_size))
+    {
+      return OVPN_ERR_INVALID_PARAM;
+    }
+    memcpy(buffer, value.c_str(), value.size() + 1);
+    return OVPN_ERR_SUCCESS;
+  }
+}
+
+/// @brief  获取服务监听端口
+/// @param  handle  句柄
+/// @param  name  服务名称
+/// @param  port  端口
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_service_port(ovpn_mana_handle_t handle, const char *name, int &port)
+{
+
+  try
+  {
+    if (name == nullptr)
+    {
+      return OVPN_ERR_INVALID_PARAM;
+    }
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    ServiceSettings settings;
+    if (!manager->getServiceSettings(name, settings))
+    {
+      return OVPN_ERR_NOT_FOUND;
+    }
+    port = settings.port;
+    return OVPN_ERR_SUCCESS; // 成功
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to get OpenVPN service port: " << e.what() << std::endl;
+    return -1; // 错误
+  }
+}
+
+/// @brief  获取服务协议
+/// @param  handle  句柄
+/// @param  name  服务名称
+/// @param  proto  输出缓冲区
+/// @param  proto_size  缓冲区大小
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_service_proto(ovpn_mana_handle_t handle, const char *name, char *proto, int proto_size)
+{
+
+  try
+  {
+    return copyServiceSetting(handle, name, proto, proto_size, &ServiceSettings::proto);
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to get OpenVPN service proto: " << e.what() << std::endl;
+    return -1; // 错误
+  }
+}
+
+/// @brief  获取服务子网
+/// @param  handle  句柄
+/// @param  name  服务名称
+/// @param  subnet  输出缓冲区
+/// @param  subnet_size  缓冲区大小
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_service_subnet(ovpn_mana_handle_t handle, const char *name, char *subnet, int subnet_size)
+{
+
+  try
+  {
+    return copyServiceSetting(handle, name, subnet, subnet_size, &ServiceSettings::subnet);
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to get OpenVPN service subnet: " << e.what() << std::endl;
+    return -1; // 错误
+  }
+}
+
+/// @brief  获取服务数据通道加密套件
+/// @param  handle  句柄
+/// @param  name  服务名称
+/// @param  cipher  输出缓冲区
+/// @param  cipher_size  缓冲区大小
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_service_cipher(ovpn_mana_handle_t handle, const char *name, char *cipher, int cipher_size)
+{
+
+  try
+  {
+    return copyServiceSetting(handle, name, cipher, cipher_size, &ServiceSettings::cipher);
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to get OpenVPN service cipher: " << e.what() << std::endl;
+    return -1; // 错误
+  }
+}
+
 /// @brief  创建OpenVPN客户端
 /// @param  handle  句柄
 /// @param  service_name  服务名称
@@ -276,6 +651,31 @@ LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_revoke_client(ovpn_mana_handle_t handl
   }
 }
 
+namespace
+{
+  // 由快照记录直接填充 ovpn_client_t，不产生临时字符串
+  void fillClient(const OnlineClient &client, ovpn_client_t *out)
+  {
+    std::string_view name = ClientSnapshot::name(client);
+    snprintf(out->name, sizeof(out->name), "%.*s", static_cast<int>(name.size()), name.data());
+    out->private_ipv4[0] = '\0';
+    if (client.vpnIpv4)
+    {
+      uint32_t networkOrder = htonl(client.vpnIpv4);
+      inet_ntop(AF_INET, &networkOrder, out->private_ipv4, sizeof(out->private_ipv4));
+    }
+    ClientSnapshot::formatEndpoint(client, out->public_ipv4, sizeof(out->public_ipv4));
+    // 沿用状态文件中的原文；共享内存中只有 epoch 秒，按其格式化
+    std::string_view since = ClientSnapshot::since(client);
+    if (client.since)
+      snprintf(out->since, sizeof(out->since), "%.*s", static_cast<int>(since.size()), since.data());
+    else
+      ClientSnapshot::formatTime(client.connectedSince, out->since, sizeof(out->since));
+    out->bytes_received = client.bytesReceived;
+    out->bytes_sent = client.bytesSent;
+  }
+}
+
 /// @brief  获取在线OpenVPN客户端列表
 /// @param  handle  句柄
 /// @param  service_name  服务名称
@@ -289,20 +689,15 @@ LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_online_clients(ovpn_mana_handle_t
   try
   {
     OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
-    std::vector<VPNClient> client_list = manager->getOnlineClients(service_name);
-    client_count = client_list.size();
+    std::shared_ptr<const ClientSnapshot> snapshot = manager->getClientSnapshot(service_name);
+    client_count = static_cast<int>(snapshot->size());
 
     if (clients != nullptr && client_count > 0)
     {
-      // 转换VPNClient 到 ovpn_client_t，使用snprintf确保安全复制和null终止
+      // 由快照记录直接写入调用方缓冲区
       for (int i = 0; i < client_count; ++i)
       {
-        snprintf(clients[i].name, sizeof(clients[i].name), "%s", client_list[i].name.c_str());
-        snprintf(clients[i].private_ipv4, sizeof(clients[i].private_ipv4), "%s", client_list[i].vpnIp.c_str());
-        snprintf(clients[i].public_ipv4, sizeof(clients[i].public_ipv4), "%s", client_list[i].realIp.c_str());
-        snprintf(clients[i].since, sizeof(clients[i].since), "%s", client_list[i].since.c_str());
-        clients[i].bytes_received = client_list[i].bytesReceived;
-        clients[i].bytes_sent = client_list[i].bytesSent;
+        fillClient((*snapshot)[i], &clients[i]);
       }
     }
 
@@ -315,57 +710,999 @@ LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_online_clients(ovpn_mana_handle_t
   }
 }
 
-/// @brief  获取总客户端数量
+namespace
+{
+  // 列按 8 字节对齐依次排在表头之后
+  size_t alignColumn(size_t offset)
+  {
+    return (offset + 7) & ~static_cast<size_t>(7);
+  }
+}
+
+/// @brief  以列式表导出在线客户端
 /// @param  handle  句柄
 /// @param  service_name  服务名称
-/// @param  total_count  总客户端数量
+/// @param  table  输出的列式表
 /// @return  错误码
-/// @note    该函数会获取指定服务的总客户端数量（统计client-config目录下的.ovpn文件数量）。
-LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_total_clients_count(ovpn_mana_handle_t handle, const char *service_name, int &total_count)
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_client_table(ovpn_mana_handle_t handle, const char *service_name, ovpn_client_table_t **table)
 {
-
+  if (service_name == nullptr || table == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  *table = nullptr;
   try
   {
     OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
-    total_count = manager->getTotalClientsCount(service_name);
-    return OVPN_ERR_SUCCESS; // 成功
+    std::shared_ptr<const ClientSnapshot> snapshot = manager->getClientSnapshot(service_name);
+    const size_t count = snapshot->size();
+    // 名称表：各名称以 '\0' 结尾依次排列
+    size_t stringsSize = 0;
+    for (const OnlineClient &client : snapshot->records())
+    {
+      stringsSize += client.nameLength + 1;
+    }
+
+    // 计算各列偏移，一次分配
+    size_t offset = alignColumn(sizeof(ovpn_client_table_t));
+    const size_t nameOffset = offset;
+    offset = alignColumn(offset + count * sizeof(unsigned int));
+    const size_t familyOffset = offset;
+    offset = alignColumn(offset + count);
+    const size_t portOffset = offset;
+    offset = alignColumn(offset + count * sizeof(unsigned short));
+    const size_t addrOffset = offset;
+    offset = alignColumn(offset + count * 16);
+    const size_t vpnOffset = offset;
+    offset = alignColumn(offset + count * sizeof(unsigned int));
+    const size_t sinceOffset = offset;
+    offset = alignColumn(offset + count * sizeof(long long));
+    const size_t receivedOffset = offset;
+    offset = alignColumn(offset + count * sizeof(unsigned long long));
+    const size_t sentOffset = offset;
+    offset = alignColumn(offset + count * sizeof(unsigned long long));
+    const size_t stringsOffset = offset;
+    offset += stringsSize;
+
+    char *block = static_cast<char *>(malloc(offset));
+    if (block == nullptr)
+    {
+      return OVPN_ERR_FAILURE;
+    }
+    unsigned int *name = reinterpret_cast<unsigned int *>(block + nameOffset);
+    unsigned char *family = reinterpret_cast<unsigned char *>(block + familyOffset);
+    unsigned short *port = reinterpret_cast<unsigned short *>(block + portOffset);
+    unsigned char(*addr)[16] = reinterpret_cast<unsigned char(*)[16]>(block + addrOffset);
+    unsigned int *vpn = reinterpret_cast<unsigned int *>(block + vpnOffset);
+    long long *since = reinterpret_cast<long long *>(block + sinceOffset);
+    unsigned long long *received = reinterpret_cast<unsigned long long *>(block + receivedOffset);
+    unsigned long long *sent = reinterpret_cast<unsigned long long *>(block + sentOffset);
+    char *strings = block + stringsOffset;
+    size_t stringOffset = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      const OnlineClient &client = (*snapshot)[i];
+      name[i] = static_cast<unsigned int>(stringOffset);
+      memcpy(strings + stringOffset, client.name, client.nameLength);
+      stringOffset += client.nameLength;
+      strings[stringOffset++] = '\0';
+      family[i] = client.realFamily;
+      port[i] = client.realPort;
+      memcpy(addr[i], client.realAddr, 16);
+      vpn[i] = client.vpnIpv4;
+      since[i] = client.connectedSince;
+      received[i] = client.bytesReceived;
+      sent[i] = client.bytesSent;
+    }
+
+    ovpn_client_table_t *result = reinterpret_cast<ovpn_client_table_t *>(block);
+    result->count = static_cast<int>(count);
+    result->strings_size = static_cast<int>(stringsSize);
+    result->strings = strings;
+    result->name = name;
+    result->real_family = family;
+    result->real_port = port;
+    result->real_addr = addr;
+    result->vpn_ipv4 = vpn;
+    result->connected_since = since;
+    result->bytes_received = received;
+    result->bytes_sent = sent;
+    *table = result;
+    return OVPN_ERR_SUCCESS;
   }
   catch (const std::exception &e)
   {
-    std::cerr << "Failed to get total clients count: " << e.what() << std::endl;
-    return -1; // 错误
+    std::cerr << "Failed to export online OpenVPN clients: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
   }
 }
-/// @brief  返回指定OpenVPN客户端配置文件内容
+
+/// @brief  释放列式表
+/// @param  table  ovpn_mana_get_client_table 返回的表
+LIB_API void LIB_API_CALL ovpn_mana_free_client_table(ovpn_client_table_t *table)
+{
+  free(table);
+}
+
+/// @brief  获取自指定版本以来在线客户端的变化
 /// @param  handle  句柄
 /// @param  service_name  服务名称
-/// @param  name  客户端名称
-/// @param  ovpn_file  客户端配置文件内容
-/// @param  ovpn_file_size  客户端配置文件大小
+/// @param  since_version  上次返回的版本，首次传 0
+/// @param  delta  输出的增量
 /// @return  错误码
-/// @note    该函数会返回指定OpenVPN客户端配置文件内容，并返回配置文件大小。客户端名称和服务名称必须合法。
-LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_client_config(ovpn_mana_handle_t handle, const char *service_name, const char *name, char *ovpn_file, int &ovpn_file_size)
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_online_clients_since(ovpn_mana_handle_t handle, const char *service_name, unsigned long long since_version, ovpn_client_delta_t **delta)
 {
-
+  if (service_name == nullptr || delta == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  *delta = nullptr;
   try
   {
     OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
-    std::string content = manager->getOVPNFileContent(name, service_name);
-    ovpn_file_size = content.size();
+    ClientDelta changes = manager->getClientDelta(service_name, since_version);
 
-    if (ovpn_file_size > 0)
+    // 表头、added、updated、removed 依次排列，一次分配
+    const size_t addedOffset = alignColumn(sizeof(ovpn_client_delta_t));
+    const size_t updatedOffset = addedOffset + changes.added.size() * sizeof(ovpn_client_t);
+    const size_t removedOffset = updatedOffset + changes.updated.size() * sizeof(ovpn_client_t);
+    const size_t size = removedOffset + changes.removed.size() * sizeof(ovpn_client_t::name);
+    char *block = static_cast<char *>(malloc(size));
+    if (block == nullptr)
     {
-      strncpy(ovpn_file, content.c_str(), ovpn_file_size);
-      return OVPN_ERR_SUCCESS; // 成功
+      return OVPN_ERR_FAILURE;
     }
-    else
+    ovpn_client_t *added = reinterpret_cast<ovpn_client_t *>(block + addedOffset);
+    ovpn_client_t *updated = reinterpret_cast<ovpn_client_t *>(block + updatedOffset);
+    char(*removed)[sizeof(ovpn_client_t::name)] = reinterpret_cast<char(*)[sizeof(ovpn_client_t::name)]>(block + removedOffset);
+    for (size_t i = 0; i < changes.added.size(); ++i)
     {
-      return -1; // 错误
+      fillClient((*changes.snapshot)[changes.added[i]], &added[i]);
     }
-  }
-  catch (const std::exception &e)
+    for (size_t i = 0; i < changes.updated.size(); ++i)
+    {
+      fillClient((*changes.snapshot)[changes.updated[i]], &updated[i]);
+    }
+    for (size_t i = 0; i < changes.removed.size(); ++i)
+    {
+      std::string_view name = ClientSnapshot::name((*changes.base)[changes.removed[i]]);
+      snprintf(removed[i], sizeof(removed[i]), "%.*s", static_cast<int>(name.size()), name.data());
+    }
+
+    ovpn_client_delta_t *result = reinterpret_cast<ovpn_client_delta_t *>(block);
+    result->version = changes.version;
+    result->full = changes.full ? 1 : 0;
+    result->added_count = static_cast<int>(changes.added.size());
+    result->updated_count = static_cast<int>(changes.updated.size());
+    result->removed_count = static_cast<int>(changes.removed.size());
+    result->added = added;
+    result->updated = updated;
+    result->removed = removed;
+    *delta = result;
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to get online OpenVPN client changes: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  释放增量
+/// @param  delta  ovpn_mana_get_online_clients_since 返回的增量
+LIB_API void LIB_API_CALL ovpn_mana_free_client_delta(ovpn_client_delta_t *delta)
+{
+  free(delta);
+}
+
+/// @brief  把在线客户端表发布到共享内存
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  version  已发布的快照版本
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_publish_clients(ovpn_mana_handle_t handle, const char *service_name, unsigned long long *version)
+{
+  if (service_name == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    uint64_t published = 0;
+    if (!manager->publishClients(service_name, published))
+    {
+      return OVPN_ERR_IO_FAILURE;
+    }
+    if (version != nullptr)
+    {
+      *version = published;
+    }
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to publish online OpenVPN clients: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  只读映射服务的共享内存客户端表
+/// @param  service_name  服务名称
+/// @param  reader  读端
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_shared_clients_open(const char *service_name, ovpn_shared_clients_t *reader)
+{
+  if (service_name == nullptr || reader == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  *reader = nullptr;
+  std::unique_ptr<SharedClientReader> state(new SharedClientReader());
+  if (!state->open(service_name))
+  {
+    return OVPN_ERR_NOT_FOUND;
+  }
+  *reader = reinterpret_cast<ovpn_shared_clients_t>(state.release());
+  return OVPN_ERR_SUCCESS;
+}
+
+namespace
+{
+  struct SharedReadContext
+  {
+    ovpn_client_t *clients;
+    int capacity;
+    int count;
+    unsigned long long version;
+  };
+
+  // 在一致视图内直接格式化到调用方缓冲区，名称越界说明视图不一致，留空等待重试
+  void fillSharedClients(void *context, uint64_t version, int64_t, const SharedClientRecord *records, uint32_t count,
+                         const char *strings, uint32_t stringsSize)
+  {
+    SharedReadContext &out = *static_cast<SharedReadContext *>(context);
+    out.version = version;
+    out.count = static_cast<int>(count);
+    const uint32_t limit = std::min<uint32_t>(count, out.capacity > 0 ? out.capacity : 0);
+    for (uint32_t i = 0; out.clients != nullptr && i < limit; ++i)
+    {
+      const SharedClientRecord &record = records[i];
+      OnlineClient client = {};
+      client.name = "";
+      if (static_cast<uint64_t>(record.nameOffset) + record.nameLength <= stringsSize)
+      {
+        client.name = strings + record.nameOffset;
+        client.nameLength = record.nameLength;
+      }
+      client.realFamily = record.realFamily;
+      client.realPort = record.realPort;
+      memcpy(client.realAddr, record.realAddr, sizeof(client.realAddr));
+      client.vpnIpv4 = record.vpnIpv4;
+      client.connectedSince = record.connectedSince;
+      client.bytesReceived = record.bytesReceived;
+      client.bytesSent = record.bytesSent;
+      fillClient(client, &out.clients[i]);
+    }
+  }
+}
+
+/// @brief  从共享内存读取在线客户端表
+/// @param  reader  读端
+/// @param  clients  输出缓冲区
+/// @param  clients_capacity  缓冲区容量
+/// @param  client_count  在线客户端数量
+/// @param  version  发布的快照版本
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_shared_clients_read(ovpn_shared_clients_t reader, ovpn_client_t *clients, int clients_capacity, int &client_count, unsigned long long *version)
+{
+  if (reader == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  SharedClientReader *state = reinterpret_cast<SharedClientReader *>(reader);
+  SharedReadContext context = {clients, clients_capacity, 0, 0};
+  if (!state->visit(fillSharedClients, &context))
+  {
+    // 版本为 0 表示回调从未执行，即尚未发布
+    return context.version == 0 ? OVPN_ERR_NOT_FOUND : OVPN_ERR_TIMEOUT;
+  }
+  client_count = context.count;
+  if (version != nullptr)
+  {
+    *version = context.version;
+  }
+  return OVPN_ERR_SUCCESS;
+}
+
+/// @brief  关闭读端
+/// @param  reader  读端
+LIB_API void LIB_API_CALL ovpn_mana_shared_clients_close(ovpn_shared_clients_t reader)
+{
+  delete reinterpret_cast<SharedClientReader *>(reader);
+}
+
+/// @brief  记录已结束的会话
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  recorded  本次追加的会话数
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_record_sessions(ovpn_mana_handle_t handle, const char *service_name, int *recorded)
+{
+  if (service_name == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    int count = 0;
+    if (!manager->recordSessions(service_name, count))
+    {
+      return OVPN_ERR_IO_FAILURE;
+    }
+    if (recorded != nullptr)
+    {
+      *recorded = count;
+    }
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to record OpenVPN sessions: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  查询历史会话
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  common_name  客户端名称
+/// @param  from  起始时间
+/// @param  to  结束时间
+/// @param  sessions  输出缓冲区
+/// @param  sessions_capacity  缓冲区容量
+/// @param  session_count  匹配的会话数
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_query_sessions(ovpn_mana_handle_t handle, const char *service_name, const char *common_name, long long from, long long to, ovpn_session_t *sessions, int sessions_capacity, int &session_count)
+{
+  if (service_name == nullptr || sessions_capacity < 0)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    std::vector<SessionRecord> records;
+    if (!manager->querySessions(service_name, common_name ? common_name : "", from, to, 0, records))
+    {
+      return OVPN_ERR_IO_FAILURE;
+    }
+    session_count = static_cast<int>(records.size());
+    const size_t limit = sessions != nullptr ? std::min<size_t>(records.size(), sessions_capacity) : 0;
+    for (size_t i = 0; i < limit; ++i)
+    {
+      const SessionRecord &record = records[i];
+      ovpn_session_t &out = sessions[i];
+      snprintf(out.common_name, sizeof(out.common_name), "%s", record.commonName);
+      out.private_ipv4[0] = '\0';
+      if (record.vpnIpv4)
+      {
+        uint32_t networkOrder = htonl(record.vpnIpv4);
+        inet_ntop(AF_INET, &networkOrder, out.private_ipv4, sizeof(out.private_ipv4));
+      }
+      OnlineClient endpoint = {};
+      endpoint.realFamily = record.realFamily;
+      endpoint.realPort = record.realPort;
+      memcpy(endpoint.realAddr, record.realAddr, sizeof(endpoint.realAddr));
+      ClientSnapshot::formatEndpoint(endpoint, out.public_ipv4, sizeof(out.public_ipv4));
+      out.start = record.start;
+      out.end = record.end;
+      out.bytes_received = record.bytesReceived;
+      out.bytes_sent = record.bytesSent;
+    }
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to query OpenVPN sessions: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  汇总历史会话
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  common_name  客户端名称
+/// @param  from  起始时间
+/// @param  to  结束时间
+/// @param  totals  汇总结果
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_aggregate_sessions(ovpn_mana_handle_t handle, const char *service_name, const char *common_name, long long from, long long to, ovpn_session_totals_t *totals)
+{
+  if (service_name == nullptr || totals == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    SessionTotals result;
+    if (!manager->aggregateSessions(service_name, common_name ? common_name : "", from, to, result))
+    {
+      return OVPN_ERR_IO_FAILURE;
+    }
+    totals->sessions = result.sessions;
+    totals->duration = result.duration;
+    totals->bytes_received = result.bytesReceived;
+    totals->bytes_sent = result.bytesSent;
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to aggregate OpenVPN sessions: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  执行流量配额与空闲规则
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  policy  规则
+/// @param  actions  输出缓冲区
+/// @param  actions_capacity  缓冲区容量
+/// @param  action_count  本次执行的动作数
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_enforce_policy(ovpn_mana_handle_t handle, const char *service_name, const ovpn_usage_policy_t *policy, ovpn_policy_action_t *actions, int actions_capacity, int &action_count)
+{
+  action_count = 0;
+  if (service_name == nullptr || policy == nullptr || actions_capacity < 0)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    UsagePolicy rules;
+    rules.monthlyQuotaBytes = policy->monthly_quota_bytes;
+    rules.idleSeconds = policy->idle_seconds;
+    if (policy->idle_bytes > 0)
+    {
+      rules.idleBytes = policy->idle_bytes;
+    }
+    rules.denyOverQuota = policy->deny_over_quota != 0;
+
+    std::vector<PolicyDecision> decisions;
+    bool success = manager->enforcePolicy(service_name, rules, decisions);
+    action_count = static_cast<int>(decisions.size());
+    const size_t limit = actions != nullptr ? std::min<size_t>(decisions.size(), actions_capacity) : 0;
+    for (size_t i = 0; i < limit; ++i)
+    {
+      const PolicyDecision &decision = decisions[i];
+      ovpn_policy_action_t &out = actions[i];
+      snprintf(out.common_name, sizeof(out.common_name), "%s", decision.commonName.c_str());
+      out.action = decision.action == PolicyAction::Kick      ? OVPN_POLICY_KICK
+                   : decision.action == PolicyAction::Disable ? OVPN_POLICY_DISABLE
+                                                              : OVPN_POLICY_ENABLE;
+      out.reason = decision.reason == PolicyReason::Quota  ? OVPN_POLICY_REASON_QUOTA
+                   : decision.reason == PolicyReason::Idle ? OVPN_POLICY_REASON_IDLE
+                                                           : OVPN_POLICY_REASON_NEW_MONTH;
+      out.usage = decision.usage;
+      out.applied = decision.applied ? 1 : 0;
+    }
+    return success ? OVPN_ERR_SUCCESS : OVPN_ERR_FAILURE;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to enforce usage policy: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  查询客户端本月的累计流量
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  common_name  客户端名称
+/// @param  bytes  累计字节数
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_client_usage(ovpn_mana_handle_t handle, const char *service_name, const char *common_name, unsigned long long *bytes)
+{
+  if (service_name == nullptr || common_name == nullptr || bytes == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    uint64_t usage = 0;
+    if (!manager->getClientUsage(service_name, common_name, usage))
+    {
+      return OVPN_ERR_NOT_FOUND;
+    }
+    *bytes = usage;
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to get client usage: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  查询单个客户端是否在线
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  name  客户端名称
+/// @param  client  客户端信息
+/// @return  错误码，不在线返回 OVPN_ERR_NOT_FOUND
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_online_client(ovpn_mana_handle_t handle, const char *service_name, const char *name, ovpn_client_t *client)
+{
+  if (service_name == nullptr || name == nullptr || client == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    std::shared_ptr<const ClientSnapshot> snapshot;
+    const OnlineClient *found = manager->findOnlineClient(service_name, name, snapshot);
+    if (found == nullptr)
+    {
+      return OVPN_ERR_NOT_FOUND;
+    }
+    fillClient(*found, client);
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to get online OpenVPN client: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  在全部服务中查找在线客户端
+/// @param  handle  句柄
+/// @param  name  客户端名称
+/// @param  service_name  所在服务名称
+/// @param  service_name_size  缓冲区大小
+/// @param  client  客户端信息，可为 NULL
+/// @return  错误码，不在线返回 OVPN_ERR_NOT_FOUND
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_find_online_client(ovpn_mana_handle_t handle, const char *name, char *service_name, int service_name_size, ovpn_client_t *client)
+{
+  if (name == nullptr || service_name == nullptr || service_name_size <= 0)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    std::shared_ptr<const ClientSnapshot> snapshot;
+    std::string service;
+    const OnlineClient *found = manager->locateOnlineClient(name, service, snapshot);
+    if (found == nullptr)
+    {
+      return OVPN_ERR_NOT_FOUND;
+    }
+    if (service.size() >= static_cast<size_t>(service_name_size))
+    {
+      return OVPN_ERR_INVALID_PARAM;
+    }
+    memcpy(service_name, service.c_str(), service.size() + 1);
+    if (client != nullptr)
+    {
+      fillClient(*found, client);
+    }
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to find online OpenVPN client: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  按条件查询在线客户端
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  query  查询条件
+/// @param  clients  结果缓冲区
+/// @param  clients_capacity  clients 可容纳的条数
+/// @param  client_count  结果数量
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_query_online_clients(ovpn_mana_handle_t handle, const char *service_name, const ovpn_client_query_t *query, ovpn_client_t *clients, int clients_capacity, int &client_count)
+{
+  client_count = 0;
+  if (service_name == nullptr || (clients == nullptr && clients_capacity > 0))
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    ClientQuery clientQuery;
+    if (query != nullptr)
+    {
+      if (query->name_prefix != nullptr)
+        clientQuery.namePrefix = query->name_prefix;
+      if (query->real_cidr != nullptr && query->real_cidr[0] != '\0' &&
+          !AddressRange::parse(query->real_cidr, clientQuery.realRange))
+        return OVPN_ERR_INVALID_PARAM;
+      if (query->vpn_cidr != nullptr && query->vpn_cidr[0] != '\0' &&
+          !AddressRange::parse(query->vpn_cidr, clientQuery.vpnRange))
+        return OVPN_ERR_INVALID_PARAM;
+      if (query->sort_by < OVPN_CLIENT_SORT_SINCE || query->sort_by > OVPN_CLIENT_SORT_BYTES_TOTAL || query->limit < 0)
+        return OVPN_ERR_INVALID_PARAM;
+      clientQuery.minBytes = query->min_bytes;
+      clientQuery.connectedAfter = query->connected_after;
+      clientQuery.sortKey = static_cast<ClientSortKey>(query->sort_by);
+      clientQuery.descending = query->descending != 0;
+      clientQuery.limit = static_cast<size_t>(query->limit);
+    }
+
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    std::shared_ptr<const ClientSnapshot> snapshot = manager->getClientSnapshot(service_name);
+    std::vector<uint32_t> result = clientQuery.run(*snapshot);
+    client_count = static_cast<int>(result.size());
+    for (int i = 0; i < client_count && i < clients_capacity; ++i)
+    {
+      fillClient((*snapshot)[result[i]], &clients[i]);
+    }
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to query online OpenVPN clients: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  获取总客户端数量
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  total_count  总客户端数量
+/// @return  错误码
+/// @note    该函数会获取指定服务的总客户端数量（统计client-config目录下的.ovpn文件数量）。
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_total_clients_count(ovpn_mana_handle_t handle, const char *service_name, int &total_count)
+{
+
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    total_count = manager->getTotalClientsCount(service_name);
+    return OVPN_ERR_SUCCESS; // 成功
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to get total clients count: " << e.what() << std::endl;
+    return -1; // 错误
+  }
+}
+/// @brief  返回指定OpenVPN客户端配置文件内容
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  name  客户端名称
+/// @param  ovpn_file  客户端配置文件内容
+/// @param  ovpn_file_size  客户端配置文件大小
+/// @return  错误码
+/// @note    该函数会返回指定OpenVPN客户端配置文件内容，并返回配置文件大小。客户端名称和服务名称必须合法。
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_get_client_config(ovpn_mana_handle_t handle, const char *service_name, const char *name, char *ovpn_file, int &ovpn_file_size)
+{
+
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    std::string content = manager->getOVPNFileContent(name, service_name);
+    ovpn_file_size = content.size();
+
+    if (ovpn_file_size > 0)
+    {
+      strncpy(ovpn_file, content.c_str(), ovpn_file_size);
+      return OVPN_ERR_SUCCESS; // 成功
+    }
+    else
+    {
+      return -1; // 错误
+    }
+  }
+  catch (const std::exception &e)
   {
     std::cerr << "Failed to get OpenVPN client config: " << e.what() << std::endl;
     return -1; // 错误
   }
 }
+
+/// @brief  检测数据通道卸载（ovpn-dco）可用性
+/// @param  handle  句柄
+/// @param  module_loaded  内核模块是否已加载
+/// @param  openvpn_support  OpenVPN 是否支持 DCO（2.6+ 且带 [DCO] 编译特性）
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_detect_dco(ovpn_mana_handle_t handle, int &module_loaded, int &openvpn_support)
+{
+
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    DcoStatus status = manager->detectDco();
+    module_loaded = status.moduleLoaded;
+    openvpn_support = status.openvpnSupport;
+    return OVPN_ERR_SUCCESS; // 成功
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to detect DCO support: " << e.what() << std::endl;
+    return -1; // 错误
+  }
+}
+
+/// @brief  设置服务的汇总限速
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  limit  限速
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_set_service_rate(ovpn_mana_handle_t handle, const char *service_name, const ovpn_rate_limit_t *limit)
+{
+  if (service_name == nullptr || limit == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    RateLimit rate;
+    rate.download = limit->download_bps;
+    rate.upload = limit->upload_bps;
+    return manager->setServiceRate(service_name, rate) ? OVPN_ERR_SUCCESS : OVPN_ERR_IO_FAILURE;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to set service rate: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  设置客户端限速
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  common_name  客户端名称
+/// @param  limit  限速
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_set_client_rate(ovpn_mana_handle_t handle, const char *service_name, const char *common_name, const ovpn_rate_limit_t *limit)
+{
+  if (service_name == nullptr || common_name == nullptr || limit == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    RateLimit rate;
+    rate.download = limit->download_bps;
+    rate.upload = limit->upload_bps;
+    return manager->setClientRate(service_name, common_name, rate) ? OVPN_ERR_SUCCESS : OVPN_ERR_IO_FAILURE;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to set client rate: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  应用服务的限速
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_apply_shaping(ovpn_mana_handle_t handle, const char *service_name)
+{
+  if (service_name == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    return manager->applyShaping(service_name) ? OVPN_ERR_SUCCESS : OVPN_ERR_FAILURE;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to apply traffic shaping: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  生成服务的 tc 批处理脚本
+/// @param  handle  句柄
+/// @param  service_name  服务名称
+/// @param  script  输出缓冲区
+/// @param  script_size  缓冲区大小
+/// @param  script_length  脚本长度
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_build_shaping(ovpn_mana_handle_t handle, const char *service_name, char *script, int script_size, int &script_length)
+{
+  script_length = 0;
+  if (service_name == nullptr)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    std::vector<std::pair<std::string, std::string>> scripts;
+    if (!manager->buildShaping(service_name, scripts))
+    {
+      return OVPN_ERR_NOT_FOUND;
+    }
+    std::string content;
+    for (const auto &unit : scripts)
+    {
+      content += "# " + unit.first + "\n" + unit.second;
+    }
+    script_length = static_cast<int>(content.size());
+    if (script == nullptr || script_size <= script_length)
+    {
+      return OVPN_ERR_INVALID_PARAM;
+    }
+    memcpy(script, content.c_str(), content.size() + 1);
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to build traffic shaping: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  设置算法的预生成私钥池
+/// @param  handle  句柄
+/// @param  key_algo  算法
+/// @param  options  池设置
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_configure(ovpn_mana_handle_t handle, int key_algo, const ovpn_key_pool_options_t *options)
+{
+  if (options == nullptr || key_algo < OVPN_KEY_RSA || key_algo > OVPN_KEY_ED25519)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    KeyPoolOptions poolOptions;
+    poolOptions.size = options->size;
+    poolOptions.lowWater = options->low_water;
+    poolOptions.maxAgeSeconds = options->max_age_seconds;
+    poolOptions.shred = options->shred != 0;
+    if (poolOptions.lowWater > poolOptions.size)
+    {
+      return OVPN_ERR_INVALID_PARAM;
+    }
+    return manager->configureKeyPool(static_cast<KeyAlgorithm>(key_algo), poolOptions) ? OVPN_ERR_SUCCESS
+                                                                                         : OVPN_ERR_IO_FAILURE;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to configure key pool: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  获取预生成私钥池的统计
+/// @param  handle  句柄
+/// @param  key_algo  算法
+/// @param  stats  输出统计
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_stats(ovpn_mana_handle_t handle, int key_algo, ovpn_key_pool_stats_t *stats)
+{
+  if (stats == nullptr || key_algo < OVPN_KEY_RSA || key_algo > OVPN_KEY_ED25519)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    KeyPoolStats poolStats;
+    if (!manager->getKeyPoolStats(static_cast<KeyAlgorithm>(key_algo), poolStats))
+    {
+      return OVPN_ERR_IO_FAILURE;
+    }
+    stats->available = poolStats.available;
+    stats->hits = poolStats.hits;
+    stats->misses = poolStats.misses;
+    stats->generated = poolStats.generated;
+    stats->destroyed = poolStats.destroyed;
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to get key pool stats: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  补充预生成私钥池
+/// @param  handle  句柄
+/// @param  key_algo  算法
+/// @param  generated  本次生成的数量
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_fill(ovpn_mana_handle_t handle, int key_algo, int &generated)
+{
+  generated = 0;
+  if (key_algo < OVPN_KEY_RSA || key_algo > OVPN_KEY_ED25519)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    return manager->fillKeyPool(static_cast<KeyAlgorithm>(key_algo), generated) ? OVPN_ERR_SUCCESS
+                                                                                 : OVPN_ERR_IO_FAILURE;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to fill key pool: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  清空预生成私钥池
+/// @param  handle  句柄
+/// @param  key_algo  算法
+/// @param  destroyed  销毁的数量
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_drain(ovpn_mana_handle_t handle, int key_algo, int &destroyed)
+{
+  destroyed = 0;
+  if (key_algo < OVPN_KEY_RSA || key_algo > OVPN_KEY_ED25519)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    return manager->drainKeyPool(static_cast<KeyAlgorithm>(key_algo), destroyed) ? OVPN_ERR_SUCCESS
+                                                                                 : OVPN_ERR_IO_FAILURE;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to drain key pool: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  启动后台补充线程
+/// @param  handle  句柄
+/// @param  interval_seconds  检查间隔（秒）
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_start(ovpn_mana_handle_t handle, int interval_seconds)
+{
+  if (interval_seconds <= 0)
+  {
+    return OVPN_ERR_INVALID_PARAM;
+  }
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    manager->startKeyPoolWorker(interval_seconds);
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to start key pool worker: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
+
+/// @brief  停止后台补充线程
+/// @param  handle  句柄
+/// @return  错误码
+LIB_API ovpn_err_t LIB_API_CALL ovpn_mana_key_pool_stop(ovpn_mana_handle_t handle)
+{
+  try
+  {
+    OpenVPNManager *manager = reinterpret_cast<OpenVPNManager *>(handle);
+    manager->stopKeyPoolWorker();
+    return OVPN_ERR_SUCCESS;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to stop key pool worker: " << e.what() << std::endl;
+    return OVPN_ERR_FAILURE;
+  }
+}
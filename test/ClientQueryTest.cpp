@@ -0,0 +1,95 @@
+#include "ClientQuery.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // alice、bob、carol 依次连接，流量递增；dave 从 IPv6 地址接入
+  class ClientQueryTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      snapshot.parse("OpenVPN CLIENT LIST\n"
+                     "alice,198.51.100.1:1000,100,100,2025-04-24 09:00:00\n"
+                     "bob,198.51.100.2:1000,300,100,2025-04-24 09:10:00\n"
+                     "carol,203.0.113.3:1000,50,1000,2025-04-24 09:20:00\n"
+                     "dave,[2001:db8::1]:1000,10,10,2025-04-24 09:30:00\n"
+                     "ROUTING TABLE\n"
+                     "10.8.0.2,alice,198.51.100.1:1000,2025-04-24 10:00:00\n"
+                     "10.8.0.3,bob,198.51.100.2:1000,2025-04-24 10:00:00\n"
+                     "10.8.1.4,carol,203.0.113.3:1000,2025-04-24 10:00:00\n"
+                     "GLOBAL STATS\n");
+      snapshot.finish();
+    }
+
+    std::vector<std::string> names(const ClientQuery &query) const
+    {
+      std::vector<std::string> result;
+      for (uint32_t index : query.run(snapshot))
+        result.emplace_back(ClientSnapshot::name(snapshot[index]));
+      return result;
+    }
+
+    ClientSnapshot snapshot;
+  };
+}
+
+TEST(AddressRangeTest, ParsesAndMatches)
+{
+  AddressRange range;
+  ASSERT_TRUE(AddressRange::parse("10.8.0.0/24", range));
+  const uint8_t inside[16] = {10, 8, 0, 77};
+  const uint8_t outside[16] = {10, 8, 1, 77};
+  EXPECT_TRUE(range.contains(4, inside));
+  EXPECT_FALSE(range.contains(4, outside));
+  EXPECT_FALSE(range.contains(6, inside));
+
+  ASSERT_TRUE(AddressRange::parse("2001:db8::/32", range));
+  const uint8_t v6[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+  EXPECT_TRUE(range.contains(6, v6));
+
+  EXPECT_FALSE(AddressRange::parse("10.8.0.0/33", range));
+  EXPECT_FALSE(AddressRange::parse("not-an-address", range));
+}
+
+TEST_F(ClientQueryTest, DefaultsToConnectionOrder)
+{
+  EXPECT_EQ(names(ClientQuery()), (std::vector<std::string>{"alice", "bob", "carol", "dave"}));
+}
+
+TEST_F(ClientQueryTest, FiltersCombine)
+{
+  ClientQuery query;
+  ASSERT_TRUE(AddressRange::parse("198.51.100.0/24", query.realRange));
+  EXPECT_EQ(names(query), (std::vector<std::string>{"alice", "bob"}));
+
+  query.minBytes = 300;
+  EXPECT_EQ(names(query), (std::vector<std::string>{"bob"}));
+
+  ClientQuery vpn;
+  ASSERT_TRUE(AddressRange::parse("10.8.1.0/24", vpn.vpnRange));
+  EXPECT_EQ(names(vpn), (std::vector<std::string>{"carol"}));
+
+  ClientQuery prefix;
+  prefix.namePrefix = "da";
+  EXPECT_EQ(names(prefix), (std::vector<std::string>{"dave"}));
+}
+
+// 指定 limit 时只排出前 K 个，结果与完整排序的前 K 个一致
+TEST_F(ClientQueryTest, SortsAndLimits)
+{
+  ClientQuery query;
+  query.sortKey = ClientSortKey::BytesTotal;
+  query.descending = true;
+  EXPECT_EQ(names(query), (std::vector<std::string>{"carol", "bob", "alice", "dave"}));
+  query.limit = 2;
+  EXPECT_EQ(names(query), (std::vector<std::string>{"carol", "bob"}));
+
+  ClientQuery byName;
+  byName.sortKey = ClientSortKey::Name;
+  byName.descending = true;
+  byName.limit = 1;
+  EXPECT_EQ(names(byName), (std::vector<std::string>{"dave"}));
+}
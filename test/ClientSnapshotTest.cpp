@@ -0,0 +1,169 @@
+#include "ClientSnapshot.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// 统计本进程（含动态库）经全局 operator new 的堆分配次数
+namespace
+{
+  std::atomic<size_t> allocations{0};
+
+  void *countedAlloc(std::size_t size, std::size_t alignment = 0)
+  {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = nullptr;
+    if (alignment > alignof(std::max_align_t))
+      p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    else
+      p = std::malloc(size ? size : 1);
+    return p;
+  }
+}
+
+void *operator new(std::size_t size)
+{
+  if (void *p = countedAlloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size); }
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+  if (void *p = countedAlloc(size, static_cast<std::size_t>(alignment)))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace
+{
+  // 生成 status-version 1 格式的状态文件内容
+  std::string statusText(int clients)
+  {
+    std::string text = "OpenVPN CLIENT LIST\nUpdated,2025-04-24 10:00:00\n"
+                       "Common Name,Real Address,Bytes Received,Bytes Sent,Connected Since\n";
+    for (int i = 0; i < clients; ++i)
+    {
+      text += "client" + std::to_string(i) + ",203.0.113." + std::to_string(i % 250) + ":" +
+              std::to_string(40000 + i % 20000) + "," + std::to_string(i * 10) + "," + std::to_string(i * 20) +
+              ",2025-04-24 09:" + std::to_string(10 + i % 50) + ":00\n";
+    }
+    text += "ROUTING TABLE\nVirtual Address,Common Name,Real Address,Last Ref\n";
+    for (int i = 0; i < clients; ++i)
+    {
+      text += "10.8." + std::to_string(i / 250) + "." + std::to_string(i % 250 + 2) + ",client" + std::to_string(i) +
+              ",203.0.113." + std::to_string(i % 250) + ":" + std::to_string(40000 + i % 20000) +
+              ",2025-04-24 10:00:00\n";
+    }
+    text += "GLOBAL STATS\nEND\n";
+    return text;
+  }
+
+  // 以足够的分配区预估解析一次，返回期间的堆分配次数
+  size_t countParse(const std::string &text)
+  {
+    size_t before = allocations.load();
+    {
+      ClientSnapshot snapshot(text.size() * 2 + 4096);
+      snapshot.parse(text);
+      snapshot.finish();
+    }
+    return allocations.load() - before;
+  }
+}
+
+TEST(ClientSnapshotTest, ParsesClientsAndRoutes)
+{
+  ClientSnapshot snapshot;
+  snapshot.parse(statusText(3));
+  snapshot.finish();
+  ASSERT_EQ(snapshot.size(), 3u);
+
+  const OnlineClient *client = snapshot.find("client1");
+  ASSERT_NE(client, nullptr);
+  EXPECT_EQ(ClientSnapshot::name(*client), "client1");
+  EXPECT_EQ(client->realFamily, 4);
+  EXPECT_EQ(client->realPort, 40001);
+  EXPECT_EQ(client->bytesReceived, 10u);
+  EXPECT_EQ(client->bytesSent, 20u);
+  EXPECT_EQ(client->vpnIpv4, (10u << 24) | (8u << 16) | 3u);
+  EXPECT_EQ(ClientSnapshot::formatEndpoint(*client), "203.0.113.1:40001");
+  EXPECT_EQ(snapshot.find("missing"), nullptr);
+
+  // 按连接时间升序
+  for (size_t i = 1; i < snapshot.size(); ++i)
+    EXPECT_LE(snapshot[i - 1].connectedSince, snapshot[i].connectedSince);
+}
+
+TEST(ClientSnapshotTest, LaterDuplicateWins)
+{
+  ClientSnapshot snapshot;
+  snapshot.parse("OpenVPN CLIENT LIST\n"
+                 "alice,198.51.100.1:1000,1,2,2025-04-24 09:00:00\n"
+                 "alice,198.51.100.2:2000,3,4,2025-04-24 09:30:00\n"
+                 "GLOBAL STATS\n");
+  snapshot.finish();
+  ASSERT_EQ(snapshot.size(), 1u);
+  EXPECT_EQ(snapshot[0].realPort, 2000);
+  EXPECT_EQ(snapshot[0].bytesSent, 4u);
+}
+
+// 稳态解析路径不为单个客户端分配堆内存：分配次数与客户端数量无关
+TEST(ClientSnapshotTest, NoPerClientHeapAllocations)
+{
+  const std::string small = statusText(10);
+  const std::string large = statusText(20000);
+  countParse(small); // 预热：首次 mktime 加载时区等一次性分配
+
+  const size_t smallCount = countParse(small);
+  const size_t largeCount = countParse(large);
+  EXPECT_LE(largeCount, smallCount + 2) << "small: " << smallCount << ", large: " << largeCount;
+  EXPECT_LT(largeCount, 16u);
+}
+
+// 文本输出写入调用方缓冲区，不分配堆内存
+TEST(ClientSnapshotTest, FormatIntoCallerBuffersWithoutAllocation)
+{
+  ClientSnapshot snapshot;
+  snapshot.parse(statusText(100));
+  snapshot.finish();
+  char endpoint[64];
+  char since[32];
+  size_t before = allocations.load();
+  for (const OnlineClient &client : snapshot.records())
+  {
+    ClientSnapshot::formatEndpoint(client, endpoint, sizeof(endpoint));
+    ClientSnapshot::formatTime(client.connectedSince, since, sizeof(since));
+  }
+  EXPECT_EQ(allocations.load() - before, 0u);
+}
+
+// 连接时间原文保留给旧接口，旧版 ctime 格式同样解析为 epoch 秒
+TEST(ClientSnapshotTest, KeepsOriginalSinceText)
+{
+  ClientSnapshot snapshot;
+  snapshot.parse("OpenVPN CLIENT LIST\n"
+                 "alice,198.51.100.1:1000,1,1,2025-04-24 09:00:00\n"
+                 "bob,198.51.100.2:1000,1,1,Thu Apr 24 09:10:00 2025\n"
+                 "ROUTING TABLE\nGLOBAL STATS\n");
+  snapshot.finish();
+  ASSERT_EQ(snapshot.size(), 2u);
+  EXPECT_EQ(ClientSnapshot::since(snapshot[0]), "2025-04-24 09:00:00");
+  EXPECT_EQ(ClientSnapshot::since(snapshot[1]), "Thu Apr 24 09:10:00 2025");
+  EXPECT_EQ(snapshot[1].connectedSince - snapshot[0].connectedSince, 600);
+
+  const OnlineClient detached = {};
+  EXPECT_TRUE(ClientSnapshot::since(detached).empty());
+}
@@ -0,0 +1,184 @@
+#include "ConfigProfile.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const std::set<std::string> AEAD_CIPHERS = {"AES-128-GCM", "AES-192-GCM", "AES-256-GCM", "CHACHA20-POLY1305"};
+
+  // 渲染结果按指令名分组，值为该指令每次出现时的参数
+  std::map<std::string, std::vector<std::string>> directives(const std::string &config)
+  {
+    std::map<std::string, std::vector<std::string>> result;
+    std::istringstream lines(config);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+      std::istringstream tokens(line);
+      std::string directive;
+      if (!(tokens >> directive))
+        continue;
+      std::string args;
+      std::getline(tokens, args);
+      result[directive].push_back(args.empty() ? args : args.substr(1));
+    }
+    return result;
+  }
+
+  std::string server(const ConfigProfile &profile)
+  {
+    std::ostringstream out;
+    profile.renderServer(out);
+    return out.str();
+  }
+
+  std::string client(const ConfigProfile &profile)
+  {
+    std::ostringstream out;
+    profile.renderClient(out);
+    return out.str();
+  }
+
+  void expectAeadList(const std::string &list)
+  {
+    std::istringstream ciphers(list);
+    std::string cipher;
+    int count = 0;
+    while (std::getline(ciphers, cipher, ':'))
+    {
+      EXPECT_EQ(AEAD_CIPHERS.count(cipher), 1u) << cipher;
+      ++count;
+    }
+    EXPECT_GT(count, 0);
+  }
+}
+
+// 默认档案与早期版本生成的配置一致
+TEST(ConfigProfileTest, DefaultMatchesLegacyOutput)
+{
+  const ConfigProfile *profile = ConfigProfile::find(ConfigProfile::DEFAULT_NAME);
+  ASSERT_NE(profile, nullptr);
+  EXPECT_EQ(server(*profile), "keepalive 10 120\n");
+  EXPECT_EQ(client(*profile), "cipher AES-256-CBC\n");
+}
+
+TEST(ConfigProfileTest, ThroughputRendersExpectedDirectives)
+{
+  const ConfigProfile *profile = ConfigProfile::find("throughput");
+  ASSERT_NE(profile, nullptr);
+  EXPECT_EQ(server(*profile), "keepalive 10 60\n"
+                              "sndbuf 4194304\n"
+                              "push \"sndbuf 4194304\"\n"
+                              "rcvbuf 4194304\n"
+                              "push \"rcvbuf 4194304\"\n"
+                              "txqueuelen 1000\n"
+                              "fast-io\n"
+                              "data-ciphers AES-256-GCM:AES-128-GCM:CHACHA20-POLY1305\n"
+                              "data-ciphers-fallback AES-256-CBC\n"
+                              "allow-compression no\n"
+                              "tun-mtu 1500\n"
+                              "mssfix 1450\n");
+  EXPECT_EQ(client(*profile), "data-ciphers AES-256-GCM:AES-128-GCM:CHACHA20-POLY1305\n"
+                              "allow-compression no\n"
+                              "tun-mtu 1500\n"
+                              "mssfix 1450\n");
+}
+
+// 每个档案渲染出的配置：指令不重复（push 除外）、保活超时至少为间隔两倍、加密套件均为 AEAD、MTU 合理
+TEST(ConfigProfileTest, EveryProfileRendersValidConfigs)
+{
+  for (const ConfigProfile &base : ConfigProfile::all())
+  {
+    for (const ConfigProfile &profile : {base, base.forDco()})
+    {
+      SCOPED_TRACE(profile.marker());
+      EXPECT_TRUE(profile.proto == "udp" || profile.proto == "tcp");
+
+      auto serverDirectives = directives(server(profile));
+      auto clientDirectives = directives(client(profile));
+      for (const auto &entry : serverDirectives)
+      {
+        if (entry.first != "push")
+        {
+          EXPECT_EQ(entry.second.size(), 1u) << entry.first;
+        }
+      }
+      for (const auto &entry : clientDirectives)
+      {
+        EXPECT_EQ(entry.second.size(), 1u) << entry.first;
+      }
+
+      ASSERT_EQ(serverDirectives.count("keepalive"), 1u);
+      int interval = 0, timeout = 0;
+      std::istringstream(serverDirectives["keepalive"][0]) >> interval >> timeout;
+      EXPECT_GT(interval, 0);
+      EXPECT_GE(timeout, 2 * interval);
+
+      if (profile.tunMtu != 0)
+      {
+        EXPECT_GE(profile.tunMtu, 576);
+        EXPECT_LE(profile.tunMtu, 9000);
+        EXPECT_LT(profile.mssfix, profile.tunMtu);
+      }
+      if (serverDirectives.count("data-ciphers"))
+      {
+        expectAeadList(serverDirectives["data-ciphers"][0]);
+        ASSERT_EQ(clientDirectives.count("data-ciphers"), 1u);
+        EXPECT_EQ(clientDirectives["data-ciphers"][0], serverDirectives["data-ciphers"][0]);
+      }
+      else
+      {
+        EXPECT_EQ(clientDirectives.count("cipher"), 1u);
+      }
+      // fast-io 只对 UDP 有效
+      if (serverDirectives.count("fast-io"))
+      {
+        EXPECT_EQ(profile.proto, "udp");
+      }
+      // 服务端推送的缓冲区与本地设置一致
+      if (profile.sndbuf > 0)
+      {
+        ASSERT_EQ(serverDirectives.count("sndbuf"), 1u);
+        EXPECT_EQ(serverDirectives["sndbuf"][0], std::to_string(profile.sndbuf));
+      }
+    }
+  }
+}
+
+// DCO 只支持 AEAD 且不支持压缩，也不能回退到 CBC
+TEST(ConfigProfileTest, DcoVariantsDropCbcAndCompression)
+{
+  for (const ConfigProfile &base : ConfigProfile::all())
+  {
+    const ConfigProfile profile = base.forDco();
+    SCOPED_TRACE(profile.name);
+    auto serverDirectives = directives(server(profile));
+    auto clientDirectives = directives(client(profile));
+    EXPECT_EQ(serverDirectives.count("data-ciphers-fallback"), 0u);
+    EXPECT_EQ(clientDirectives.count("cipher"), 0u);
+    ASSERT_EQ(serverDirectives.count("data-ciphers"), 1u);
+    expectAeadList(serverDirectives["data-ciphers"][0]);
+    ASSERT_EQ(serverDirectives.count("allow-compression"), 1u);
+    EXPECT_EQ(serverDirectives["allow-compression"][0], "no");
+  }
+}
+
+TEST(ConfigProfileTest, MarkerRoundTrips)
+{
+  for (const ConfigProfile &base : ConfigProfile::all())
+  {
+    for (const ConfigProfile &profile : {base, base.forDco()})
+    {
+      const std::string config = "port 1194\n" + profile.marker() + "\nproto udp\n";
+      ConfigProfile parsed = ConfigProfile::fromServerConfig(config);
+      EXPECT_EQ(parsed.name, profile.name);
+      EXPECT_EQ(parsed.dco, profile.dco);
+    }
+  }
+  EXPECT_EQ(ConfigProfile::fromServerConfig("port 1194\n").name, ConfigProfile::DEFAULT_NAME);
+  EXPECT_EQ(ConfigProfile::fromServerConfig(ConfigProfile::MARKER + "unknown\n").name, ConfigProfile::DEFAULT_NAME);
+}
@@ -0,0 +1,63 @@
+#include "ConfigTemplate.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace
+{
+  tmpl::SlotValues values()
+  {
+    tmpl::SlotValues slots{};
+    slots[static_cast<size_t>(tmpl::Slot::Port)] = "1194";
+    slots[static_cast<size_t>(tmpl::Slot::Proto)] = "udp";
+    slots[static_cast<size_t>(tmpl::Slot::Network)] = "10.8.0.0";
+    slots[static_cast<size_t>(tmpl::Slot::Netmask)] = "255.255.255.0";
+    return slots;
+  }
+}
+
+// 编译期解析：字面量与占位符交替，未知占位符或未闭合时为 0
+static_assert(tmpl::countSegments("port {{port}}\n") == 3, "literal, slot, literal");
+static_assert(tmpl::countSegments("{{port}}{{proto}}") == 2, "adjacent slots");
+static_assert(tmpl::countSegments("port {{unknown}}\n") == 0, "unknown slot");
+static_assert(tmpl::countSegments("port {{port\n") == 0, "unterminated slot");
+static_assert(tmpl::slotFromName("key_exchange") == tmpl::Slot::KeyExchange, "slot lookup");
+
+TEST(ConfigTemplateTest, RendersParsedTemplate)
+{
+  std::string error;
+  auto parsed = ConfigTemplate::parse("port {{port}}\nproto {{proto}}\nserver {{network}} {{netmask}}{{pool}}\n", error);
+  ASSERT_NE(parsed, nullptr) << error;
+  std::string out = "stale";
+  parsed->render(values(), out);
+  EXPECT_EQ(out, "port 1194\nproto udp\nserver 10.8.0.0 255.255.255.0\n");
+}
+
+TEST(ConfigTemplateTest, RejectsInvalidTemplates)
+{
+  std::string error;
+  EXPECT_EQ(ConfigTemplate::parse("", error), nullptr);
+  EXPECT_FALSE(error.empty());
+  EXPECT_EQ(ConfigTemplate::parse("port {{prot}}\n", error), nullptr);
+  EXPECT_EQ(ConfigTemplate::parse("port {{port\n", error), nullptr);
+  // 单个花括号是普通字面量
+  EXPECT_NE(ConfigTemplate::parse("port {port}\n", error), nullptr);
+}
+
+// 内置模板引用全部服务端占位符，渲染结果中不残留 {{
+TEST(ConfigTemplateTest, BuiltInTemplatesFillEverySlot)
+{
+  tmpl::SlotValues slots{};
+  for (size_t i = 0; i < slots.size(); ++i)
+    slots[i] = tmpl::SLOT_NAMES[i];
+  std::string out;
+  ConfigTemplate::server()->render(slots, out);
+  EXPECT_EQ(out.find("{{"), std::string::npos);
+  EXPECT_NE(out.find("port port\n"), std::string::npos);
+  EXPECT_NE(out.find("server network netmaskpool\n"), std::string::npos);
+  EXPECT_NE(out.find("status runtime_dir/status.log\n"), std::string::npos);
+
+  ConfigTemplate::client()->render(slots, out);
+  EXPECT_EQ(out.find("{{"), std::string::npos);
+  EXPECT_EQ(out.rfind("client\n", 0), 0u);
+  EXPECT_NE(out.find("<ca>\nca</ca>\n"), std::string::npos);
+}
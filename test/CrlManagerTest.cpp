@@ -0,0 +1,157 @@
+#include "CrlManager.hpp"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <openssl/bn.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  // 在临时目录中搭建最小的 easy-rsa pki：自签名 CA（P-256）、空的 index.txt
+  class CrlManagerTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      dir = fs::temp_directory_path() / ("ovpn-mana-crl-" + std::to_string(getpid()));
+      fs::remove_all(dir);
+      fs::create_directories(dir / "pki" / "private");
+      ASSERT_TRUE(writeCa());
+      std::ofstream(pki() + "/index.txt");
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    std::string pki() const { return (dir / "pki").string(); }
+    std::string crl() const { return (dir / "crl.pem").string(); }
+    std::string delta() const { return (dir / "crl-delta.pem").string(); }
+
+    // 模拟 easyrsa revoke：在 index.txt 中追加一条 R 记录
+    void markRevoked(const std::string &serial)
+    {
+      std::ofstream(pki() + "/index.txt", std::ios::app)
+          << "R\t351231000000Z\t250424101010Z\t" << serial << "\tunknown\t/CN=client-" << serial << "\n";
+    }
+
+    // CRL 文件中是否吊销了 serial，crlNumber 返回 CRL 序号扩展
+    static bool lists(const std::string &path, const std::string &serial, long *crlNumber = nullptr)
+    {
+      FILE *fp = fopen(path.c_str(), "r");
+      if (!fp)
+        return false;
+      std::unique_ptr<X509_CRL, void (*)(X509_CRL *)> list(PEM_read_X509_CRL(fp, nullptr, nullptr, nullptr),
+                                                           X509_CRL_free);
+      fclose(fp);
+      if (!list)
+        return false;
+      if (crlNumber)
+      {
+        ASN1_INTEGER *number = static_cast<ASN1_INTEGER *>(X509_CRL_get_ext_d2i(list.get(), NID_crl_number, nullptr, nullptr));
+        *crlNumber = number ? ASN1_INTEGER_get(number) : -1;
+        ASN1_INTEGER_free(number);
+      }
+      BIGNUM *bn = nullptr;
+      BN_hex2bn(&bn, serial.c_str());
+      ASN1_INTEGER *wanted = BN_to_ASN1_INTEGER(bn, nullptr);
+      BN_free(bn);
+      X509_REVOKED *entry = nullptr;
+      bool found = wanted && X509_CRL_get0_by_serial(list.get(), &entry, wanted) == 1;
+      ASN1_INTEGER_free(wanted);
+      return found;
+    }
+
+    fs::path dir;
+
+  private:
+    bool writeCa()
+    {
+      std::unique_ptr<EVP_PKEY_CTX, void (*)(EVP_PKEY_CTX *)> ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr),
+                                                                  EVP_PKEY_CTX_free);
+      EVP_PKEY *raw = nullptr;
+      if (!ctx || EVP_PKEY_keygen_init(ctx.get()) <= 0 ||
+          EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx.get(), NID_X9_62_prime256v1) <= 0 ||
+          EVP_PKEY_keygen(ctx.get(), &raw) <= 0)
+        return false;
+      std::unique_ptr<EVP_PKEY, void (*)(EVP_PKEY *)> key(raw, EVP_PKEY_free);
+
+      std::unique_ptr<X509, void (*)(X509 *)> cert(X509_new(), X509_free);
+      X509_NAME *name = X509_get_subject_name(cert.get());
+      if (!X509_set_version(cert.get(), 2) || !ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1) ||
+          !X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("Test CA"),
+                                      -1, -1, 0) ||
+          !X509_set_issuer_name(cert.get(), name) || !X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0) ||
+          !X509_gmtime_adj(X509_getm_notAfter(cert.get()), 86400L) || !X509_set_pubkey(cert.get(), key.get()) ||
+          !X509_sign(cert.get(), key.get(), EVP_sha256()))
+        return false;
+
+      FILE *fp = fopen((pki() + "/ca.crt").c_str(), "w");
+      bool ok = fp && PEM_write_X509(fp, cert.get());
+      if (fp)
+        fclose(fp);
+      fp = fopen((pki() + "/private/ca.key").c_str(), "w");
+      ok = ok && fp && PEM_write_PrivateKey(fp, key.get(), nullptr, nullptr, 0, nullptr, nullptr);
+      if (fp)
+        fclose(fp);
+      return ok;
+    }
+  };
+}
+
+// CLI 每条命令一个进程：easyrsa revoke 已写入 index.txt 后才首次加载，这条吊销仍须进入增量CRL
+TEST_F(CrlManagerTest, FirstRevocationReachesDeltaCrl)
+{
+  CrlManager manager(pki(), crl());
+  manager.setDeltaEnabled(true);
+  markRevoked("0A");
+  ASSERT_TRUE(manager.revoke("0A", 0));
+
+  long number = 0;
+  EXPECT_TRUE(lists(crl(), "0A", &number));
+  EXPECT_EQ(number, 1);
+  EXPECT_TRUE(lists(delta(), "0A"));
+  EXPECT_EQ(manager.size(), 1u);
+}
+
+// 已加载的实例追加新吊销：完整CRL 累积全部记录，增量CRL 只含上次完整CRL 之后的记录
+TEST_F(CrlManagerTest, LoadedManagerAppendsRevocations)
+{
+  CrlManager manager(pki(), crl());
+  manager.setDeltaEnabled(true);
+  ASSERT_TRUE(manager.publish());
+  EXPECT_FALSE(lists(crl(), "0A"));
+
+  markRevoked("0A");
+  ASSERT_TRUE(manager.revoke("0A", 0));
+  markRevoked("0B");
+  ASSERT_TRUE(manager.revoke("0b", 0));
+
+  long number = 0;
+  EXPECT_TRUE(lists(crl(), "0A", &number));
+  EXPECT_TRUE(lists(crl(), "0B"));
+  EXPECT_EQ(number, 3);
+  EXPECT_TRUE(lists(delta(), "0A"));
+  EXPECT_TRUE(lists(delta(), "0B"));
+
+  // 新进程从 index.txt 重新加载，得到相同的完整CRL
+  CrlManager reloaded(pki(), crl());
+  ASSERT_TRUE(reloaded.publish());
+  EXPECT_TRUE(lists(crl(), "0A", &number));
+  EXPECT_TRUE(lists(crl(), "0B"));
+  EXPECT_EQ(number, 4);
+}
+
+// 过期证书的吊销记录在写出前清理
+TEST_F(CrlManagerTest, PrunesExpiredEntries)
+{
+  CrlManager manager(pki(), crl());
+  ASSERT_TRUE(manager.revoke("0C", time(nullptr) - 60));
+  EXPECT_FALSE(lists(crl(), "0C"));
+  EXPECT_EQ(manager.size(), 0u);
+}
@@ -0,0 +1,101 @@
+#include "FileInstaller.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  class FileInstallerTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      dir = fs::temp_directory_path() / ("ovpn-mana-installer-" + std::to_string(getpid()));
+      fs::remove_all(dir);
+      fs::create_directories(dir);
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    std::string path(const std::string &name) const { return (dir / name).string(); }
+
+    static std::string read(const std::string &file)
+    {
+      std::ifstream in(file);
+      std::stringstream buffer;
+      buffer << in.rdbuf();
+      return buffer.str();
+    }
+
+    static void writeFile(const std::string &file, const std::string &content) { std::ofstream(file) << content; }
+
+    // 目录中的条目数（用于检查临时文件与备份都已清理）
+    size_t entryCount() const
+    {
+      size_t count = 0;
+      for (auto it = fs::directory_iterator(dir); it != fs::directory_iterator(); ++it)
+        ++count;
+      return count;
+    }
+
+    fs::path dir;
+  };
+}
+
+TEST_F(FileInstallerTest, InstallsCopiesAndContents)
+{
+  writeFile(path("source"), "certificate");
+  writeFile(path("old"), "previous");
+  FileInstaller installer;
+  installer.copy(path("source"), path("copied"), 0600).write("content", path("old"), 0644);
+  std::string error;
+  ASSERT_TRUE(installer.commit(error)) << error;
+  EXPECT_EQ(read(path("copied")), "certificate");
+  EXPECT_EQ(read(path("old")), "content");
+  EXPECT_EQ(fs::status(path("copied")).permissions() & fs::perms::all, fs::perms::owner_read | fs::perms::owner_write);
+  EXPECT_EQ(entryCount(), 3u); // 没有残留的临时文件或备份
+}
+
+// 后面的文件替换失败时，已替换的文件恢复原内容
+TEST_F(FileInstallerTest, RollsBackReplacedFilesOnFailure)
+{
+  writeFile(path("first"), "old");
+  fs::create_directory(path("blocked")); // 目录无法被文件替换
+  FileInstaller installer;
+  installer.write("new", path("first"), 0644).write("data", path("blocked"), 0644);
+  std::string error;
+  EXPECT_FALSE(installer.commit(error));
+  EXPECT_FALSE(error.empty());
+  EXPECT_EQ(read(path("first")), "old");
+  EXPECT_TRUE(fs::is_directory(path("blocked")));
+  EXPECT_EQ(entryCount(), 2u);
+}
+
+// 不覆盖模式下目标已存在时失败，本批次新建的文件被删除
+TEST_F(FileInstallerTest, NoReplaceRemovesNewFilesOnFailure)
+{
+  writeFile(path("existing"), "keep");
+  FileInstaller installer;
+  installer.noReplace().write("a", path("created"), 0644).write("b", path("existing"), 0644);
+  std::string error;
+  EXPECT_FALSE(installer.commit(error));
+  EXPECT_FALSE(fs::exists(path("created")));
+  EXPECT_EQ(read(path("existing")), "keep");
+  EXPECT_EQ(entryCount(), 1u);
+}
+
+TEST_F(FileInstallerTest, MissingSourceLeavesTargetsUntouched)
+{
+  writeFile(path("target"), "old");
+  FileInstaller installer;
+  installer.write("new", path("target"), 0644).copy(path("missing"), path("other"), 0644);
+  std::string error;
+  EXPECT_FALSE(installer.commit(error));
+  EXPECT_EQ(read(path("target")), "old");
+  EXPECT_FALSE(fs::exists(path("other")));
+  EXPECT_EQ(entryCount(), 1u);
+}
@@ -0,0 +1,106 @@
+#include "IpAllocator.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  uint32_t address(const std::string &text)
+  {
+    uint32_t addr = 0;
+    EXPECT_TRUE(IpAllocator::parseAddress(text, addr)) << text;
+    return addr;
+  }
+}
+
+TEST(IpAllocatorTest, ParsesSubnets)
+{
+  uint32_t network = 0;
+  int prefixLength = 24;
+  ASSERT_TRUE(IpAllocator::parseSubnet("10.8.3.7/20", network, prefixLength));
+  EXPECT_EQ(IpAllocator::toString(network), "10.8.0.0");
+  EXPECT_EQ(prefixLength, 20);
+
+  prefixLength = 24;
+  ASSERT_TRUE(IpAllocator::parseSubnet("192.168.5.0", network, prefixLength));
+  EXPECT_EQ(prefixLength, 24);
+
+  EXPECT_FALSE(IpAllocator::parseSubnet("10.0.0.0/8", network, prefixLength));
+  EXPECT_FALSE(IpAllocator::parseSubnet("10.8.0.0/30", network, prefixLength));
+  EXPECT_FALSE(IpAllocator::parseSubnet("10.8.0.0/x", network, prefixLength));
+  EXPECT_FALSE(IpAllocator::parseSubnet("10.8.0/24", network, prefixLength));
+  EXPECT_EQ(IpAllocator::prefixToMask(24), 0xffffff00u);
+  EXPECT_EQ(IpAllocator::prefixToMask(0), 0u);
+}
+
+// 网络地址、服务端地址与广播地址预留，其余地址各分配一次后耗尽
+TEST(IpAllocatorTest, AllocatesEveryHostOnceThenExhausts)
+{
+  for (int prefixLength : {29, 26, 24, 20})
+  {
+    SCOPED_TRACE(prefixLength);
+    IpAllocator allocator(address("10.8.0.0"), prefixLength);
+    const size_t hosts = (size_t(1) << (32 - prefixLength)) - 3;
+    EXPECT_EQ(allocator.used(), 3u);
+    EXPECT_TRUE(allocator.isAllocated(address("10.8.0.1")));
+
+    std::set<uint32_t> seen;
+    uint32_t addr = 0;
+    while (allocator.allocate(addr))
+    {
+      EXPECT_TRUE(seen.insert(addr).second) << IpAllocator::toString(addr);
+      EXPECT_GT(addr & 0xffffffffu >> prefixLength, 1u);
+    }
+    EXPECT_EQ(seen.size(), hosts);
+    EXPECT_EQ(allocator.used(), allocator.capacity());
+    EXPECT_EQ(seen.count(address("10.8.0.0") | (static_cast<uint32_t>(allocator.capacity()) - 1)), 0u);
+  }
+}
+
+TEST(IpAllocatorTest, ReserveAndRelease)
+{
+  IpAllocator allocator(address("10.8.0.0"), 24);
+  EXPECT_TRUE(allocator.reserve(address("10.8.0.2")));
+  EXPECT_FALSE(allocator.reserve(address("10.8.0.2")));
+  EXPECT_FALSE(allocator.reserve(address("10.9.0.2")));
+
+  uint32_t addr = 0;
+  ASSERT_TRUE(allocator.allocate(addr));
+  EXPECT_EQ(IpAllocator::toString(addr), "10.8.0.3");
+
+  EXPECT_TRUE(allocator.release(address("10.8.0.2")));
+  EXPECT_FALSE(allocator.release(address("10.8.0.2")));
+  // 预留地址不能释放
+  EXPECT_FALSE(allocator.release(address("10.8.0.0")));
+  EXPECT_FALSE(allocator.release(address("10.8.0.1")));
+  EXPECT_FALSE(allocator.release(address("10.8.0.255")));
+  EXPECT_EQ(allocator.used(), 4u);
+}
+
+TEST(IpAllocatorTest, SaveAndLoadRoundTrip)
+{
+  const fs::path path = fs::temp_directory_path() / ("ovpn-mana-ipp-" + std::to_string(getpid()) + ".bitmap");
+  IpAllocator allocator(address("10.8.16.0"), 20);
+  uint32_t first = 0, second = 0;
+  ASSERT_TRUE(allocator.allocate(first));
+  ASSERT_TRUE(allocator.allocate(second));
+  ASSERT_TRUE(allocator.save(path.string()));
+
+  IpAllocator loaded;
+  ASSERT_TRUE(loaded.load(path.string()));
+  fs::remove(path);
+  EXPECT_EQ(loaded.getNetwork(), allocator.getNetwork());
+  EXPECT_EQ(loaded.getPrefixLength(), 20);
+  EXPECT_EQ(loaded.used(), allocator.used());
+  EXPECT_TRUE(loaded.isAllocated(first));
+  EXPECT_TRUE(loaded.isAllocated(second));
+
+  uint32_t next = 0;
+  ASSERT_TRUE(loaded.allocate(next));
+  EXPECT_NE(next, first);
+  EXPECT_NE(next, second);
+}
@@ -0,0 +1,83 @@
+// 各密钥算法的生成与签名速度，用于复现 README 中的数据：ovpn-mana-keybench [每项秒数]
+#include "KeyPool.hpp"
+#include "KeySpec.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  // 在 seconds 内反复执行 step（至少 3 次），返回每秒次数，失败返回负数
+  template <typename Step>
+  double measure(double seconds, Step step)
+  {
+    const auto start = Clock::now();
+    long count = 0;
+    double elapsed = 0;
+    do
+    {
+      if (!step())
+        return -1;
+      ++count;
+      elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < seconds || count < 3);
+    return count / elapsed;
+  }
+
+  // 签名 TLS 1.3 CertificateVerify 大小的消息，摘要与证书签名一致（Ed25519 不使用单独的摘要）
+  bool sign(EVP_PKEY *key, const std::vector<unsigned char> &message, std::vector<unsigned char> &signature)
+  {
+    std::unique_ptr<EVP_MD_CTX, void (*)(EVP_MD_CTX *)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    const EVP_MD *md = EVP_PKEY_id(key) == EVP_PKEY_ED25519 ? nullptr : EVP_sha256();
+    size_t length = signature.size();
+    return ctx && EVP_DigestSignInit(ctx.get(), nullptr, md, nullptr, key) > 0 &&
+           EVP_DigestSign(ctx.get(), signature.data(), &length, message.data(), message.size()) > 0;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+  if (seconds <= 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [seconds per measurement]" << std::endl;
+    return 1;
+  }
+
+  const std::vector<unsigned char> message(130, 0x20);
+  std::vector<unsigned char> signature(1024);
+  std::cout << std::left << std::setw(10) << "algorithm" << std::right << std::setw(12) << "keygen/s"
+            << std::setw(12) << "ms/key" << std::setw(12) << "sign/s" << std::endl;
+  for (const KeySpec &spec : KeySpec::all())
+  {
+    std::string pem;
+    const double keygen = measure(seconds, [&] { return KeyPool::generate(spec.algorithm, pem); });
+    if (keygen < 0)
+    {
+      std::cerr << "Failed to generate " << spec.name << " key" << std::endl;
+      return 1;
+    }
+
+    std::unique_ptr<BIO, int (*)(BIO *)> bio(BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size())), BIO_free);
+    std::unique_ptr<EVP_PKEY, void (*)(EVP_PKEY *)> key(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr),
+                                                        EVP_PKEY_free);
+    const double signs = key ? measure(seconds, [&] { return sign(key.get(), message, signature); }) : -1;
+    if (signs < 0)
+    {
+      std::cerr << "Failed to sign with " << spec.name << " key" << std::endl;
+      return 1;
+    }
+
+    std::cout << std::left << std::setw(10) << spec.name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << keygen << std::setw(12) << 1000.0 / keygen << std::setw(12) << signs << std::endl;
+  }
+  return 0;
+}
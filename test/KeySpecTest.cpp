@@ -0,0 +1,55 @@
+#include "KeySpec.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+TEST(KeySpecTest, KeyExchangeBlocks)
+{
+  EXPECT_EQ(KeySpec::of(KeyAlgorithm::Rsa).keyExchange("/srv/dh.pem"), "dh /srv/dh.pem\n");
+  EXPECT_EQ(KeySpec::of(KeyAlgorithm::EcP256).keyExchange("/srv/dh.pem"),
+            "# ovpn-mana key p256\ndh none\necdh-curve prime256v1\n");
+  EXPECT_EQ(KeySpec::of(KeyAlgorithm::EcP384).keyExchange("/srv/dh.pem"),
+            "# ovpn-mana key p384\ndh none\necdh-curve secp384r1\n");
+  // X25519 不能作为 ecdh-curve（OpenSSL 1.1.x 下启动失败），以 tls-groups 指定
+  EXPECT_EQ(KeySpec::of(KeyAlgorithm::Ed25519).keyExchange("/srv/dh.pem"),
+            "# ovpn-mana key ed25519\ndh none\ntls-groups X25519\n");
+}
+
+TEST(KeySpecTest, EasyrsaOptions)
+{
+  EXPECT_EQ(KeySpec::of(KeyAlgorithm::Rsa).easyrsaOptions(), " ");
+  EXPECT_EQ(KeySpec::of(KeyAlgorithm::EcP384).easyrsaOptions(), " --use-algo=ec --curve=secp384r1 ");
+  EXPECT_EQ(KeySpec::of(KeyAlgorithm::Ed25519).easyrsaOptions(), " --use-algo=ed --curve=ed25519 ");
+  EXPECT_TRUE(KeySpec::of(KeyAlgorithm::Rsa).usesDh());
+  EXPECT_FALSE(KeySpec::of(KeyAlgorithm::Ed25519).usesDh());
+}
+
+TEST(KeySpecTest, FindsByName)
+{
+  for (const KeySpec &spec : KeySpec::all())
+  {
+    const KeySpec *found = KeySpec::find(spec.name);
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->algorithm, spec.algorithm);
+    EXPECT_EQ(&KeySpec::of(spec.algorithm), found);
+  }
+  EXPECT_EQ(KeySpec::find("dsa"), nullptr);
+}
+
+// 渲染出的标记注释还原出同一算法；没有标记的早期配置按 ecdh-curve 还原
+TEST(KeySpecTest, RecoversAlgorithmFromServerConfig)
+{
+  for (const KeySpec &spec : KeySpec::all())
+  {
+    SCOPED_TRACE(spec.name);
+    std::vector<std::string> comments = {"# ovpn-mana profile default"};
+    if (!spec.usesDh())
+      comments.push_back(spec.marker());
+    EXPECT_EQ(KeySpec::fromServerConfig(comments, spec.ecdhCurve).algorithm, spec.algorithm);
+    EXPECT_EQ(KeySpec::fromServerConfig(comments, "").algorithm, spec.algorithm);
+  }
+  EXPECT_EQ(KeySpec::fromServerConfig({}, "prime256v1").algorithm, KeyAlgorithm::EcP256);
+  EXPECT_EQ(KeySpec::fromServerConfig({}, "X25519").algorithm, KeyAlgorithm::Ed25519);
+  EXPECT_EQ(KeySpec::fromServerConfig({}, "").algorithm, KeyAlgorithm::Rsa);
+  EXPECT_EQ(KeySpec::fromServerConfig({"# ovpn-mana key unknown"}, "").algorithm, KeyAlgorithm::Rsa);
+}
@@ -0,0 +1,107 @@
+#include "SessionLog.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  class SessionLogTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      dir = fs::temp_directory_path() / ("ovpn-mana-sessions-" + std::to_string(getpid()));
+      fs::remove_all(dir);
+      fs::create_directories(dir);
+      path = (dir / "service.log").string();
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    static SessionRecord session(const std::string &name, int64_t start, int64_t end, uint64_t bytes)
+    {
+      SessionRecord record = {};
+      SessionLog::setCommonName(record, name);
+      record.start = start;
+      record.end = end;
+      record.bytesReceived = bytes;
+      record.bytesSent = bytes * 2;
+      return record;
+    }
+
+    fs::path dir;
+    std::string path;
+  };
+}
+
+// 跨越多个索引块：按名称与时间范围查询，汇总与逐条累加一致
+TEST_F(SessionLogTest, QueryAndAggregateAcrossBlocks)
+{
+  std::vector<SessionRecord> records;
+  const int total = SessionLog::BLOCK_RECORDS * 3 + 10;
+  for (int i = 0; i < total; ++i)
+    records.push_back(session("client" + std::to_string(i % 10), i * 100, i * 100 + 50, i));
+  {
+    SessionLog log(path);
+    ASSERT_TRUE(log.openForAppend());
+    ASSERT_TRUE(log.append(records));
+  }
+
+  const size_t client3Count = (total - 3 + 9) / 10;
+  SessionLog log(path);
+  std::vector<SessionRecord> sessions;
+  ASSERT_TRUE(log.query("client3", 0, INT64_MAX, 0, sessions));
+  EXPECT_EQ(sessions.size(), client3Count);
+  for (const SessionRecord &record : sessions)
+    EXPECT_STREQ(record.commonName, "client3");
+
+  // [1000, 2000) 与第 10 到 19 条相交（第 9 条在 950 结束）
+  ASSERT_TRUE(log.query("", 1000, 2000, 0, sessions));
+  ASSERT_EQ(sessions.size(), 10u);
+  EXPECT_EQ(sessions.front().start, 1000);
+
+  SessionTotals all;
+  ASSERT_TRUE(log.aggregate("", 0, INT64_MAX, all));
+  EXPECT_EQ(all.sessions, static_cast<uint64_t>(total));
+  EXPECT_EQ(all.duration, static_cast<uint64_t>(total) * 50);
+  EXPECT_EQ(all.bytesReceived, static_cast<uint64_t>(total) * (total - 1) / 2);
+
+  SessionTotals one;
+  ASSERT_TRUE(log.aggregate("client3", 0, INT64_MAX, one));
+  EXPECT_EQ(one.sessions, client3Count);
+}
+
+// 超过 63 字节的名称截断保存，以完整名称查询仍能找到
+TEST_F(SessionLogTest, LongNamesMatchAfterTruncation)
+{
+  const std::string longName(100, 'x');
+  std::vector<SessionRecord> records;
+  for (uint32_t i = 0; i < SessionLog::BLOCK_RECORDS + 1; ++i)
+    records.push_back(session(i == 0 ? longName : "other", 10, 20, 1));
+  {
+    SessionLog log(path);
+    ASSERT_TRUE(log.openForAppend());
+    ASSERT_TRUE(log.append(records));
+  }
+
+  SessionLog log(path);
+  std::vector<SessionRecord> sessions;
+  ASSERT_TRUE(log.query(longName, 0, 100, 0, sessions));
+  ASSERT_EQ(sessions.size(), 1u);
+  EXPECT_EQ(std::string(sessions[0].commonName), longName.substr(0, sizeof(SessionRecord::commonName) - 1));
+
+  SessionTotals totals;
+  ASSERT_TRUE(log.aggregate(longName, 0, 100, totals));
+  EXPECT_EQ(totals.sessions, 1u);
+}
+
+TEST_F(SessionLogTest, MissingLogIsEmpty)
+{
+  SessionLog log(path);
+  std::vector<SessionRecord> sessions;
+  EXPECT_TRUE(log.query("", 0, INT64_MAX, 0, sessions));
+  EXPECT_TRUE(sessions.empty());
+}
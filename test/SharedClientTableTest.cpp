@@ -0,0 +1,95 @@
+#include "SharedClientTable.hpp"
+#include "ClientSnapshot.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+  // 每个测试使用本进程独有的服务名，结束时删除可能残留的段
+  class SharedClientTableTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      service = "test-" + std::to_string(getpid()) + "-" + ::testing::UnitTest::GetInstance()->current_test_info()->name();
+      snapshot.parse("OpenVPN CLIENT LIST\n"
+                     "alice,198.51.100.1:1000,1,2,2025-04-24 09:00:00\n"
+                     "bob,198.51.100.2:2000,3,4,2025-04-24 09:30:00\n"
+                     "GLOBAL STATS\n");
+      snapshot.finish();
+    }
+
+    void TearDown() override
+    {
+      shm_unlink(SharedClientPublisher::segmentName(service).c_str());
+    }
+
+    std::string service;
+    ClientSnapshot snapshot;
+  };
+}
+
+TEST_F(SharedClientTableTest, ReaderSeesPublishedTable)
+{
+  SharedClientPublisher publisher;
+  ASSERT_TRUE(publisher.open(service));
+  ASSERT_TRUE(publisher.publish(snapshot, 7));
+
+  SharedClientReader reader;
+  ASSERT_TRUE(reader.open(service));
+  EXPECT_TRUE(reader.publisherAlive());
+  SharedClientReader::View view;
+  ASSERT_TRUE(reader.read(view));
+  EXPECT_EQ(view.version, 7u);
+  ASSERT_EQ(view.records.size(), 2u);
+  EXPECT_EQ(view.name(view.records[0]), "alice");
+  EXPECT_EQ(view.name(view.records[1]), "bob");
+
+  // 同一时刻只有一个发布进程
+  SharedClientPublisher second;
+  EXPECT_FALSE(second.open(service));
+}
+
+// 正常关闭删除段名，已打开的读端发现发布进程已退出
+TEST_F(SharedClientTableTest, CleanCloseUnlinksSegment)
+{
+  SharedClientPublisher publisher;
+  ASSERT_TRUE(publisher.open(service));
+  ASSERT_TRUE(publisher.publish(snapshot, 1));
+  SharedClientReader reader;
+  ASSERT_TRUE(reader.open(service));
+
+  publisher.close();
+  EXPECT_FALSE(reader.publisherAlive());
+  SharedClientReader later;
+  EXPECT_FALSE(later.open(service));
+}
+
+// 发布进程异常退出后段仍在，读端以发布锁判断其已过期；新的发布进程可以接管
+TEST_F(SharedClientTableTest, CrashedPublisherIsStale)
+{
+  pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0)
+  {
+    SharedClientPublisher publisher;
+    _exit(publisher.open(service) && publisher.publish(snapshot, 1) ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(child, &status, 0), child);
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  SharedClientReader reader;
+  EXPECT_FALSE(reader.open(service));
+
+  SharedClientPublisher publisher;
+  ASSERT_TRUE(publisher.open(service));
+  ASSERT_TRUE(publisher.publish(snapshot, 2));
+  ASSERT_TRUE(reader.open(service));
+  SharedClientReader::View view;
+  ASSERT_TRUE(reader.read(view));
+  EXPECT_EQ(view.version, 2u);
+}
@@ -0,0 +1,97 @@
+#include "TrafficShaper.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const uint32_t NETWORK = (10u << 24) | (8u << 16); // 10.8.0.0
+
+  ShapedClient client(uint32_t host, uint64_t download, uint64_t upload, uint32_t network = NETWORK)
+  {
+    ShapedClient shaped;
+    shaped.vpnIpv4 = network | host;
+    shaped.limit.download = download;
+    shaped.limit.upload = upload;
+    return shaped;
+  }
+}
+
+// 服务与客户端均限速：子网外与未限速的客户端被忽略，客户端按地址排序
+TEST(TrafficShaperTest, ServiceAndClientLimits)
+{
+  RateLimit service;
+  service.download = 10000000;
+  service.upload = 5000000;
+  std::vector<ShapedClient> clients = {
+      client(6, 2000000, 1000000),
+      client(2, 1000000, 0),
+      client(5, 1000000, 1000000, (10u << 24) | (9u << 16)),
+      client(7, 0, 0),
+  };
+  std::string script;
+  TrafficShaper::buildBatch("tun0", NETWORK | 1, 24, service, clients, script);
+  EXPECT_EQ(script,
+            "qdisc del dev tun0 root\n"
+            "qdisc del dev tun0 ingress\n"
+            "qdisc add dev tun0 root handle 1: htb default ffff\n"
+            "class add dev tun0 parent 1: classid 1:1 htb rate 10000000bit ceil 10000000bit quantum 1600\n"
+            "class add dev tun0 parent 1:1 classid 1:ffff htb rate 10000000bit ceil 10000000bit quantum 1600\n"
+            "class add dev tun0 parent 1:1 classid 1:2 htb rate 1000000bit ceil 1000000bit quantum 1600\n"
+            "class add dev tun0 parent 1:1 classid 1:6 htb rate 2000000bit ceil 2000000bit quantum 1600\n"
+            "filter add dev tun0 parent 1: prio 1 handle 2: protocol ip u32 divisor 256\n"
+            "filter add dev tun0 parent 1: prio 1 protocol ip u32 ht 800:: match ip dst 10.8.0.0/24 "
+            "hashkey mask 0x000000ff at 16 link 2:\n"
+            "filter add dev tun0 parent 1: prio 1 protocol ip u32 ht 2:2: match ip dst 10.8.0.2/32 flowid 1:2\n"
+            "filter add dev tun0 parent 1: prio 1 protocol ip u32 ht 2:6: match ip dst 10.8.0.6/32 flowid 1:6\n"
+            "qdisc add dev tun0 handle ffff: ingress\n"
+            "filter add dev tun0 parent ffff: prio 1 handle 3: protocol ip u32 divisor 256\n"
+            "filter add dev tun0 parent ffff: prio 1 protocol ip u32 ht 800:: match ip src 10.8.0.0/24 "
+            "hashkey mask 0x000000ff at 12 link 3:\n"
+            "filter add dev tun0 parent ffff: prio 1 protocol ip u32 ht 3:6: match ip src 10.8.0.6/32 "
+            "police rate 1000000bit burst 16000 conform-exceed drop/continue\n"
+            "filter add dev tun0 parent ffff: prio 2 protocol ip u32 match u32 0 0 "
+            "police rate 5000000bit burst 62500 drop\n");
+}
+
+// 服务不限速：客户端类挂在根下，未分类流量不整形；没有上行限速时不建 ingress
+TEST(TrafficShaperTest, ClientLimitsOnly)
+{
+  std::string script;
+  TrafficShaper::buildBatch("tun1", NETWORK, 16, RateLimit(), {client(0x0103, 8000000, 0)}, script);
+  EXPECT_EQ(script,
+            "qdisc del dev tun1 root\n"
+            "qdisc del dev tun1 ingress\n"
+            "qdisc add dev tun1 root handle 1: htb default 0\n"
+            "class add dev tun1 parent 1: classid 1:103 htb rate 8000000bit ceil 8000000bit quantum 1600\n"
+            "filter add dev tun1 parent 1: prio 1 handle 2: protocol ip u32 divisor 256\n"
+            "filter add dev tun1 parent 1: prio 1 protocol ip u32 ht 800:: match ip dst 10.8.0.0/16 "
+            "hashkey mask 0x000000ff at 16 link 2:\n"
+            "filter add dev tun1 parent 1: prio 1 protocol ip u32 ht 2:3: match ip dst 10.8.1.3/32 flowid 1:103\n");
+}
+
+// 没有任何限速时只删除已有规则；类号与 1:1、1:ffff 冲突的地址被跳过
+TEST(TrafficShaperTest, NothingToShapeOnlyResets)
+{
+  std::string script;
+  TrafficShaper::buildBatch("tun0", NETWORK, 16, RateLimit(), {client(1, 1000, 1000), client(0xffff, 1000, 1000)},
+                            script);
+  EXPECT_EQ(script, "qdisc del dev tun0 root\nqdisc del dev tun0 ingress\n");
+}
+
+TEST(TrafficShaperTest, MarkerRoundTrips)
+{
+  RateLimit limit;
+  limit.download = 20000000;
+  limit.upload = 0;
+  const std::string marker = TrafficShaper::marker(limit);
+  EXPECT_EQ(marker, "# ovpn-mana rate 20000000 0");
+  RateLimit parsed;
+  ASSERT_TRUE(TrafficShaper::parseMarker(marker, parsed));
+  EXPECT_EQ(parsed.download, limit.download);
+  EXPECT_EQ(parsed.upload, limit.upload);
+
+  EXPECT_EQ(TrafficShaper::marker(RateLimit()), "");
+  EXPECT_FALSE(TrafficShaper::parseMarker("# ovpn-mana profile default", parsed));
+  EXPECT_FALSE(TrafficShaper::parseMarker("# ovpn-mana rate fast", parsed));
+}
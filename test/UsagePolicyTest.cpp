@@ -0,0 +1,196 @@
+#include "UsagePolicy.hpp"
+#include "ClientSnapshot.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  const int64_t APRIL = 1744675200; // 2025-04-15 00:00:00 UTC，任何时区下都在四月中旬
+  const int64_t MAY = APRIL + 30 * 86400;
+
+  struct Online
+  {
+    std::string name;
+    uint64_t received;
+    uint64_t sent;
+    std::string since;
+  };
+
+  std::unique_ptr<ClientSnapshot> snapshot(const std::vector<Online> &clients)
+  {
+    std::string text = "OpenVPN CLIENT LIST\n";
+    for (const Online &client : clients)
+      text += client.name + ",198.51.100.1:1000," + std::to_string(client.received) + "," +
+              std::to_string(client.sent) + "," + client.since + "\n";
+    text += "GLOBAL STATS\n";
+    std::unique_ptr<ClientSnapshot> result(new ClientSnapshot());
+    result->parse(text);
+    result->finish();
+    return result;
+  }
+
+  class UsagePolicyTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      path = (fs::temp_directory_path() / ("ovpn-mana-usage-" + std::to_string(getpid()) + ".usage")).string();
+      fs::remove(path);
+    }
+    void TearDown() override { fs::remove(path); }
+
+    std::vector<PolicyDecision> evaluate(UsageTracker &tracker, const std::vector<Online> &clients,
+                                         const UsagePolicy &policy, int64_t now)
+    {
+      std::vector<PolicyDecision> decisions;
+      tracker.evaluate(*snapshot(clients), policy, now, decisions);
+      return decisions;
+    }
+
+    std::string path;
+  };
+}
+
+// 重新连接与下线时结清上一会话，本月累计跨会话延续
+TEST_F(UsagePolicyTest, AccumulatesAcrossSessions)
+{
+  UsageTracker tracker(path);
+  ASSERT_TRUE(tracker.load());
+  const UsagePolicy policy;
+  uint64_t bytes = 0;
+
+  EXPECT_TRUE(evaluate(tracker, {{"alice", 100, 200, "2025-04-14 09:00:00"}}, policy, APRIL).empty());
+  evaluate(tracker, {{"alice", 600, 400, "2025-04-14 09:00:00"}}, policy, APRIL + 60);
+  ASSERT_TRUE(tracker.usage("alice", bytes));
+  EXPECT_EQ(bytes, 1000u);
+
+  // 两次评估之间重新连接：计数从新会话重新开始
+  evaluate(tracker, {{"alice", 50, 50, "2025-04-14 10:00:00"}}, policy, APRIL + 120);
+  ASSERT_TRUE(tracker.usage("alice", bytes));
+  EXPECT_EQ(bytes, 1100u);
+
+  // 下线后保留本月累计
+  evaluate(tracker, {}, policy, APRIL + 180);
+  ASSERT_TRUE(tracker.usage("alice", bytes));
+  EXPECT_EQ(bytes, 1100u);
+  EXPECT_FALSE(tracker.usage("bob", bytes));
+
+  // 重启后从用量文件继续
+  ASSERT_TRUE(tracker.save());
+  UsageTracker reloaded(path);
+  ASSERT_TRUE(reloaded.load());
+  ASSERT_TRUE(reloaded.usage("alice", bytes));
+  EXPECT_EQ(bytes, 1100u);
+}
+
+// 超额只断开一次，重新连接后再次断开
+TEST_F(UsagePolicyTest, KicksOverQuotaOncePerSession)
+{
+  UsageTracker tracker(path);
+  UsagePolicy policy;
+  policy.monthlyQuotaBytes = 500;
+
+  auto decisions = evaluate(tracker, {{"alice", 400, 200, "2025-04-14 09:00:00"}, {"bob", 10, 10, "2025-04-14 09:00:00"}},
+                            policy, APRIL);
+  ASSERT_EQ(decisions.size(), 1u);
+  EXPECT_EQ(decisions[0].commonName, "alice");
+  EXPECT_EQ(decisions[0].action, PolicyAction::Kick);
+  EXPECT_EQ(decisions[0].reason, PolicyReason::Quota);
+  EXPECT_EQ(decisions[0].usage, 600u);
+
+  EXPECT_TRUE(evaluate(tracker, {{"alice", 500, 200, "2025-04-14 09:00:00"}}, policy, APRIL + 60).empty());
+  decisions = evaluate(tracker, {{"alice", 1, 1, "2025-04-14 10:00:00"}}, policy, APRIL + 120);
+  ASSERT_EQ(decisions.size(), 1u);
+  EXPECT_EQ(decisions[0].usage, 702u);
+}
+
+// 超额拒绝重连，下月第一次评估时解除
+TEST_F(UsagePolicyTest, DeniesUntilNextMonth)
+{
+  UsageTracker tracker(path);
+  UsagePolicy policy;
+  policy.monthlyQuotaBytes = 500;
+  policy.denyOverQuota = true;
+
+  auto decisions = evaluate(tracker, {{"alice", 400, 200, "2025-04-14 09:00:00"}}, policy, APRIL);
+  ASSERT_EQ(decisions.size(), 1u);
+  EXPECT_EQ(decisions[0].action, PolicyAction::Disable);
+  EXPECT_TRUE(evaluate(tracker, {}, policy, APRIL + 60).empty());
+
+  decisions = evaluate(tracker, {}, policy, MAY);
+  ASSERT_EQ(decisions.size(), 1u);
+  EXPECT_EQ(decisions[0].commonName, "alice");
+  EXPECT_EQ(decisions[0].action, PolicyAction::Enable);
+  EXPECT_EQ(decisions[0].reason, PolicyReason::NewMonth);
+  // 离线且已解除拒绝的计数器在跨月时移除
+  uint64_t bytes = 0;
+  EXPECT_FALSE(tracker.usage("alice", bytes));
+}
+
+// 流量增长不超过 idleBytes 持续 idleSeconds 后断开
+TEST_F(UsagePolicyTest, KicksIdleClients)
+{
+  UsageTracker tracker(path);
+  UsagePolicy policy;
+  policy.idleSeconds = 300;
+  policy.idleBytes = 1000;
+
+  EXPECT_TRUE(evaluate(tracker, {{"alice", 0, 0, "2025-04-14 09:00:00"}}, policy, APRIL).empty());
+  // keepalive 级别的流量不算活跃
+  EXPECT_TRUE(evaluate(tracker, {{"alice", 500, 400, "2025-04-14 09:00:00"}}, policy, APRIL + 200).empty());
+  auto decisions = evaluate(tracker, {{"alice", 600, 400, "2025-04-14 09:00:00"}}, policy, APRIL + 300);
+  ASSERT_EQ(decisions.size(), 1u);
+  EXPECT_EQ(decisions[0].reason, PolicyReason::Idle);
+
+  // 有流量的客户端重新计时
+  UsageTracker active(path + ".active");
+  evaluate(active, {{"bob", 0, 0, "2025-04-14 09:00:00"}}, policy, APRIL);
+  evaluate(active, {{"bob", 5000, 0, "2025-04-14 09:00:00"}}, policy, APRIL + 200);
+  EXPECT_TRUE(evaluate(active, {{"bob", 5000, 0, "2025-04-14 09:00:00"}}, policy, APRIL + 300).empty());
+}
+
+// 超过 63 字节的名称截断保存，仍按同一个计数器累计
+TEST_F(UsagePolicyTest, LongNamesKeepOneCounter)
+{
+  UsageTracker tracker(path);
+  const std::string name(64, 'n');
+  const UsagePolicy policy;
+  evaluate(tracker, {{name, 100, 0, "2025-04-14 09:00:00"}}, policy, APRIL);
+  evaluate(tracker, {{name, 300, 0, "2025-04-14 09:00:00"}}, policy, APRIL + 60);
+  evaluate(tracker, {}, policy, APRIL + 120);
+  uint64_t bytes = 0;
+  ASSERT_TRUE(tracker.usage(name, bytes));
+  EXPECT_EQ(bytes, 300u);
+}
+
+// 断开未生效时撤销标记，下次评估重新给出断开
+TEST_F(UsagePolicyTest, RetriesUnappliedKick)
+{
+  UsageTracker tracker(path);
+  UsagePolicy policy;
+  policy.monthlyQuotaBytes = 500;
+  const std::vector<Online> online = {{"alice", 400, 200, "2025-04-14 09:00:00"}};
+
+  ASSERT_EQ(evaluate(tracker, online, policy, APRIL).size(), 1u);
+  EXPECT_TRUE(evaluate(tracker, online, policy, APRIL + 60).empty());
+  tracker.unmark("alice", UsageCounter::KICKED);
+  auto decisions = evaluate(tracker, online, policy, APRIL + 120);
+  ASSERT_EQ(decisions.size(), 1u);
+  EXPECT_EQ(decisions[0].action, PolicyAction::Kick);
+
+  // 写入 disable 失败时撤销 DISABLED，下次重新给出 Disable
+  policy.denyOverQuota = true;
+  decisions = evaluate(tracker, online, policy, APRIL + 180);
+  ASSERT_EQ(decisions.size(), 1u);
+  EXPECT_EQ(decisions[0].action, PolicyAction::Disable);
+  tracker.unmark("alice", UsageCounter::DISABLED | UsageCounter::KICKED);
+  decisions = evaluate(tracker, online, policy, APRIL + 240);
+  ASSERT_EQ(decisions.size(), 1u);
+  EXPECT_EQ(decisions[0].action, PolicyAction::Disable);
+}